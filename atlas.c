@@ -0,0 +1,290 @@
+
+#include "atlas.h"
+#include "targa.h"
+#include "endian.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+
+static size_t _Atlas_LevelSize(int width, int height, int level)
+{
+    return (size_t)(width >> level) * (size_t)(height >> level) * 4;
+}
+
+/* averages a 2x2 block weighted by alpha, so transparent texels don't tint the edges of what's left */
+static void _Atlas_Average(const unsigned char* a,
+                           const unsigned char* b,
+                           const unsigned char* c,
+                           const unsigned char* d,
+                           unsigned char* dest)
+{
+    int alpha = a[3] + b[3] + c[3] + d[3];
+    
+    int i;
+    for (i = 0; i < 3; ++i)
+    {
+        if (alpha == 0)
+        {
+            dest[i] = (a[i] + b[i] + c[i] + d[i] + 2) / 4;
+        }
+        else
+        {
+            dest[i] = (a[i] * a[3] + b[i] * b[3] + c[i] * c[3] + d[i] * d[3] + alpha / 2) / alpha;
+        }
+    }
+    
+    dest[3] = (alpha + 2) / 4;
+}
+
+/* copies the edge texels of every tile of a level out across its gutter */
+static void _Atlas_FillGutters(unsigned char* texels, int rows, int width, int cell, int gutter)
+{
+    int tile = cell - gutter * 2;
+    
+    int tx, ty, x, y;
+    for (ty = 0; ty < rows; ++ty)
+    {
+        for (tx = 0; tx < rows; ++tx)
+        {
+            for (y = 0; y < cell; ++y)
+            {
+                int sy = CLAMP(y - gutter, 0, tile - 1) + gutter;
+                
+                for (x = 0; x < cell; ++x)
+                {
+                    if (x >= gutter && x < gutter + tile && y >= gutter && y < gutter + tile) continue;
+                    
+                    int sx = CLAMP(x - gutter, 0, tile - 1) + gutter;
+                    
+                    memcpy(texels + ((ty * cell + y) * width + tx * cell + x) * 4,
+                           texels + ((ty * cell + sy) * width + tx * cell + sx) * 4,
+                           4);
+                }
+            }
+        }
+    }
+}
+
+int Atlas_Bake(const AtlasSource_t* source)
+{
+    tga_image image;
+    if (tga_read(&image, source->imagePath) != TGA_NOERR) return 0;
+    
+    int bytes = image.pixel_depth / 8;
+    int tileSize = image.width / source->rows;
+    
+    /* tiles have to halve evenly down to the last level */
+    if ((bytes != 3 && bytes != 4) ||
+        image.width != image.height ||
+        tileSize * source->rows != image.width ||
+        tileSize < 2 ||
+        (tileSize & (tileSize - 1)) != 0)
+    {
+        tga_free_buffers(&image);
+        return 0;
+    }
+    
+    /* levels go on while the gutter is at least a texel */
+    int levelCount = 0;
+    while ((tileSize >> levelCount) >= 2 && levelCount < ATLAS_MAX_LEVELS) levelCount++;
+    
+    int width = image.width * 2;
+    int height = image.height * 2;
+    
+    size_t size = ATLAS_HEADER_SIZE;
+    unsigned char* levels[ATLAS_MAX_LEVELS];
+    
+    int level;
+    for (level = 0; level < levelCount; ++level)
+    {
+        levels[level] = malloc(_Atlas_LevelSize(width, height, level));
+        assert(levels[level]);
+        size += _Atlas_LevelSize(width, height, level);
+    }
+    
+    /* first level is the image in rgba, keyed texels made transparent, placed inside each cell */
+    int cell = tileSize * 2;
+    int gutter = tileSize / 2;
+    
+    int x, y;
+    for (y = 0; y < image.height; ++y)
+    {
+        for (x = 0; x < image.width; ++x)
+        {
+            const unsigned char* src = image.image_data + (y * image.width + x) * bytes;
+            
+            int dx = (x / tileSize) * cell + gutter + x % tileSize;
+            int dy = (y / tileSize) * cell + gutter + y % tileSize;
+            unsigned char* dest = levels[0] + (dy * width + dx) * 4;
+            
+            /* tga is stored bgr */
+            dest[0] = src[2];
+            dest[1] = src[1];
+            dest[2] = src[0];
+            dest[3] = bytes == 4 ? src[3] : 255;
+            
+            if (source->colorKey == ((dest[0] << 16) | (dest[1] << 8) | dest[2])) dest[3] = 0;
+        }
+    }
+    
+    tga_free_buffers(&image);
+    
+    _Atlas_FillGutters(levels[0], source->rows, width, cell, gutter);
+    
+    /* every later level halves the tiles of the one before, not the padded cells, then pads again */
+    for (level = 1; level < levelCount; ++level)
+    {
+        int levelWidth = width >> level;
+        int prevWidth = width >> (level - 1);
+        int prevCell = cell >> (level - 1);
+        int prevGutter = gutter >> (level - 1);
+        int levelCell = cell >> level;
+        int levelGutter = gutter >> level;
+        int levelTile = tileSize >> level;
+        
+        int tx, ty;
+        for (ty = 0; ty < source->rows; ++ty)
+        {
+            for (tx = 0; tx < source->rows; ++tx)
+            {
+                for (y = 0; y < levelTile; ++y)
+                {
+                    for (x = 0; x < levelTile; ++x)
+                    {
+                        int sx = tx * prevCell + prevGutter + x * 2;
+                        int sy = ty * prevCell + prevGutter + y * 2;
+                        const unsigned char* src = levels[level - 1] + (sy * prevWidth + sx) * 4;
+                        
+                        int dx = tx * levelCell + levelGutter + x;
+                        int dy = ty * levelCell + levelGutter + y;
+                        
+                        _Atlas_Average(src, src + 4, src + prevWidth * 4, src + prevWidth * 4 + 4, levels[level] + (dy * levelWidth + dx) * 4);
+                    }
+                }
+            }
+        }
+        
+        _Atlas_FillGutters(levels[level], source->rows, levelWidth, levelCell, levelGutter);
+    }
+    
+    unsigned char header[ATLAS_HEADER_SIZE];
+    End_U32ToLittle(header, ATLAS_MAGIC);
+    End_U32ToLittle(header + 4, ATLAS_VERSION);
+    End_U32ToLittle(header + 8, source->rows);
+    End_U32ToLittle(header + 12, tileSize);
+    End_U32ToLittle(header + 16, levelCount);
+    End_U32ToLittle(header + 20, width);
+    End_U32ToLittle(header + 24, height);
+    
+    FILE* file = fopen(source->blobPath, "wb");
+    int ok = file != NULL;
+    
+    if (ok) ok = fwrite(header, 1, sizeof(header), file) == sizeof(header);
+    
+    for (level = 0; level < levelCount; ++level)
+    {
+        if (ok) ok = fwrite(levels[level], 1, _Atlas_LevelSize(width, height, level), file) == _Atlas_LevelSize(width, height, level);
+        free(levels[level]);
+    }
+    
+    if (file && fclose(file) != 0) ok = 0;
+    
+    /* a partial blob would only be baked again, don't leave it around */
+    if (!ok) remove(source->blobPath);
+    
+    return ok;
+}
+
+/* maps the blob and checks it's whole and was baked for this source */
+static int _Atlas_Map(Atlas_t* atlas, const AtlasSource_t* source)
+{
+    int fd = open(source->blobPath, O_RDONLY);
+    if (fd < 0) return 0;
+    
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size < ATLAS_HEADER_SIZE)
+    {
+        close(fd);
+        return 0;
+    }
+    
+    void* mapping = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    
+    if (mapping == MAP_FAILED) return 0;
+    
+    const unsigned char* data = mapping;
+    
+    atlas->mapping = mapping;
+    atlas->mappingSize = info.st_size;
+    atlas->rows = End_U32FromLittle(data + 8);
+    atlas->tileSize = End_U32FromLittle(data + 12);
+    atlas->levelCount = End_U32FromLittle(data + 16);
+    atlas->width = End_U32FromLittle(data + 20);
+    atlas->height = End_U32FromLittle(data + 24);
+    
+    int ok = End_U32FromLittle(data) == ATLAS_MAGIC &&
+             End_U32FromLittle(data + 4) == ATLAS_VERSION &&
+             atlas->rows == source->rows &&
+             atlas->levelCount > 0 &&
+             atlas->levelCount <= ATLAS_MAX_LEVELS &&
+             atlas->width == atlas->tileSize * atlas->rows * 2 &&
+             atlas->height == atlas->width;
+    
+    size_t offset = ATLAS_HEADER_SIZE;
+    
+    int level;
+    for (level = 0; ok && level < atlas->levelCount; ++level)
+    {
+        atlas->levels[level] = data + offset;
+        offset += _Atlas_LevelSize(atlas->width, atlas->height, level);
+    }
+    
+    if (!ok || offset != atlas->mappingSize)
+    {
+        Atlas_Unload(atlas);
+        return 0;
+    }
+    
+    return 1;
+}
+
+int Atlas_Load(Atlas_t* atlas, const AtlasSource_t* source)
+{
+    atlas->mapping = NULL;
+    atlas->mappingSize = 0;
+    
+    struct stat imageInfo;
+    struct stat blobInfo;
+    
+    int haveImage = stat(source->imagePath, &imageInfo) == 0;
+    int haveBlob = stat(source->blobPath, &blobInfo) == 0;
+    
+    /* a blob on its own is used as it is */
+    int baked = 0;
+    if (haveImage && (!haveBlob || blobInfo.st_mtime < imageInfo.st_mtime))
+    {
+        if (!Atlas_Bake(source)) return 0;
+        baked = 1;
+    }
+    
+    if (_Atlas_Map(atlas, source)) return 1;
+    
+    /* left over from an older version or cut short, bake it again once */
+    if (haveImage && !baked && Atlas_Bake(source)) return _Atlas_Map(atlas, source);
+    
+    return 0;
+}
+
+void Atlas_Unload(Atlas_t* atlas)
+{
+    if (atlas->mapping) munmap(atlas->mapping, atlas->mappingSize);
+    
+    atlas->mapping = NULL;
+    atlas->mappingSize = 0;
+}
@@ -0,0 +1,71 @@
+
+#ifndef ccraft_atlas_h
+#define ccraft_atlas_h
+
+#include "vec_math.h"
+#include <stddef.h>
+
+/* texture atlases baked into a blob that is uploaded as it is, so startup doesn't decode and swizzle images.
+ every tile is padded with a gutter repeating its edge texels, and each mip level is built tile by tile
+ and padded again, so filtering never pulls in a neighbouring tile at any distance.
+ the blob is baked from the tga the first time it's loaded and again whenever the tga is newer */
+
+#define BLOCK_ATLAS_ROWS 16
+#define ITEM_ATLAS_ROWS 8
+
+/* a tile's cell is twice its size, with a quarter of the cell of gutter on each side.
+ this keeps cells a power of two so each mip level halves every tile exactly */
+#define ATLAS_TILE_SPAN(ROWS) (0.5f / (ROWS))
+
+#define ATLAS_MAGIC 0x534C5441
+#define ATLAS_VERSION 1
+#define ATLAS_MAX_LEVELS 16
+
+/* header is u32 magic, u32 version, u32 rows, u32 tile size, u32 level count, u32 width, u32 height.
+ the levels follow from largest to smallest, rgba texels in rows of width >> level */
+#define ATLAS_HEADER_SIZE (7 * 4)
+
+typedef struct
+{
+    const char* imagePath;
+    const char* blobPath;
+    
+    /* tiles across and down */
+    int rows;
+    
+    /* 0xRRGGBB of texels made transparent, -1 for none */
+    int colorKey;
+} AtlasSource_t;
+
+typedef struct
+{
+    int rows;
+    int tileSize;
+    int levelCount;
+    int width;
+    int height;
+    
+    /* into the mapped blob, valid until Atlas_Unload */
+    const unsigned char* levels[ATLAS_MAX_LEVELS];
+    
+    void* mapping;
+    size_t mappingSize;
+} Atlas_t;
+
+/* returns 0 if the image can't be read or used, or the blob can't be written */
+extern int Atlas_Bake(const AtlasSource_t* source);
+
+/* maps the blob, baking it first if it's missing or out of date. returns 0 if there's no usable atlas */
+extern int Atlas_Load(Atlas_t* atlas, const AtlasSource_t* source);
+extern void Atlas_Unload(Atlas_t* atlas);
+
+/* uv of the corner of a tile, the tile covers ATLAS_TILE_SPAN(rows) from there */
+static inline Vec2_t Atlas_TileUV(int tile, int rows)
+{
+    Vec2_t uv;
+    uv.x = ((float)(tile % rows) + 0.25f) / (float)rows;
+    uv.y = ((float)(tile / rows) + 0.25f) / (float)rows;
+    return uv;
+}
+
+#endif
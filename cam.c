@@ -75,6 +75,13 @@ void Cam_UpdateTransform(Cam_t* camera, short viewWidth, short viewHeight)
     normal = Vec3_Cross(camera->up, aux);
     planes[CAM_RIGHT_PLANE].normal = normal;
     planes[CAM_RIGHT_PLANE].position = aux2;
+    
+    int i;
+    for (i = 0; i < 6; ++i)
+    {
+        Vec3_t n = Vec3_Normalize(planes[i].normal);
+        camera->planeEquations[i] = Vec4_Create(n.x, n.y, n.z, -Vec3_Dot(n, planes[i].position));
+    }
 }
 
 const Mat4_t* Cam_ViewMat(const Cam_t* camera)
@@ -117,3 +124,128 @@ int Cam_PointVisible(const Cam_t* camera, Vec3_t point)
 	return 1;
 }
 
+int Cam_CubeVisible(const Cam_t* camera, Vec3_t center, float halfSize)
+{
+    assert(camera);
+    int i;
+    for (i = 0; i < 6; ++i)
+    {
+        const Vec4_t* plane = camera->planeEquations + i;
+        
+        /* how far the cube reaches toward the plane's inside */
+        float extent = halfSize * (fabsf(plane->x) + fabsf(plane->y) + fabsf(plane->z));
+        
+        if (plane->x * center.x + plane->y * center.y + plane->z * center.z + plane->w < -extent)
+        {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+int Cam_CubeClip(const Cam_t* camera, Vec3_t center, float halfSize, int planeMask)
+{
+    assert(camera);
+    int i;
+    for (i = 0; i < 6; ++i)
+    {
+        if (!(planeMask & (1 << i))) continue;
+        
+        const Vec4_t* plane = camera->planeEquations + i;
+        
+        float extent = halfSize * (fabsf(plane->x) + fabsf(plane->y) + fabsf(plane->z));
+        float distance = plane->x * center.x + plane->y * center.y + plane->z * center.z + plane->w;
+        
+        if (distance < -extent) return -1;
+        
+        /* entirely inside this plane, nothing within the cube needs to test it again */
+        if (distance >= extent) planeMask &= ~(1 << i);
+    }
+    return planeMask;
+}
+
+int Cam_CubesVisible(const Cam_t* camera,
+                     const float* centerX,
+                     const float* centerY,
+                     const float* centerZ,
+                     int count,
+                     float halfSize,
+                     int planeMask,
+                     int* out)
+{
+    assert(camera);
+    
+    /* only the planes being tested, packed to the front, and spread across VEC_LANES cubes */
+    int planes[6];
+    float extents[6];
+    int planeCount = 0;
+    
+    VecLanes_t planeX[6];
+    VecLanes_t planeY[6];
+    VecLanes_t planeZ[6];
+    VecLanes_t planeW[6];
+    VecLanes_t planeExtent[6];
+    
+    int i;
+    for (i = 0; i < 6; ++i)
+    {
+        if (!(planeMask & (1 << i))) continue;
+        
+        const Vec4_t* plane = camera->planeEquations + i;
+        planes[planeCount] = i;
+        extents[planeCount] = -halfSize * (fabsf(plane->x) + fabsf(plane->y) + fabsf(plane->z));
+        
+        planeX[planeCount] = VecLanes_Set(plane->x);
+        planeY[planeCount] = VecLanes_Set(plane->y);
+        planeZ[planeCount] = VecLanes_Set(plane->z);
+        planeW[planeCount] = VecLanes_Set(plane->w);
+        planeExtent[planeCount] = VecLanes_Set(extents[planeCount]);
+        planeCount++;
+    }
+    
+    int visibleCount = 0;
+    
+    int p;
+    for (i = 0; i + VEC_LANES <= count; i += VEC_LANES)
+    {
+        VecLanes_t x = VecLanes_Load(centerX + i);
+        VecLanes_t y = VecLanes_Load(centerY + i);
+        VecLanes_t z = VecLanes_Load(centerZ + i);
+        
+        /* one bit per cube still inside */
+        int inside = (1 << VEC_LANES) - 1;
+        
+        for (p = 0; p < planeCount && inside; ++p)
+        {
+            /* added in the same order as the tail below and Geo_BoxesInsidePlanes */
+            VecLanes_t distance = VecLanes_Add(VecLanes_Add(VecLanes_Add(VecLanes_Mult(planeX[p], x),
+                                                                         VecLanes_Mult(planeY[p], y)),
+                                                            VecLanes_Mult(planeZ[p], z)),
+                                               planeW[p]);
+            
+            inside &= VecLanes_GreaterEqual(distance, planeExtent[p]);
+        }
+        
+        while (inside)
+        {
+            int lane = __builtin_ctz(inside);
+            out[visibleCount++] = i + lane;
+            inside &= inside - 1;
+        }
+    }
+    
+    for (; i < count; ++i)
+    {
+        int inside = 1;
+        
+        for (p = 0; p < planeCount && inside; ++p)
+        {
+            const Vec4_t* plane = camera->planeEquations + planes[p];
+            inside = (plane->x * centerX[i] + plane->y * centerY[i] + plane->z * centerZ[i] + plane->w >= extents[p]);
+        }
+        
+        if (inside) out[visibleCount++] = i;
+    }
+    
+    return visibleCount;
+}
@@ -16,6 +16,8 @@ enum
     CAM_FAR_PLANE = 5,
 };
 
+#define CAM_ALL_PLANES 0x3F
+
 /* basic 3D perspective camera with frustum culling */
 
 typedef struct Cam
@@ -36,6 +38,9 @@ typedef struct Cam
     Mat4_t viewMat;
     Plane_t planes[6];
     
+    /* the same planes as unit normal and distance, inside when n . p + d >= 0 */
+    Vec4_t planeEquations[6];
+    
 } Cam_t;
 
 extern void Cam_Init(Cam_t* cam);
@@ -51,5 +56,21 @@ extern const Mat4_t* Cam_ProjectionMat(const Cam_t* camera);
 /* visiblity testing */
 extern int Cam_SphereVisible(const Cam_t* camera, Sphere_t sphere);
 extern int Cam_PointVisible(const Cam_t* camera, Vec3_t point);
+extern int Cam_CubeVisible(const Cam_t* camera, Vec3_t center, float halfSize);
+
+/* tests a cube against the planes in planeMask, one bit per plane index.
+ returns -1 if it is outside any of them, otherwise the planes it still crosses */
+extern int Cam_CubeClip(const Cam_t* camera, Vec3_t center, float halfSize, int planeMask);
+
+/* batched test of axis aligned cubes with centers stored by axis against the planes in planeMask.
+ writes the indices of visible cubes to out in order and returns how many there are */
+extern int Cam_CubesVisible(const Cam_t* camera,
+                            const float* centerX,
+                            const float* centerY,
+                            const float* centerZ,
+                            int count,
+                            float halfSize,
+                            int planeMask,
+                            int* out);
 
 #endif
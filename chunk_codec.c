@@ -0,0 +1,158 @@
+
+#include "chunk_codec.h"
+#include <string.h>
+
+/* lengths are written 7 bits at a time, low bits first, with the top bit set while more follow */
+static int _ChunkCodec_WriteLength(unsigned char* out, int length)
+{
+    int size = 0;
+    
+    while (length >= 0x80)
+    {
+        out[size++] = (unsigned char)(length | 0x80);
+        length >>= 7;
+    }
+    
+    out[size++] = (unsigned char)length;
+    return size;
+}
+
+static int _ChunkCodec_ReadLength(const unsigned char* data, int size, int* offset, int* length)
+{
+    int value = 0;
+    int shift = 0;
+    
+    while (*offset < size && shift < 21)
+    {
+        unsigned char byte = data[(*offset)++];
+        value |= (byte & 0x7F) << shift;
+        
+        if (!(byte & 0x80))
+        {
+            *length = value;
+            return 1;
+        }
+        
+        shift += 7;
+    }
+    
+    return 0;
+}
+
+int ChunkCodec_Encode(const Block_t blocks[CHUNK_SIZE][CHUNK_SIZE][CHUNK_SIZE], unsigned char* out)
+{
+    /* palette index + 1 of each type, 0 when unused */
+    short paletteIndex[256];
+    memset(paletteIndex, 0, sizeof(paletteIndex));
+    
+    int paletteCount = 0;
+    
+    int x, y, z;
+    for (z = 0; z < CHUNK_SIZE; ++z)
+    {
+        for (x = 0; x < CHUNK_SIZE; ++x)
+        {
+            for (y = 0; y < CHUNK_SIZE; ++y)
+            {
+                unsigned char type = (unsigned char)blocks[x][y][z].type;
+                
+                if (paletteIndex[type] == 0)
+                {
+                    out[1 + paletteCount] = type;
+                    paletteIndex[type] = ++paletteCount;
+                }
+            }
+        }
+    }
+    
+    /* a count of 0 stands for all 256 types */
+    out[0] = (unsigned char)paletteCount;
+    int size = 1 + paletteCount;
+    
+    /* one type fills the chunk */
+    if (paletteCount == 1) return size;
+    
+    int runIndex = -1;
+    int runLength = 0;
+    
+    for (z = 0; z < CHUNK_SIZE; ++z)
+    {
+        for (x = 0; x < CHUNK_SIZE; ++x)
+        {
+            for (y = 0; y < CHUNK_SIZE; ++y)
+            {
+                int index = paletteIndex[(unsigned char)blocks[x][y][z].type] - 1;
+                
+                if (index == runIndex)
+                {
+                    ++runLength;
+                    continue;
+                }
+                
+                if (runLength > 0)
+                {
+                    out[size++] = (unsigned char)runIndex;
+                    size += _ChunkCodec_WriteLength(out + size, runLength - 1);
+                }
+                
+                runIndex = index;
+                runLength = 1;
+            }
+        }
+    }
+    
+    out[size++] = (unsigned char)runIndex;
+    size += _ChunkCodec_WriteLength(out + size, runLength - 1);
+    
+    return size;
+}
+
+int ChunkCodec_Decode(Block_t blocks[CHUNK_SIZE][CHUNK_SIZE][CHUNK_SIZE], const unsigned char* data, int size)
+{
+    if (size < 1) return 0;
+    
+    int paletteCount = data[0] ? data[0] : 256;
+    if (size < 1 + paletteCount) return 0;
+    
+    const unsigned char* palette = data + 1;
+    int offset = 1 + paletteCount;
+    
+    if (paletteCount == 1)
+    {
+        int i;
+        for (i = 0; i < CHUNK_VOLUME; ++i)
+        {
+            (&blocks[0][0][0])[i].type = (char)palette[0];
+        }
+        
+        return offset == size;
+    }
+    
+    /* position in layer order */
+    int written = 0;
+    
+    while (offset < size)
+    {
+        int index = data[offset++];
+        int length;
+        
+        if (index >= paletteCount || !_ChunkCodec_ReadLength(data, size, &offset, &length)) return 0;
+        
+        ++length;
+        if (written + length > CHUNK_VOLUME) return 0;
+        
+        char type = (char)palette[index];
+        
+        while (length-- > 0)
+        {
+            int z = written / (CHUNK_SIZE * CHUNK_SIZE);
+            int x = (written / CHUNK_SIZE) % CHUNK_SIZE;
+            int y = written % CHUNK_SIZE;
+            
+            blocks[x][y][z].type = type;
+            ++written;
+        }
+    }
+    
+    return written == CHUNK_VOLUME;
+}
@@ -0,0 +1,41 @@
+
+#ifndef ccraft_chunk_codec_h
+#define ccraft_chunk_codec_h
+
+#include "world.h"
+#include "net.h"
+
+/* compact encoding of a chunk's blocks for sending over the network.
+ a palette of the types used is followed by runs of palette indices.
+ blocks are visited a horizontal layer at a time since terrain mostly changes with height,
+ so a layer of one type is a single run */
+
+/* largest possible encoding, a palette of every type and a two byte run for every block */
+#define CHUNK_CODEC_MAX_SIZE (1 + 256 + CHUNK_VOLUME * 2)
+
+/* NET_MSG_CHUNK carries one piece of an encoded chunk. u16 x, y, z, u32 revision,
+ u16 encoded size and u16 offset of the piece, then its bytes to the end of the datagram */
+#define CHUNK_FRAGMENT_HEADER (1 + 6 + 4 + 2 + 2)
+#define CHUNK_FRAGMENT_SIZE (NET_MAX_PACKET - CHUNK_FRAGMENT_HEADER)
+#define CHUNK_MAX_FRAGMENTS ((CHUNK_CODEC_MAX_SIZE + CHUNK_FRAGMENT_SIZE - 1) / CHUNK_FRAGMENT_SIZE)
+
+/* NET_MSG_BLOCKS carries changes to chunks the client already has. u8 group count, then for each
+ group u16 x, y, z, u32 revision before the changes and u8 change count, then u16 block index
+ and u8 type per change. each change counts the chunk's revision up by one */
+#define CHUNK_CHANGES_HEADER (1 + 1)
+#define CHUNK_CHANGE_GROUP_HEADER (6 + 4 + 1)
+#define CHUNK_CHANGE_SIZE (2 + 1)
+#define CHUNK_CHANGE_GROUP_MAX 255
+
+/* NET_MSG_CHUNK_ACK tells the server which revisions arrived. u8 count, then u16 x, y, z
+ and u32 revision per chunk */
+#define CHUNK_ACK_HEADER (1 + 1)
+#define CHUNK_ACK_SIZE (6 + 4)
+
+/* writes the encoding to out, which must have room for CHUNK_CODEC_MAX_SIZE bytes, and returns its size */
+extern int ChunkCodec_Encode(const Block_t blocks[CHUNK_SIZE][CHUNK_SIZE][CHUNK_SIZE], unsigned char* out);
+
+/* returns 0 and leaves blocks partly written if the data is corrupt */
+extern int ChunkCodec_Decode(Block_t blocks[CHUNK_SIZE][CHUNK_SIZE][CHUNK_SIZE], const unsigned char* data, int size);
+
+#endif
@@ -0,0 +1,243 @@
+
+#include "chunk_mirror.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <assert.h>
+
+static double _ChunkMirror_Now(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1000.0 + t.tv_nsec / 1000000.0;
+}
+
+void ChunkMirror_Init(ChunkMirror_t* mirror)
+{
+    assert(mirror);
+    assert(CHUNK_MAX_FRAGMENTS <= 32);
+    
+    mirror->chunks = NULL;
+    mirror->chunkCount = 0;
+    mirror->chunkCapacity = 0;
+    
+    Octree_Init(&mirror->chunkTree, CHUNK_SIZE);
+    
+    int i;
+    for (i = 0; i < MIRROR_ASSEMBLIES; ++i)
+    {
+        mirror->assemblies[i].received = 0;
+    }
+    
+    mirror->clock = 0;
+    mirror->ackCount = 0;
+    
+    mirror->chunksReceived = 0;
+    mirror->chunkBytes = 0;
+    mirror->decodeMs = 0.0;
+    mirror->changesApplied = 0;
+    mirror->groupsRejected = 0;
+}
+
+void ChunkMirror_Shutdown(ChunkMirror_t* mirror)
+{
+    free(mirror->chunks);
+    mirror->chunks = NULL;
+    mirror->chunkCount = 0;
+    mirror->chunkCapacity = 0;
+    
+    Octree_Shutdown(&mirror->chunkTree);
+}
+
+MirrorChunk_t* ChunkMirror_Find(ChunkMirror_t* mirror, int x, int y, int z)
+{
+    int index = Octree_Find(&mirror->chunkTree, x, y, z);
+    return index == -1 ? NULL : mirror->chunks + index;
+}
+
+static MirrorChunk_t* _ChunkMirror_Add(ChunkMirror_t* mirror, int x, int y, int z)
+{
+    if (mirror->chunkCount == mirror->chunkCapacity)
+    {
+        mirror->chunkCapacity = mirror->chunkCapacity ? mirror->chunkCapacity * 2 : 64;
+        mirror->chunks = realloc(mirror->chunks, sizeof(MirrorChunk_t) * mirror->chunkCapacity);
+        assert(mirror->chunks);
+    }
+    
+    MirrorChunk_t* chunk = mirror->chunks + mirror->chunkCount;
+    chunk->x = x;
+    chunk->y = y;
+    chunk->z = z;
+    chunk->revision = 0;
+    
+    Octree_Insert(&mirror->chunkTree, x, y, z, mirror->chunkCount);
+    mirror->chunkCount++;
+    
+    return chunk;
+}
+
+static void _ChunkMirror_QueueAck(ChunkMirror_t* mirror, const MirrorChunk_t* chunk)
+{
+    int index = (int)(chunk - mirror->chunks);
+    
+    int i;
+    for (i = 0; i < mirror->ackCount; ++i)
+    {
+        if (mirror->acks[i] == index) return;
+    }
+    
+    /* a dropped ack only costs a resend */
+    if (mirror->ackCount < MIRROR_MAX_ACKS) mirror->acks[mirror->ackCount++] = index;
+}
+
+static ChunkAssembly_t* _ChunkMirror_Assembly(ChunkMirror_t* mirror, int x, int y, int z, uint32_t revision, int size)
+{
+    ChunkAssembly_t* oldest = mirror->assemblies;
+    
+    int i;
+    for (i = 0; i < MIRROR_ASSEMBLIES; ++i)
+    {
+        ChunkAssembly_t* assembly = mirror->assemblies + i;
+        
+        if (assembly->received &&
+            assembly->x == x && assembly->y == y && assembly->z == z &&
+            assembly->revision == revision && assembly->size == size)
+        {
+            return assembly;
+        }
+        
+        if (!assembly->received) oldest = assembly;
+        else if (oldest->received && assembly->lastUsed < oldest->lastUsed) oldest = assembly;
+    }
+    
+    oldest->x = x;
+    oldest->y = y;
+    oldest->z = z;
+    oldest->revision = revision;
+    oldest->size = size;
+    oldest->received = 0;
+    
+    return oldest;
+}
+
+void ChunkMirror_ReadChunk(ChunkMirror_t* mirror, NetReader_t* reader)
+{
+    int x = NetReader_U16(reader);
+    int y = NetReader_U16(reader);
+    int z = NetReader_U16(reader);
+    uint32_t revision = NetReader_U32(reader);
+    int size = NetReader_U16(reader);
+    int offset = NetReader_U16(reader);
+    
+    int length = reader->size - reader->offset;
+    
+    if (reader->overflow || size <= 0 || size > CHUNK_CODEC_MAX_SIZE || offset % CHUNK_FRAGMENT_SIZE != 0 ||
+        offset + length > size || (length != CHUNK_FRAGMENT_SIZE && offset + length != size))
+    {
+        return;
+    }
+    
+    MirrorChunk_t* chunk = ChunkMirror_Find(mirror, x, y, z);
+    
+    /* already have it, the ack must have been lost */
+    if (chunk && chunk->revision >= revision)
+    {
+        _ChunkMirror_QueueAck(mirror, chunk);
+        return;
+    }
+    
+    ChunkAssembly_t* assembly = _ChunkMirror_Assembly(mirror, x, y, z, revision, size);
+    
+    NetReader_Bytes(reader, assembly->data + offset, length);
+    assembly->received |= 1u << (offset / CHUNK_FRAGMENT_SIZE);
+    assembly->lastUsed = ++mirror->clock;
+    
+    int fragments = (size + CHUNK_FRAGMENT_SIZE - 1) / CHUNK_FRAGMENT_SIZE;
+    if (assembly->received != (1u << fragments) - 1) return;
+    
+    assembly->received = 0;
+    
+    /* decode aside so a corrupt chunk doesn't wreck the copy that's there */
+    static Block_t blocks[CHUNK_SIZE][CHUNK_SIZE][CHUNK_SIZE];
+    
+    double start = _ChunkMirror_Now();
+    int ok = ChunkCodec_Decode(blocks, assembly->data, size);
+    mirror->decodeMs += _ChunkMirror_Now() - start;
+    
+    if (!ok) return;
+    
+    if (!chunk) chunk = _ChunkMirror_Add(mirror, x, y, z);
+    
+    memcpy(chunk->blocks, blocks, sizeof(blocks));
+    chunk->revision = revision;
+    
+    mirror->chunksReceived++;
+    mirror->chunkBytes += size;
+    
+    _ChunkMirror_QueueAck(mirror, chunk);
+}
+
+void ChunkMirror_ReadBlocks(ChunkMirror_t* mirror, NetReader_t* reader)
+{
+    int groupCount = NetReader_U8(reader);
+    
+    int g;
+    for (g = 0; g < groupCount; ++g)
+    {
+        int x = NetReader_U16(reader);
+        int y = NetReader_U16(reader);
+        int z = NetReader_U16(reader);
+        uint32_t revision = NetReader_U32(reader);
+        int count = NetReader_U8(reader);
+        
+        if (reader->overflow) return;
+        
+        MirrorChunk_t* chunk = ChunkMirror_Find(mirror, x, y, z);
+        
+        /* changes only apply on top of the revision they were made to */
+        int apply = chunk && chunk->revision == revision;
+        if (!apply) mirror->groupsRejected++;
+        
+        int i;
+        for (i = 0; i < count; ++i)
+        {
+            int index = NetReader_U16(reader);
+            char type = (char)NetReader_U8(reader);
+            
+            if (apply && !reader->overflow && index < CHUNK_VOLUME)
+            {
+                (&chunk->blocks[0][0][0])[index].type = type;
+            }
+        }
+        
+        if (apply && !reader->overflow)
+        {
+            chunk->revision = revision + count;
+            mirror->changesApplied += count;
+            _ChunkMirror_QueueAck(mirror, chunk);
+        }
+    }
+}
+
+int ChunkMirror_WriteAcks(ChunkMirror_t* mirror, NetWriter_t* writer)
+{
+    if (mirror->ackCount == 0) return 0;
+    
+    NetWriter_U8(writer, NET_MSG_CHUNK_ACK);
+    NetWriter_U8(writer, (uint8_t)mirror->ackCount);
+    
+    int i;
+    for (i = 0; i < mirror->ackCount; ++i)
+    {
+        const MirrorChunk_t* chunk = mirror->chunks + mirror->acks[i];
+        
+        NetWriter_U16(writer, (uint16_t)chunk->x);
+        NetWriter_U16(writer, (uint16_t)chunk->y);
+        NetWriter_U16(writer, (uint16_t)chunk->z);
+        NetWriter_U32(writer, chunk->revision);
+    }
+    
+    mirror->ackCount = 0;
+    
+    return 1;
+}
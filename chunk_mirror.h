@@ -0,0 +1,82 @@
+
+#ifndef ccraft_chunk_mirror_h
+#define ccraft_chunk_mirror_h
+
+#include "chunk_codec.h"
+#include "octree.h"
+
+/* a client's copy of the blocks a server has sent it.
+ chunks arrive in pieces (see chunk_codec.h) and are kept up to date by batches of block changes.
+ every chunk and batch that lands is acknowledged so the server knows what to resend */
+
+typedef struct
+{
+    int x;
+    int y;
+    int z;
+    uint32_t revision;
+    
+    Block_t blocks[CHUNK_SIZE][CHUNK_SIZE][CHUNK_SIZE];
+} MirrorChunk_t;
+
+/* an encoded chunk that is still arriving */
+typedef struct
+{
+    int x;
+    int y;
+    int z;
+    uint32_t revision;
+    int size;
+    
+    /* a bit for each fragment received, 0 when the slot is free */
+    unsigned int received;
+    unsigned int lastUsed;
+    
+    unsigned char data[CHUNK_CODEC_MAX_SIZE];
+} ChunkAssembly_t;
+
+/* chunks that can be arriving at once, the least recently added to is dropped for a new one */
+#define MIRROR_ASSEMBLIES 8
+
+#define MIRROR_MAX_ACKS ((NET_MAX_PACKET - CHUNK_ACK_HEADER) / CHUNK_ACK_SIZE)
+
+typedef struct
+{
+    MirrorChunk_t* chunks;
+    int chunkCount;
+    int chunkCapacity;
+    
+    /* values are indices into chunks */
+    Octree_t chunkTree;
+    
+    ChunkAssembly_t assemblies[MIRROR_ASSEMBLIES];
+    unsigned int clock;
+    
+    /* chunks whose revision still has to be acknowledged */
+    int acks[MIRROR_MAX_ACKS];
+    int ackCount;
+    
+    int chunksReceived;
+    uint64_t chunkBytes;
+    double decodeMs;
+    int changesApplied;
+    
+    /* change batches that didn't start from the revision the client has, the server resends the chunk */
+    int groupsRejected;
+} ChunkMirror_t;
+
+extern void ChunkMirror_Init(ChunkMirror_t* mirror);
+extern void ChunkMirror_Shutdown(ChunkMirror_t* mirror);
+
+/* NULL if the chunk hasn't arrived */
+extern MirrorChunk_t* ChunkMirror_Find(ChunkMirror_t* mirror, int x, int y, int z);
+
+/* read the rest of a NET_MSG_CHUNK or NET_MSG_BLOCKS after the type */
+extern void ChunkMirror_ReadChunk(ChunkMirror_t* mirror, NetReader_t* reader);
+extern void ChunkMirror_ReadBlocks(ChunkMirror_t* mirror, NetReader_t* reader);
+
+/* writes a NET_MSG_CHUNK_ACK for everything that arrived since the last call.
+ returns 0 and writes nothing if there is nothing to acknowledge */
+extern int ChunkMirror_WriteAcks(ChunkMirror_t* mirror, NetWriter_t* writer);
+
+#endif
@@ -0,0 +1,303 @@
+
+#include "digest.h"
+#include "endian.h"
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#define DIGEST_PRIME1 11400714785092573143ULL
+#define DIGEST_PRIME2 14029467366897019727ULL
+#define DIGEST_PRIME3 1609587929392839161ULL
+#define DIGEST_PRIME4 9650029242287828579ULL
+#define DIGEST_PRIME5 2870177450012600261ULL
+
+/* seeds so a chunk and an entity with the same bytes don't hash the same */
+enum
+{
+    DIGEST_SEED_CHUNK = 1,
+    DIGEST_SEED_ENTITY,
+    DIGEST_SEED_PLAYER,
+    DIGEST_SEED_ROOT,
+};
+
+static inline uint64_t _Digest_Rotate(uint64_t value, int bits)
+{
+    return (value << bits) | (value >> (64 - bits));
+}
+
+static inline uint64_t _Digest_Round(uint64_t acc, uint64_t input)
+{
+    acc += input * DIGEST_PRIME2;
+    acc = _Digest_Rotate(acc, 31);
+    return acc * DIGEST_PRIME1;
+}
+
+static inline uint64_t _Digest_Merge(uint64_t acc, uint64_t value)
+{
+    acc ^= _Digest_Round(0, value);
+    return acc * DIGEST_PRIME1 + DIGEST_PRIME4;
+}
+
+uint64_t Digest_Bytes(const void* data, size_t size, uint64_t seed)
+{
+    const unsigned char* bytes = data;
+    const unsigned char* end = bytes + size;
+    
+    uint64_t hash;
+    
+    if (size >= 32)
+    {
+        /* four lanes over 32 byte stripes */
+        uint64_t v1 = seed + DIGEST_PRIME1 + DIGEST_PRIME2;
+        uint64_t v2 = seed + DIGEST_PRIME2;
+        uint64_t v3 = seed;
+        uint64_t v4 = seed - DIGEST_PRIME1;
+        
+        while (end - bytes >= 32)
+        {
+            v1 = _Digest_Round(v1, End_U64FromLittle(bytes));
+            v2 = _Digest_Round(v2, End_U64FromLittle(bytes + 8));
+            v3 = _Digest_Round(v3, End_U64FromLittle(bytes + 16));
+            v4 = _Digest_Round(v4, End_U64FromLittle(bytes + 24));
+            bytes += 32;
+        }
+        
+        hash = _Digest_Rotate(v1, 1) + _Digest_Rotate(v2, 7) + _Digest_Rotate(v3, 12) + _Digest_Rotate(v4, 18);
+        hash = _Digest_Merge(hash, v1);
+        hash = _Digest_Merge(hash, v2);
+        hash = _Digest_Merge(hash, v3);
+        hash = _Digest_Merge(hash, v4);
+    }
+    else
+    {
+        hash = seed + DIGEST_PRIME5;
+    }
+    
+    hash += size;
+    
+    while (end - bytes >= 8)
+    {
+        hash ^= _Digest_Round(0, End_U64FromLittle(bytes));
+        hash = _Digest_Rotate(hash, 27) * DIGEST_PRIME1 + DIGEST_PRIME4;
+        bytes += 8;
+    }
+    
+    if (end - bytes >= 4)
+    {
+        hash ^= (uint64_t)End_U32FromLittle(bytes) * DIGEST_PRIME1;
+        hash = _Digest_Rotate(hash, 23) * DIGEST_PRIME2 + DIGEST_PRIME3;
+        bytes += 4;
+    }
+    
+    while (bytes < end)
+    {
+        hash ^= *bytes * DIGEST_PRIME5;
+        hash = _Digest_Rotate(hash, 11) * DIGEST_PRIME1;
+        bytes++;
+    }
+    
+    /* avalanche */
+    hash ^= hash >> 33;
+    hash *= DIGEST_PRIME2;
+    hash ^= hash >> 29;
+    hash *= DIGEST_PRIME3;
+    hash ^= hash >> 32;
+    
+    return hash;
+}
+
+uint64_t Digest_Chunk(Chunk_t* chunk)
+{
+    if (chunk->digestRevision == chunk->revision) return chunk->digest;
+    
+    /* blocks are one byte each so the array hashes as it is */
+    uint64_t hash = Digest_Bytes(chunk->blocks, sizeof(chunk->blocks), DIGEST_SEED_CHUNK);
+    
+    unsigned char position[12];
+    End_I32ToLittle(position, chunk->x);
+    End_I32ToLittle(position + 4, chunk->y);
+    End_I32ToLittle(position + 8, chunk->z);
+    
+    chunk->digest = Digest_Bytes(position, sizeof(position), hash);
+    chunk->digestRevision = chunk->revision;
+    
+    return chunk->digest;
+}
+
+uint64_t Digest_Entity(const EntityStore_t* store, int slot)
+{
+    int id = store->id[slot];
+    
+    unsigned char data[48];
+    End_I32ToLittle(data, id);
+    End_I32ToLittle(data + 4, store->generation[id]);
+    End_I32ToLittle(data + 8, store->type[slot]);
+    End_I32ToLittle(data + 12, store->pickupType[slot]);
+    End_I32ToLittle(data + 16, store->qty[slot]);
+    End_F32ToLittle(data + 20, store->x[slot]);
+    End_F32ToLittle(data + 24, store->y[slot]);
+    End_F32ToLittle(data + 28, store->z[slot]);
+    End_F32ToLittle(data + 32, store->vx[slot]);
+    End_F32ToLittle(data + 36, store->vy[slot]);
+    End_F32ToLittle(data + 40, store->vz[slot]);
+    End_F32ToLittle(data + 44, store->airborne[slot]);
+    
+    return Digest_Bytes(data, sizeof(data), DIGEST_SEED_ENTITY);
+}
+
+static uint64_t _Digest_Inventory(const Inventory_t* inventory, uint64_t seed)
+{
+    int count = inventory->width * inventory->height;
+    
+    static unsigned char* data = NULL;
+    static int capacity = 0;
+    
+    if (count * 8 + 4 > capacity)
+    {
+        capacity = count * 8 + 4;
+        data = realloc(data, capacity);
+        assert(data);
+    }
+    
+    End_I32ToLittle(data, inventory->selectedItem);
+    
+    int i;
+    for (i = 0; i < count; ++i)
+    {
+        End_I32ToLittle(data + 4 + i * 8, inventory->items[i].type);
+        End_I32ToLittle(data + 8 + i * 8, inventory->items[i].qty);
+    }
+    
+    return Digest_Bytes(data, count * 8 + 4, seed);
+}
+
+uint64_t Digest_Player(const Player_t* player)
+{
+    unsigned char data[36];
+    End_F32ToLittle(data, player->position.x);
+    End_F32ToLittle(data + 4, player->position.y);
+    End_F32ToLittle(data + 8, player->position.z);
+    End_F32ToLittle(data + 12, player->velocity.x);
+    End_F32ToLittle(data + 16, player->velocity.y);
+    End_F32ToLittle(data + 20, player->velocity.z);
+    End_F32ToLittle(data + 24, player->pitch);
+    End_F32ToLittle(data + 28, player->yaw);
+    End_I32ToLittle(data + 32, player->onGround);
+    
+    uint64_t hash = Digest_Bytes(data, sizeof(data), DIGEST_SEED_PLAYER);
+    hash = _Digest_Inventory(&player->belt, hash);
+    return _Digest_Inventory(&player->pack, hash);
+}
+
+void Digest_Sim(Digest_t* digest, Sim_t* sim, Player_t* const* players, int playerCount)
+{
+    World_t* world = &sim->world;
+    const EntityStore_t* store = &world->entities;
+    
+    digest->chunks = 0;
+    digest->entities = 0;
+    digest->players = 0;
+    
+    int i;
+    for (i = 0; i < world->chunkCount; ++i)
+    {
+        digest->chunks += Digest_Chunk(world->chunks + i);
+    }
+    
+    for (i = 0; i < store->count; ++i)
+    {
+        digest->entities += Digest_Entity(store, i);
+    }
+    
+    /* players keep their order, a player swapping places with another is a difference */
+    for (i = 0; i < playerCount; ++i)
+    {
+        unsigned char data[8];
+        End_U64ToLittle(data, digest->players);
+        digest->players = Digest_Bytes(data, sizeof(data), Digest_Player(players[i]));
+    }
+    
+    digest->chunkCount = world->chunkCount;
+    digest->entityCount = store->count;
+    
+    unsigned char data[32];
+    End_U64ToLittle(data, digest->chunks);
+    End_U64ToLittle(data + 8, digest->entities);
+    End_U64ToLittle(data + 16, digest->players);
+    End_I32ToLittle(data + 24, digest->chunkCount);
+    End_I32ToLittle(data + 28, digest->entityCount);
+    
+    digest->root = Digest_Bytes(data, sizeof(data), DIGEST_SEED_ROOT);
+}
+
+static int _Digest_CompareChunks(const void* a, const void* b)
+{
+    const Chunk_t* chunkA = *(Chunk_t* const*)a;
+    const Chunk_t* chunkB = *(Chunk_t* const*)b;
+    
+    if (chunkA->x != chunkB->x) return chunkA->x < chunkB->x ? -1 : 1;
+    if (chunkA->y != chunkB->y) return chunkA->y < chunkB->y ? -1 : 1;
+    if (chunkA->z != chunkB->z) return chunkA->z < chunkB->z ? -1 : 1;
+    return 0;
+}
+
+/* one leaf per line:
+ root <hash>
+ chunk <x> <y> <z> <hash>
+ entity <id> <generation> <type> <x> <y> <z> <hash>
+ player <index> <x> <y> <z> <hash> */
+void Digest_Write(FILE* file, Sim_t* sim, Player_t* const* players, int playerCount)
+{
+    World_t* world = &sim->world;
+    const EntityStore_t* store = &world->entities;
+    
+    Digest_t digest;
+    Digest_Sim(&digest, sim, players, playerCount);
+    
+    fprintf(file, "root %016llx\n", (unsigned long long)digest.root);
+    
+    Chunk_t** chunks = malloc(sizeof(Chunk_t*) * (world->chunkCount > 0 ? world->chunkCount : 1));
+    assert(chunks);
+    
+    int i;
+    for (i = 0; i < world->chunkCount; ++i)
+    {
+        chunks[i] = world->chunks + i;
+    }
+    
+    qsort(chunks, world->chunkCount, sizeof(Chunk_t*), _Digest_CompareChunks);
+    
+    for (i = 0; i < world->chunkCount; ++i)
+    {
+        fprintf(file, "chunk %i %i %i %016llx\n", chunks[i]->x, chunks[i]->y, chunks[i]->z, (unsigned long long)Digest_Chunk(chunks[i]));
+    }
+    
+    free(chunks);
+    
+    /* in id order, slots depend on the order entities were removed in */
+    int id;
+    for (id = 0; id < store->capacity; ++id)
+    {
+        int slot = store->slot[id];
+        if (slot < 0 || slot >= store->count || store->id[slot] != id) continue;
+        
+        fprintf(file, "entity %i %i %i %.9g %.9g %.9g %016llx\n",
+                id,
+                store->generation[id],
+                store->type[slot],
+                store->x[slot],
+                store->y[slot],
+                store->z[slot],
+                (unsigned long long)Digest_Entity(store, slot));
+    }
+    
+    for (i = 0; i < playerCount; ++i)
+    {
+        fprintf(file, "player %i %.9g %.9g %.9g %016llx\n",
+                i,
+                players[i]->position.x,
+                players[i]->position.y,
+                players[i]->position.z,
+                (unsigned long long)Digest_Player(players[i]));
+    }
+}
@@ -0,0 +1,41 @@
+
+#ifndef ccraft_digest_h
+#define ccraft_digest_h
+
+#include <stdio.h>
+#include <stdint.h>
+#include "sim.h"
+
+/* hashes of the simulation's state, to check that a change to the code left its results alone.
+ every chunk, entity and player gets its own hash and those are combined into one root.
+ chunk hashes are kept until the chunk's revision changes, so only chunks that changed are rehashed.
+ leaves are summed rather than chained so the order chunks were loaded or entities stored in doesn't matter */
+
+typedef struct
+{
+    uint64_t chunks;
+    uint64_t entities;
+    uint64_t players;
+    
+    /* all of the above */
+    uint64_t root;
+    
+    int chunkCount;
+    int entityCount;
+} Digest_t;
+
+/* 64 bit hash in the manner of xxhash, reads the bytes as little endian so it's the same on any platform */
+extern uint64_t Digest_Bytes(const void* data, size_t size, uint64_t seed);
+
+/* hash of a chunk's blocks and coordinates, computed again only if its revision changed */
+extern uint64_t Digest_Chunk(Chunk_t* chunk);
+
+extern uint64_t Digest_Entity(const EntityStore_t* store, int slot);
+extern uint64_t Digest_Player(const Player_t* player);
+
+extern void Digest_Sim(Digest_t* digest, Sim_t* sim, Player_t* const* players, int playerCount);
+
+/* writes every leaf as text, chunks and entities in a fixed order, for ccraft_diff to compare */
+extern void Digest_Write(FILE* file, Sim_t* sim, Player_t* const* players, int playerCount);
+
+#endif
@@ -0,0 +1,184 @@
+
+#include "entity.h"
+#include <stdlib.h>
+
+void EntityStore_Init(EntityStore_t* store, int capacity)
+{
+    store->capacity = capacity;
+    store->count = 0;
+    
+    store->x = malloc(sizeof(float) * capacity);
+    store->y = malloc(sizeof(float) * capacity);
+    store->z = malloc(sizeof(float) * capacity);
+    store->vx = malloc(sizeof(float) * capacity);
+    store->vy = malloc(sizeof(float) * capacity);
+    store->vz = malloc(sizeof(float) * capacity);
+    store->size = malloc(sizeof(float) * capacity);
+    store->height = malloc(sizeof(float) * capacity);
+    store->airborne = malloc(sizeof(float) * capacity);
+    
+    store->type = malloc(sizeof(int) * capacity);
+    store->pickupType = malloc(sizeof(int) * capacity);
+    store->qty = malloc(sizeof(int) * capacity);
+    store->id = malloc(sizeof(int) * capacity);
+    
+    store->slot = malloc(sizeof(int) * capacity);
+    store->generation = calloc(capacity, sizeof(unsigned char));
+    store->freeIds = malloc(sizeof(int) * capacity);
+    
+    assert(store->x && store->y && store->z);
+    assert(store->vx && store->vy && store->vz);
+    assert(store->size && store->height && store->airborne);
+    assert(store->type && store->pickupType && store->qty && store->id);
+    assert(store->slot && store->generation && store->freeIds);
+    
+    /* hand out low ids first */
+    int i;
+    for (i = 0; i < capacity; ++i)
+    {
+        store->slot[i] = -1;
+        store->freeIds[i] = capacity - 1 - i;
+    }
+    store->freeCount = capacity;
+}
+
+void EntityStore_Shutdown(EntityStore_t* store)
+{
+    free(store->x);
+    free(store->y);
+    free(store->z);
+    free(store->vx);
+    free(store->vy);
+    free(store->vz);
+    free(store->size);
+    free(store->height);
+    free(store->airborne);
+    
+    free(store->type);
+    free(store->pickupType);
+    free(store->qty);
+    free(store->id);
+    
+    free(store->slot);
+    free(store->generation);
+    free(store->freeIds);
+    
+    store->count = 0;
+    store->capacity = 0;
+    store->freeCount = 0;
+}
+
+int EntityStore_Spawn(EntityStore_t* store, int type)
+{
+    if (store->freeCount == 0)
+    {
+        return -1;
+    }
+    
+    int id = store->freeIds[--store->freeCount];
+    int s = store->count++;
+    
+    store->slot[id] = s;
+    store->id[s] = id;
+    store->generation[id]++;
+    
+    store->x[s] = 0.0f;
+    store->y[s] = 0.0f;
+    store->z[s] = 0.0f;
+    store->vx[s] = 0.0f;
+    store->vy[s] = 0.0f;
+    store->vz[s] = 0.0f;
+    store->size[s] = 0.0f;
+    store->height[s] = 0.0f;
+    store->airborne[s] = 1.0f;
+    
+    store->type[s] = type;
+    store->pickupType[s] = 0;
+    store->qty[s] = 0;
+    
+    return id;
+}
+
+void EntityStore_Remove(EntityStore_t* store, int id)
+{
+    int s = store->slot[id];
+    assert(s >= 0);
+    
+    int last = --store->count;
+    
+    if (s != last)
+    {
+        store->x[s] = store->x[last];
+        store->y[s] = store->y[last];
+        store->z[s] = store->z[last];
+        store->vx[s] = store->vx[last];
+        store->vy[s] = store->vy[last];
+        store->vz[s] = store->vz[last];
+        store->size[s] = store->size[last];
+        store->height[s] = store->height[last];
+        store->airborne[s] = store->airborne[last];
+        
+        store->type[s] = store->type[last];
+        store->pickupType[s] = store->pickupType[last];
+        store->qty[s] = store->qty[last];
+        store->id[s] = store->id[last];
+        
+        store->slot[store->id[s]] = s;
+    }
+    
+    store->slot[id] = -1;
+    store->freeIds[store->freeCount++] = id;
+}
+
+/* restrict parameters let the compiler vectorize the loop without alias checks */
+static void _EntityStore_Integrate(float* restrict x,
+                                   float* restrict y,
+                                   float* restrict z,
+                                   float* restrict vx,
+                                   float* restrict vy,
+                                   float* restrict vz,
+                                   const float* restrict airborne,
+                                   float gx,
+                                   float gy,
+                                   float gz,
+                                   int n)
+{
+    int i;
+    for (i = 0; i < n; ++i)
+    {
+        vx[i] = (vx[i] + gx) * airborne[i];
+        vy[i] = (vy[i] + gy) * airborne[i];
+        vz[i] = (vz[i] + gz) * airborne[i];
+        
+        x[i] += vx[i];
+        y[i] += vy[i];
+        z[i] += vz[i];
+    }
+}
+
+void EntityStore_Integrate(EntityStore_t* store, int begin, int end, Vec3_t gravity)
+{
+    assert(begin >= 0 && end <= store->count);
+    
+    _EntityStore_Integrate(store->x + begin, store->y + begin, store->z + begin,
+                           store->vx + begin, store->vy + begin, store->vz + begin,
+                           store->airborne + begin,
+                           gravity.x, gravity.y, gravity.z,
+                           end - begin);
+}
+
+void EntityCommandBuffer_Init(EntityCommandBuffer_t* buffer, int capacity)
+{
+    buffer->commands = malloc(sizeof(EntityCommand_t) * capacity);
+    buffer->count = 0;
+    buffer->capacity = capacity;
+    assert(buffer->commands);
+}
+
+void EntityCommandBuffer_Shutdown(EntityCommandBuffer_t* buffer)
+{
+    free(buffer->commands);
+    buffer->commands = NULL;
+    buffer->count = 0;
+    buffer->capacity = 0;
+}
@@ -0,0 +1,114 @@
+
+#ifndef ccraft_entity_h
+#define ccraft_entity_h
+
+#include "vec_math.h"
+#include <assert.h>
+
+enum
+{
+    ENTITY_CHEST = 0,
+    ENTITY_STONE,
+    ENTITY_DIRT,
+    ENTITY_TURF,
+    ENTITY_GIFT,
+};
+
+/* entities are stored as a structure of arrays.
+ live entities are packed into slots [0, count) so updates only touch live data.
+ ids are stable handles, an entity's slot changes when another is removed */
+typedef struct
+{
+    int capacity;
+    int count;
+    
+    /* dense - indexed by slot */
+    float* x;
+    float* y;
+    float* z;
+    float* vx;
+    float* vy;
+    float* vz;
+    float* size;
+    float* height;
+    
+    /* 1.0 if the entity is falling, 0.0 if it is resting on a block */
+    float* airborne;
+    
+    int* type;
+    int* pickupType;
+    int* qty;
+    int* id;
+    
+    /* sparse - indexed by id */
+    int* slot;
+    
+    /* counts up each time an id is handed out, tells a reused id from the entity that had it before */
+    unsigned char* generation;
+    
+    int* freeIds;
+    int freeCount;
+    
+} EntityStore_t;
+
+extern void EntityStore_Init(EntityStore_t* store, int capacity);
+extern void EntityStore_Shutdown(EntityStore_t* store);
+
+/* returns the new entity's id or -1 if the store is full */
+extern int EntityStore_Spawn(EntityStore_t* store, int type);
+
+/* swaps the last live entity into the removed slot */
+extern void EntityStore_Remove(EntityStore_t* store, int id);
+
+/* applies gravity to airborne entities in slots [begin, end), stops resting ones and moves them */
+extern void EntityStore_Integrate(EntityStore_t* store, int begin, int end, Vec3_t gravity);
+
+/* side effects produced while entities are simulated in parallel.
+ they are applied afterwards in a fixed order so results don't depend on threading */
+enum
+{
+    ENTITY_CMD_REMOVE = 0,
+};
+
+typedef struct
+{
+    int type;
+    int id;
+} EntityCommand_t;
+
+typedef struct
+{
+    EntityCommand_t* commands;
+    int count;
+    int capacity;
+} EntityCommandBuffer_t;
+
+extern void EntityCommandBuffer_Init(EntityCommandBuffer_t* buffer, int capacity);
+extern void EntityCommandBuffer_Shutdown(EntityCommandBuffer_t* buffer);
+
+static inline void EntityCommandBuffer_Push(EntityCommandBuffer_t* buffer, int type, int id)
+{
+    assert(buffer->count < buffer->capacity);
+    buffer->commands[buffer->count].type = type;
+    buffer->commands[buffer->count].id = id;
+    ++buffer->count;
+}
+
+static inline int EntityStore_Slot(const EntityStore_t* store, int id)
+{
+    return store->slot[id];
+}
+
+static inline Vec3_t EntityStore_Position(const EntityStore_t* store, int slot)
+{
+    return Vec3_Create(store->x[slot], store->y[slot], store->z[slot]);
+}
+
+static inline void EntityStore_SetPosition(EntityStore_t* store, int slot, Vec3_t position)
+{
+    store->x[slot] = position.x;
+    store->y[slot] = position.y;
+    store->z[slot] = position.z;
+}
+
+#endif
@@ -7,44 +7,25 @@
 #include "cam.h"
 #include "inventory.h"
 #include "state.h"
-
-typedef struct
-{
-    Vec3_t position;
-    float pitch;
-    float yaw;
-    Vec3_t velocity;
-    int onGround;
-    
-    float radius;
-    float height;
-    
-    int groundBlockType;
-    
-    Inventory_t belt;
-    Inventory_t pack;
-} Player_t;
-
-extern void Player_Init(Player_t* player);
-extern void Player_Pickup(Player_t* player, int itemType, int qty);
+#include "grid.h"
+#include "job.h"
+#include "visibility.h"
+#include "sim.h"
+#include "replay.h"
+#include "hud.h"
 
 typedef struct
 {
     Renderer_t renderer;
     Cam_t cam;
     State_t state;
+    Hud_t hud;
     
+    Sim_t sim;
     Player_t player;
-    Vec3_t gravity;
-    Vec3_t entityGravity;
-
-    World_t world;
     
-    int forward;
-    int side;
-    int jumping;
-    int digging;
-    int placing;
+    /* filled in from devices each frame, pitch and yaw are taken from the player */
+    PlayerInput_t input;
     
     Block_t* selectedBlock;
     
@@ -52,17 +33,22 @@ typedef struct
     
     int loadDist;
     
-    int cx;
-    int cy;
-    int cz;
+    /* saves the world on quit, off while recording or replaying so every replay starts from the same save */
+    int persistent;
     
 } Game_t;
 
 extern void Game_Init(Game_t* game);
 
+/* everything but the renderer, for replaying without a window */
+extern void Game_InitHeadless(Game_t* game);
+
 extern void Game_Render(Game_t* game);
 extern void Game_Update(Game_t* game);
 
+/* applies one tick of device input, recorded or live, ahead of Game_Update */
+extern void Game_ApplyInput(Game_t* game, const ReplayTick_t* tick);
+
 extern void Game_MoveCamera(Game_t* game, float deltaX, float deltaY);
 extern void Game_SetCursor(Game_t* game, float x, float y);
 
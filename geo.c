@@ -64,3 +64,133 @@ Vec3_t Geo_BlendBarcentric(Vec3_t p1,
     
     return ret;
 }
+
+/* how far inside the plane the box reaches at most, negative if it is entirely outside */
+static inline float _Geo_BoxPlaneReach(const Vec4_t* plane, Vec3_t center, Vec3_t half)
+{
+    float distance = plane->x * center.x + plane->y * center.y + plane->z * center.z + plane->w;
+    float extent = fabsf(plane->x) * half.x + fabsf(plane->y) * half.y + fabsf(plane->z) * half.z;
+    return distance + extent;
+}
+
+int Geo_BoxesInsidePlanes(const Vec4_t* planes,
+                          int planeCount,
+                          const float* centerX,
+                          const float* centerY,
+                          const float* centerZ,
+                          const float* halfX,
+                          const float* halfY,
+                          const float* halfZ,
+                          int count,
+                          int* out)
+{
+    const VecLanes_t zero = VecLanes_Set(0.0f);
+    
+    int insideCount = 0;
+    
+    int i;
+    for (i = 0; i + VEC_LANES <= count; i += VEC_LANES)
+    {
+        VecLanes_t cx = VecLanes_Load(centerX + i);
+        VecLanes_t cy = VecLanes_Load(centerY + i);
+        VecLanes_t cz = VecLanes_Load(centerZ + i);
+        VecLanes_t hx = VecLanes_Load(halfX + i);
+        VecLanes_t hy = VecLanes_Load(halfY + i);
+        VecLanes_t hz = VecLanes_Load(halfZ + i);
+        
+        /* one bit per box still inside */
+        int inside = (1 << VEC_LANES) - 1;
+        
+        int p;
+        for (p = 0; p < planeCount && inside; ++p)
+        {
+            const Vec4_t* plane = planes + p;
+            
+            VecLanes_t distance = VecLanes_Add(VecLanes_Add(VecLanes_Add(VecLanes_Mult(VecLanes_Set(plane->x), cx),
+                                                                         VecLanes_Mult(VecLanes_Set(plane->y), cy)),
+                                                            VecLanes_Mult(VecLanes_Set(plane->z), cz)),
+                                               VecLanes_Set(plane->w));
+            
+            VecLanes_t extent = VecLanes_Add(VecLanes_Add(VecLanes_Mult(VecLanes_Set(fabsf(plane->x)), hx),
+                                                          VecLanes_Mult(VecLanes_Set(fabsf(plane->y)), hy)),
+                                             VecLanes_Mult(VecLanes_Set(fabsf(plane->z)), hz));
+            
+            inside &= VecLanes_GreaterEqual(VecLanes_Add(distance, extent), zero);
+        }
+        
+        while (inside)
+        {
+            int lane = __builtin_ctz(inside);
+            out[insideCount++] = i + lane;
+            inside &= inside - 1;
+        }
+    }
+    
+    for (; i < count; ++i)
+    {
+        Vec3_t center = Vec3_Create(centerX[i], centerY[i], centerZ[i]);
+        Vec3_t half = Vec3_Create(halfX[i], halfY[i], halfZ[i]);
+        
+        int p;
+        for (p = 0; p < planeCount; ++p)
+        {
+            if (_Geo_BoxPlaneReach(planes + p, center, half) < 0.0f) break;
+        }
+        
+        if (p == planeCount) out[insideCount++] = i;
+    }
+    
+    return insideCount;
+}
+
+/* boxes converted to centers and half sizes at a time */
+#define GEO_AABB_BLOCK 64
+
+int Geo_AABBsInsidePlanes(const Vec4_t* planes,
+                          int planeCount,
+                          const AABB_t* boxes,
+                          int count,
+                          int* out)
+{
+    float center[3][GEO_AABB_BLOCK];
+    float half[3][GEO_AABB_BLOCK];
+    
+    int insideCount = 0;
+    
+    int start;
+    for (start = 0; start < count; start += GEO_AABB_BLOCK)
+    {
+        int blockCount = count - start < GEO_AABB_BLOCK ? count - start : GEO_AABB_BLOCK;
+        
+        int i;
+        for (i = 0; i < blockCount; ++i)
+        {
+            const AABB_t* box = boxes + start + i;
+            Vec3_t c = AABB_Center(*box);
+            Vec3_t h = Vec3_Scale(Vec3_Sub(box->max, box->min), 0.5f);
+            
+            center[0][i] = c.x;
+            center[1][i] = c.y;
+            center[2][i] = c.z;
+            half[0][i] = h.x;
+            half[1][i] = h.y;
+            half[2][i] = h.z;
+        }
+        
+        int found = Geo_BoxesInsidePlanes(planes,
+                                          planeCount,
+                                          center[0],
+                                          center[1],
+                                          center[2],
+                                          half[0],
+                                          half[1],
+                                          half[2],
+                                          blockCount,
+                                          out + insideCount);
+        
+        for (i = 0; i < found; ++i) out[insideCount + i] += start;
+        insideCount += found;
+    }
+    
+    return insideCount;
+}
@@ -252,6 +252,26 @@ extern int Sphere_IntersectsRay(Sphere_t a, Ray3_t ray, float* t);
 
 extern int Geo_PointInPoly(int nvert, Vec2_t* verts, Vec2_t test);
 
+/* bulk tests of boxes against planes given as a unit normal and distance, inside where n . p + d >= 0
+ like Cam_t's planeEquations. writes the indices of the boxes that are inside or crossing every plane
+ to out in order and returns how many there are */
+extern int Geo_BoxesInsidePlanes(const Vec4_t* planes,
+                                 int planeCount,
+                                 const float* centerX,
+                                 const float* centerY,
+                                 const float* centerZ,
+                                 const float* halfX,
+                                 const float* halfY,
+                                 const float* halfZ,
+                                 int count,
+                                 int* out);
+
+extern int Geo_AABBsInsidePlanes(const Vec4_t* planes,
+                                 int planeCount,
+                                 const AABB_t* boxes,
+                                 int count,
+                                 int* out);
+
 extern Vec3_t Geo_BlendBarcentric(Vec3_t p1,
                                   Vec3_t p2,
                                   Vec3_t p3,
@@ -0,0 +1,174 @@
+
+#include "grid.h"
+#include <stdlib.h>
+#include <assert.h>
+
+static inline int _Grid_Cell(const SpatialGrid_t* grid, float v)
+{
+    return (int)floorf(v * grid->invCellSize);
+}
+
+static inline int _Grid_Bucket(const SpatialGrid_t* grid, int cx, int cy, int cz)
+{
+    unsigned int h = ((unsigned int)cx * 73856093u) ^ ((unsigned int)cy * 19349663u) ^ ((unsigned int)cz * 83492791u);
+    return h & (grid->tableSize - 1);
+}
+
+void SpatialGrid_Init(SpatialGrid_t* grid, int capacity, float cellSize)
+{
+    grid->cellSize = cellSize;
+    grid->invCellSize = 1.0f / cellSize;
+    grid->capacity = capacity;
+    grid->count = 0;
+    
+    /* twice as many buckets as entities keeps collisions rare */
+    grid->tableSize = 1;
+    while (grid->tableSize < capacity * 2)
+    {
+        grid->tableSize <<= 1;
+    }
+    
+    grid->bucketStart = calloc(grid->tableSize + 1, sizeof(int));
+    grid->entries = malloc(sizeof(int) * capacity);
+    grid->slotBucket = malloc(sizeof(int) * capacity);
+    
+    assert(grid->bucketStart && grid->entries && grid->slotBucket);
+}
+
+void SpatialGrid_Shutdown(SpatialGrid_t* grid)
+{
+    free(grid->bucketStart);
+    free(grid->entries);
+    free(grid->slotBucket);
+    
+    grid->capacity = 0;
+    grid->count = 0;
+}
+
+void SpatialGrid_Build(SpatialGrid_t* grid, const EntityStore_t* store)
+{
+    assert(store->count <= grid->capacity);
+    
+    int* start = grid->bucketStart;
+    memset(start, 0, sizeof(int) * (grid->tableSize + 1));
+    
+    const int n = store->count;
+    grid->count = n;
+    
+    int i;
+    for (i = 0; i < n; ++i)
+    {
+        int b = _Grid_Bucket(grid,
+                             _Grid_Cell(grid, store->x[i]),
+                             _Grid_Cell(grid, store->y[i]),
+                             _Grid_Cell(grid, store->z[i]));
+        grid->slotBucket[i] = b;
+        ++start[b + 1];
+    }
+    
+    for (i = 0; i < grid->tableSize; ++i)
+    {
+        start[i + 1] += start[i];
+    }
+    
+    /* fill each bucket from its end so slots stay in ascending order.
+     afterwards start[b + 1] holds the first entry of bucket b */
+    for (i = n - 1; i >= 0; --i)
+    {
+        int b = grid->slotBucket[i];
+        grid->entries[--start[b + 1]] = i;
+    }
+    
+    memmove(start, start + 1, sizeof(int) * grid->tableSize);
+    start[grid->tableSize] = n;
+}
+
+static int _Grid_Query(const SpatialGrid_t* grid,
+                       const EntityStore_t* store,
+                       AABB_t bounds,
+                       int sphere,
+                       Vec3_t center,
+                       float radiusSq,
+                       int* out,
+                       int maxOut)
+{
+    int minX = _Grid_Cell(grid, bounds.min.x);
+    int minY = _Grid_Cell(grid, bounds.min.y);
+    int minZ = _Grid_Cell(grid, bounds.min.z);
+    int maxX = _Grid_Cell(grid, bounds.max.x);
+    int maxY = _Grid_Cell(grid, bounds.max.y);
+    int maxZ = _Grid_Cell(grid, bounds.max.z);
+    
+    int found = 0;
+    
+    int cx, cy, cz;
+    for (cx = minX; cx <= maxX; ++cx)
+    {
+        for (cy = minY; cy <= maxY; ++cy)
+        {
+            for (cz = minZ; cz <= maxZ; ++cz)
+            {
+                int b = _Grid_Bucket(grid, cx, cy, cz);
+                
+                int e;
+                for (e = grid->bucketStart[b]; e < grid->bucketStart[b + 1]; ++e)
+                {
+                    int s = grid->entries[e];
+                    
+                    float x = store->x[s];
+                    float y = store->y[s];
+                    float z = store->z[s];
+                    
+                    /* other cells share this bucket, only report entities from this one
+                     so nothing is reported twice */
+                    if (_Grid_Cell(grid, x) != cx ||
+                        _Grid_Cell(grid, y) != cy ||
+                        _Grid_Cell(grid, z) != cz)
+                    {
+                        continue;
+                    }
+                    
+                    if (sphere)
+                    {
+                        float dx = x - center.x;
+                        float dy = y - center.y;
+                        float dz = z - center.z;
+                        
+                        if (dx * dx + dy * dy + dz * dz > radiusSq) continue;
+                    }
+                    else if (!AABB_IntersectsPoint(bounds, Vec3_Create(x, y, z)))
+                    {
+                        continue;
+                    }
+                    
+                    if (found == maxOut) return found;
+                    out[found++] = s;
+                }
+            }
+        }
+    }
+    
+    return found;
+}
+
+int SpatialGrid_QueryRadius(const SpatialGrid_t* grid,
+                            const EntityStore_t* store,
+                            Vec3_t center,
+                            float radius,
+                            int* out,
+                            int maxOut)
+{
+    Vec3_t extent = Vec3_Clear(radius);
+    AABB_t bounds = AABB_Create(Vec3_Sub(center, extent), Vec3_Add(center, extent));
+    
+    return _Grid_Query(grid, store, bounds, TRUE, center, radius * radius, out, maxOut);
+}
+
+int SpatialGrid_QueryAABB(const SpatialGrid_t* grid,
+                          const EntityStore_t* store,
+                          AABB_t bounds,
+                          int* out,
+                          int maxOut)
+{
+    return _Grid_Query(grid, store, bounds, FALSE, Vec3_Zero(), 0.0f, out, maxOut);
+}
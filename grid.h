@@ -0,0 +1,54 @@
+
+#ifndef ccraft_grid_h
+#define ccraft_grid_h
+
+#include "vec_math.h"
+#include "geo.h"
+#include "entity.h"
+
+/* uniform grid broadphase over entity positions.
+ cells are hashed into a fixed table and entities are counting sorted by bucket,
+ so a rebuild is linear and a query only visits the cells it overlaps */
+typedef struct
+{
+    float cellSize;
+    float invCellSize;
+    
+    int tableSize;
+    int capacity;
+    int count;
+    
+    /* entries for bucket b are entries[bucketStart[b]] to entries[bucketStart[b + 1] - 1] */
+    int* bucketStart;
+    
+    /* entity slots sorted by bucket */
+    int* entries;
+    
+    /* scratch - bucket of each slot */
+    int* slotBucket;
+    
+} SpatialGrid_t;
+
+/* capacity is the most entities the grid will ever hold */
+extern void SpatialGrid_Init(SpatialGrid_t* grid, int capacity, float cellSize);
+extern void SpatialGrid_Shutdown(SpatialGrid_t* grid);
+
+/* must be called after entities move and before querying */
+extern void SpatialGrid_Build(SpatialGrid_t* grid, const EntityStore_t* store);
+
+/* queries write entity slots into out and return how many were found, up to maxOut.
+ slots are only valid until the store is next modified */
+extern int SpatialGrid_QueryRadius(const SpatialGrid_t* grid,
+                                   const EntityStore_t* store,
+                                   Vec3_t center,
+                                   float radius,
+                                   int* out,
+                                   int maxOut);
+
+extern int SpatialGrid_QueryAABB(const SpatialGrid_t* grid,
+                                 const EntityStore_t* store,
+                                 AABB_t bounds,
+                                 int* out,
+                                 int maxOut);
+
+#endif
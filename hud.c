@@ -0,0 +1,67 @@
+
+#include "hud.h"
+#include <stdlib.h>
+#include <assert.h>
+
+static void _HudGrid_Init(HudGrid_t* grid, const Inventory_t* inventory, float ox, float oy)
+{
+    grid->count = inventory->width * inventory->height;
+    grid->slots = malloc(sizeof(HudRect_t) * grid->count);
+    assert(grid->slots);
+    
+    int x, y;
+    for (y = 0; y < inventory->height; ++y)
+    {
+        for (x = 0; x < inventory->width; ++x)
+        {
+            HudRect_t* rect = grid->slots + x + y * inventory->width;
+            rect->min.x = ox + (float)x * (HUD_SLOT_SIZE + HUD_SLOT_SPACING);
+            rect->min.y = oy + (float)y * (HUD_SLOT_SIZE + HUD_SLOT_SPACING);
+            rect->max.x = rect->min.x + HUD_SLOT_SIZE;
+            rect->max.y = rect->min.y + HUD_SLOT_SIZE;
+        }
+    }
+}
+
+void Hud_Init(Hud_t* hud, const Inventory_t* pack, const Inventory_t* belt)
+{
+    _HudGrid_Init(&hud->pack, pack, HUD_PACK_X, HUD_PACK_Y);
+    _HudGrid_Init(&hud->belt, belt, HUD_BELT_X, HUD_BELT_Y);
+}
+
+void Hud_Shutdown(Hud_t* hud)
+{
+    free(hud->pack.slots);
+    free(hud->belt.slots);
+    hud->pack.slots = NULL;
+    hud->belt.slots = NULL;
+}
+
+int HudGrid_SlotAt(const HudGrid_t* grid, Vec2_t point)
+{
+    int i;
+    for (i = 0; i < grid->count; ++i)
+    {
+        const HudRect_t* rect = grid->slots + i;
+        
+        /* edges and the spacing between slots select nothing */
+        if (point.x > rect->min.x &&
+            point.y > rect->min.y &&
+            point.x < rect->max.x &&
+            point.y < rect->max.y)
+        {
+            return i;
+        }
+    }
+    
+    return -1;
+}
+
+void Hud_UpdateCursor(const Hud_t* hud, Vec2_t cursor, Inventory_t* pack, Inventory_t* belt)
+{
+    int slot = HudGrid_SlotAt(&hud->pack, cursor);
+    if (slot != -1) pack->selectedItem = slot;
+    
+    slot = HudGrid_SlotAt(&hud->belt, cursor);
+    if (slot != -1) belt->selectedItem = slot;
+}
@@ -0,0 +1,47 @@
+
+#ifndef ccraft_hud_h
+#define ccraft_hud_h
+
+#include "vec_math.h"
+#include "inventory.h"
+
+/* layout of the inventory grids, shared by the renderer that draws them and the update that hit tests them.
+ positions are in the 1024 x 768 space with y up that the renderer's ortho projection uses */
+
+#define HUD_SLOT_SIZE 32.0f
+#define HUD_SLOT_SPACING 2.0f
+
+#define HUD_PACK_X 16.0f
+#define HUD_PACK_Y 550.0f
+#define HUD_BELT_X 16.0f
+#define HUD_BELT_Y 700.0f
+
+typedef struct
+{
+    Vec2_t min;
+    Vec2_t max;
+} HudRect_t;
+
+/* the rectangle of every slot of an inventory, by item index */
+typedef struct
+{
+    int count;
+    HudRect_t* slots;
+} HudGrid_t;
+
+typedef struct
+{
+    HudGrid_t pack;
+    HudGrid_t belt;
+} Hud_t;
+
+extern void Hud_Init(Hud_t* hud, const Inventory_t* pack, const Inventory_t* belt);
+extern void Hud_Shutdown(Hud_t* hud);
+
+/* index of the slot the point is inside, -1 if none */
+extern int HudGrid_SlotAt(const HudGrid_t* grid, Vec2_t point);
+
+/* selects the pack and belt slots under the cursor, for while the inventory is open */
+extern void Hud_UpdateCursor(const Hud_t* hud, Vec2_t cursor, Inventory_t* pack, Inventory_t* belt);
+
+#endif
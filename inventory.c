@@ -15,12 +15,18 @@ static const char ItemStackableTable[] =
 
 void Inventory_Init(Inventory_t* inventory, short width, short height)
 {
-    inventory->items = malloc(sizeof(Item_t) * width * height);
+    inventory->items = calloc(width * height, sizeof(Item_t));
     inventory->width = width;
     inventory->height = height;
     inventory->selectedItem = -1;
 }
 
+void Inventory_Shutdown(Inventory_t* inventory)
+{
+    free(inventory->items);
+    inventory->items = NULL;
+}
+
 Item_t* Inventory_ItemAt(Inventory_t* inventory, short x, short y)
 {
     return &inventory->items[x + y * inventory->width];
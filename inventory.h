@@ -30,6 +30,7 @@ typedef struct
 } Inventory_t;
 
 extern void Inventory_Init(Inventory_t* inventory, short width, short height);
+extern void Inventory_Shutdown(Inventory_t* inventory);
 
 extern Item_t* Inventory_ItemAt(Inventory_t* inventory, short x, short y);
 extern int Inventory_AddItem(Inventory_t* inventory, short item, int qty);
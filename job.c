@@ -0,0 +1,335 @@
+
+#include "job.h"
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <assert.h>
+
+typedef struct
+{
+    pthread_mutex_t lock;
+    
+    /* jobs are pushed and popped at bottom, stolen from top */
+    Job_t* jobs[JOB_POOL_SIZE];
+    int top;
+    int bottom;
+    
+    Job_t pool[JOB_POOL_SIZE];
+    unsigned int allocated;
+    
+    /* state for picking steal victims */
+    unsigned int seed;
+    
+} Worker_t;
+
+static Worker_t _workers[JOB_MAX_WORKERS];
+static pthread_t _threads[JOB_MAX_WORKERS];
+static int _workerCount = 1;
+
+static _Thread_local int _workerIndex = 0;
+
+/* sleeping workers wait for queued jobs */
+static pthread_mutex_t _sleepLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t _wake = PTHREAD_COND_INITIALIZER;
+static atomic_int _queued;
+static atomic_int _quit;
+
+static void _Worker_Push(Worker_t* worker, Job_t* job)
+{
+    pthread_mutex_lock(&worker->lock);
+    assert(worker->bottom - worker->top < JOB_POOL_SIZE);
+    worker->jobs[worker->bottom % JOB_POOL_SIZE] = job;
+    ++worker->bottom;
+    pthread_mutex_unlock(&worker->lock);
+}
+
+static Job_t* _Worker_Pop(Worker_t* worker)
+{
+    Job_t* job = NULL;
+    
+    pthread_mutex_lock(&worker->lock);
+    if (worker->bottom > worker->top)
+    {
+        --worker->bottom;
+        job = worker->jobs[worker->bottom % JOB_POOL_SIZE];
+        
+        /* rewind an empty deque so the indices never overflow */
+        if (worker->bottom == worker->top)
+        {
+            worker->top = 0;
+            worker->bottom = 0;
+        }
+    }
+    pthread_mutex_unlock(&worker->lock);
+    
+    return job;
+}
+
+static Job_t* _Worker_Steal(Worker_t* worker)
+{
+    Job_t* job = NULL;
+    
+    pthread_mutex_lock(&worker->lock);
+    if (worker->bottom > worker->top)
+    {
+        job = worker->jobs[worker->top % JOB_POOL_SIZE];
+        ++worker->top;
+        
+        if (worker->bottom == worker->top)
+        {
+            worker->top = 0;
+            worker->bottom = 0;
+        }
+    }
+    pthread_mutex_unlock(&worker->lock);
+    
+    return job;
+}
+
+static Job_t* _Job_Get(void)
+{
+    Worker_t* self = _workers + _workerIndex;
+    
+    Job_t* job = _Worker_Pop(self);
+    if (job) return job;
+    
+    if (_workerCount == 1) return NULL;
+    
+    /* start at a random victim so thieves spread out */
+    self->seed = self->seed * 1103515245u + 12345u;
+    int start = (self->seed >> 16) % _workerCount;
+    
+    int i;
+    for (i = 0; i < _workerCount; ++i)
+    {
+        int victim = (start + i) % _workerCount;
+        if (victim == _workerIndex) continue;
+        
+        job = _Worker_Steal(_workers + victim);
+        if (job) return job;
+    }
+    
+    return NULL;
+}
+
+static void _Job_Finish(Job_t* job)
+{
+    while (job)
+    {
+        /* once the count hits 0 the slot may be recycled by its owner, so read parent first */
+        Job_t* parent = job->parent;
+        
+        if (atomic_fetch_sub_explicit(&job->unfinished, 1, memory_order_acq_rel) != 1)
+        {
+            return;
+        }
+        job = parent;
+    }
+}
+
+static void _Job_Execute(Job_t* job)
+{
+    atomic_fetch_sub_explicit(&_queued, 1, memory_order_relaxed);
+    
+    int count = job->end - job->begin;
+    
+    if (job->batchSize > 0 && count > job->batchSize)
+    {
+        /* split on a batch boundary so every leaf is exactly one batch */
+        int batches = (count + job->batchSize - 1) / job->batchSize;
+        int mid = job->begin + (batches / 2) * job->batchSize;
+        
+        Job_t* left = Job_Create(job->func, job->data, job->begin, mid, job);
+        Job_t* right = Job_Create(job->func, job->data, mid, job->end, job);
+        left->batchSize = job->batchSize;
+        right->batchSize = job->batchSize;
+        
+        Job_Run(right);
+        Job_Run(left);
+    }
+    else if (count > 0)
+    {
+        job->func(job->data, job->begin, job->end);
+    }
+    
+    _Job_Finish(job);
+}
+
+static void* _Job_WorkerMain(void* arg)
+{
+    _workerIndex = (int)(long)arg;
+    
+    while (!atomic_load(&_quit))
+    {
+        Job_t* job = _Job_Get();
+        
+        if (job)
+        {
+            _Job_Execute(job);
+            continue;
+        }
+        
+        pthread_mutex_lock(&_sleepLock);
+        while (atomic_load(&_queued) == 0 && !atomic_load(&_quit))
+        {
+            pthread_cond_wait(&_wake, &_sleepLock);
+        }
+        pthread_mutex_unlock(&_sleepLock);
+    }
+    
+    return NULL;
+}
+
+void Job_Init(int workerCount)
+{
+    if (workerCount <= 0)
+    {
+        workerCount = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    }
+    
+    if (workerCount < 1) workerCount = 1;
+    if (workerCount > JOB_MAX_WORKERS) workerCount = JOB_MAX_WORKERS;
+    
+    _workerCount = workerCount;
+    _workerIndex = 0;
+    atomic_store(&_queued, 0);
+    atomic_store(&_quit, 0);
+    
+    int i;
+    for (i = 0; i < _workerCount; ++i)
+    {
+        Worker_t* worker = _workers + i;
+        pthread_mutex_init(&worker->lock, NULL);
+        worker->top = 0;
+        worker->bottom = 0;
+        worker->allocated = 0;
+        worker->seed = i + 1;
+    }
+    
+    for (i = 1; i < _workerCount; ++i)
+    {
+        int result = pthread_create(&_threads[i], NULL, _Job_WorkerMain, (void*)(long)i);
+        assert(result == 0);
+    }
+}
+
+void Job_Shutdown(void)
+{
+    pthread_mutex_lock(&_sleepLock);
+    atomic_store(&_quit, 1);
+    pthread_cond_broadcast(&_wake);
+    pthread_mutex_unlock(&_sleepLock);
+    
+    int i;
+    for (i = 1; i < _workerCount; ++i)
+    {
+        pthread_join(_threads[i], NULL);
+    }
+    
+    for (i = 0; i < _workerCount; ++i)
+    {
+        pthread_mutex_destroy(&_workers[i].lock);
+    }
+    
+    _workerCount = 1;
+}
+
+int Job_WorkerCount(void)
+{
+    return _workerCount;
+}
+
+int Job_WorkerIndex(void)
+{
+    return _workerIndex;
+}
+
+Job_t* Job_Create(JobFunc_t func, void* data, int begin, int end, Job_t* parent)
+{
+    Worker_t* self = _workers + _workerIndex;
+    
+    /* skip jobs that are still running or have running children */
+    Job_t* job = NULL;
+    
+    int i;
+    for (i = 0; i < JOB_POOL_SIZE; ++i)
+    {
+        Job_t* candidate = self->pool + (self->allocated++ % JOB_POOL_SIZE);
+        
+        if (Job_Done(candidate))
+        {
+            job = candidate;
+            break;
+        }
+    }
+    assert(job);
+    
+    job->func = func;
+    job->data = data;
+    job->begin = begin;
+    job->end = end;
+    job->batchSize = 0;
+    job->parent = parent;
+    atomic_store_explicit(&job->unfinished, 1, memory_order_relaxed);
+    
+    if (parent)
+    {
+        atomic_fetch_add_explicit(&parent->unfinished, 1, memory_order_relaxed);
+    }
+    
+    return job;
+}
+
+void Job_Run(Job_t* job)
+{
+    _Worker_Push(_workers + _workerIndex, job);
+    
+    atomic_fetch_add_explicit(&_queued, 1, memory_order_relaxed);
+    
+    if (_workerCount > 1)
+    {
+        pthread_mutex_lock(&_sleepLock);
+        pthread_cond_signal(&_wake);
+        pthread_mutex_unlock(&_sleepLock);
+    }
+}
+
+void Job_Wait(Job_t* job)
+{
+    while (!Job_Done(job))
+    {
+        Job_t* next = _Job_Get();
+        
+        if (next)
+        {
+            _Job_Execute(next);
+        }
+        else
+        {
+            sched_yield();
+        }
+    }
+}
+
+void Job_ParallelFor(JobFunc_t func, void* data, int count, int batchSize)
+{
+    if (count <= 0) return;
+    if (batchSize < 1) batchSize = 1;
+    
+    if (_workerCount == 1 || count <= batchSize)
+    {
+        /* batches still have to line up with the multithreaded path */
+        int begin;
+        for (begin = 0; begin < count; begin += batchSize)
+        {
+            int end = begin + batchSize;
+            func(data, begin, end < count ? end : count);
+        }
+        return;
+    }
+    
+    Job_t* root = Job_Create(func, data, 0, count, NULL);
+    root->batchSize = batchSize;
+    Job_Run(root);
+    Job_Wait(root);
+}
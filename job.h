@@ -0,0 +1,66 @@
+
+#ifndef ccraft_job_h
+#define ccraft_job_h
+
+#include <stdatomic.h>
+
+/* work stealing job system.
+ every worker owns a deque - it pushes and pops its own jobs at the bottom
+ while idle workers steal from the top of others. the thread that calls
+ Job_Init becomes worker 0 and runs jobs while it waits */
+
+#define JOB_MAX_WORKERS 16
+
+/* jobs are recycled from a ring per worker once they are done,
+ so a worker may have at most this many unfinished jobs */
+#define JOB_POOL_SIZE 4096
+
+/* runs items [begin, end) */
+typedef void (*JobFunc_t)(void* data, int begin, int end);
+
+typedef struct Job
+{
+    JobFunc_t func;
+    void* data;
+    int begin;
+    int end;
+    
+    /* ranges larger than this are split into children instead of run, 0 never splits */
+    int batchSize;
+    
+    struct Job* parent;
+    
+    /* this job plus its unfinished children */
+    atomic_int unfinished;
+    
+} Job_t;
+
+/* workerCount of 0 uses one worker per core */
+extern void Job_Init(int workerCount);
+extern void Job_Shutdown(void);
+
+extern int Job_WorkerCount(void);
+
+/* index of the calling worker - 0 for the main thread */
+extern int Job_WorkerIndex(void);
+
+/* a job isn't done until all of its children are. parent may be NULL */
+extern Job_t* Job_Create(JobFunc_t func, void* data, int begin, int end, Job_t* parent);
+
+/* makes the job available to run */
+extern void Job_Run(Job_t* job);
+
+/* runs other jobs until this one is done */
+extern void Job_Wait(Job_t* job);
+
+static inline int Job_Done(const Job_t* job)
+{
+    return atomic_load_explicit(&job->unfinished, memory_order_acquire) == 0;
+}
+
+/* splits [0, count) into batches of batchSize items, runs them on all workers and waits.
+ every batch starts at a multiple of batchSize, so batch begin / batchSize
+ identifies it regardless of which worker ran it */
+extern void Job_ParallelFor(JobFunc_t func, void* data, int count, int batchSize);
+
+#endif
@@ -0,0 +1,385 @@
+
+#include "light.h"
+#include <stdlib.h>
+
+static const char BlockEmissionTable[] =
+{
+    0, /* air */
+    0, /* dirt */
+    0, /* grass */
+    0, /* stone */
+    0, /* wood */
+    0, /* table */
+    0, /* bounce pad */
+    0, /* ice */
+    0, /* track */
+    0, /* mud */
+    12, /* gift */
+    0, /* solid */
+};
+
+int Block_Emission(int type)
+{
+    return BlockEmissionTable[type];
+}
+
+typedef struct
+{
+    int x;
+    int y;
+    int z;
+    int level;
+} LightNode_t;
+
+typedef struct
+{
+    LightNode_t* nodes;
+    int head;
+    int tail;
+    int capacity;
+} LightQueue_t;
+
+/* lighting only runs on the main thread, so the queues are reused between updates */
+static LightQueue_t _addQueues[LIGHT_CHANNELS];
+static LightQueue_t _removeQueue;
+
+static void _LightQueue_Push(LightQueue_t* queue, int x, int y, int z, int level)
+{
+    if (queue->tail == queue->capacity)
+    {
+        queue->capacity = queue->capacity ? queue->capacity * 2 : 4096;
+        queue->nodes = realloc(queue->nodes, sizeof(LightNode_t) * queue->capacity);
+        assert(queue->nodes);
+    }
+    
+    LightNode_t* node = queue->nodes + queue->tail++;
+    node->x = x;
+    node->y = y;
+    node->z = z;
+    node->level = level;
+}
+
+static int _LightQueue_Pop(LightQueue_t* queue, LightNode_t* node)
+{
+    if (queue->head == queue->tail)
+    {
+        queue->head = 0;
+        queue->tail = 0;
+        return 0;
+    }
+    
+    *node = queue->nodes[queue->head++];
+    return 1;
+}
+
+/* remembers the last chunk so walks through one chunk don't search the world */
+typedef struct
+{
+    World_t* world;
+    Chunk_t* chunk;
+    int cx;
+    int cy;
+    int cz;
+    int valid;
+} LightCursor_t;
+
+static Chunk_t* _Light_Chunk(LightCursor_t* cursor, int x, int y, int z)
+{
+    if (x < 0 || y < 0 || z < 0) return NULL;
+    
+    int cx = x / CHUNK_SIZE;
+    int cy = y / CHUNK_SIZE;
+    int cz = z / CHUNK_SIZE;
+    
+    if (!cursor->valid || cx != cursor->cx || cy != cursor->cy || cz != cursor->cz)
+    {
+        cursor->chunk = World_GetChunk(cursor->world, cx, cy, cz);
+        cursor->cx = cx;
+        cursor->cy = cy;
+        cursor->cz = cz;
+        cursor->valid = 1;
+    }
+    
+    return cursor->chunk;
+}
+
+/* faces of the blocks next to a block are shaded by its light */
+static void _Light_DirtyAround(Chunk_t* chunk, int bx, int by, int bz)
+{
+    Chunk_DirtySections(chunk, bx - 1, by - 1, bz - 1, bx + 1, by + 1, bz + 1);
+}
+
+static void _Light_DirtyNeighbor(World_t* world, Chunk_t* chunk, int dx, int dy, int dz, int bx, int by, int bz)
+{
+    Chunk_t* neighbor = World_GetChunk(world, chunk->x + dx, chunk->y + dy, chunk->z + dz);
+    
+    if (neighbor)
+    {
+        _Light_DirtyAround(neighbor, bx - dx * CHUNK_SIZE, by - dy * CHUNK_SIZE, bz - dz * CHUNK_SIZE);
+    }
+}
+
+static void _Light_Set(World_t* world, Chunk_t* chunk, int channel, int bx, int by, int bz, int level)
+{
+    Chunk_SetLight(chunk, channel, bx, by, bz, level);
+    _Light_DirtyAround(chunk, bx, by, bz);
+    
+    /* faces of the neighboring chunk sample light from this block */
+    if (bx == 0) _Light_DirtyNeighbor(world, chunk, -1, 0, 0, bx, by, bz);
+    if (bx == CHUNK_SIZE - 1) _Light_DirtyNeighbor(world, chunk, 1, 0, 0, bx, by, bz);
+    if (by == 0) _Light_DirtyNeighbor(world, chunk, 0, -1, 0, bx, by, bz);
+    if (by == CHUNK_SIZE - 1) _Light_DirtyNeighbor(world, chunk, 0, 1, 0, bx, by, bz);
+    if (bz == 0) _Light_DirtyNeighbor(world, chunk, 0, 0, -1, bx, by, bz);
+    if (bz == CHUNK_SIZE - 1) _Light_DirtyNeighbor(world, chunk, 0, 0, 1, bx, by, bz);
+}
+
+static const int LightDirs[6][3] =
+{
+    {-1, 0, 0},
+    {1, 0, 0},
+    {0, -1, 0},
+    {0, 1, 0},
+    {0, 0, -1},
+    {0, 0, 1},
+};
+
+#define LIGHT_DIR_DOWN 4
+
+static void _Light_Propagate(World_t* world, int channel)
+{
+    LightQueue_t* queue = _addQueues + channel;
+    
+    LightCursor_t cursor = {world, NULL, 0, 0, 0, 0};
+    LightNode_t node;
+    
+    while (_LightQueue_Pop(queue, &node))
+    {
+        Chunk_t* chunk = _Light_Chunk(&cursor, node.x, node.y, node.z);
+        if (!chunk) continue;
+        
+        /* the level may have risen since the node was queued */
+        int level = Chunk_GetLight(chunk, channel, node.x % CHUNK_SIZE, node.y % CHUNK_SIZE, node.z % CHUNK_SIZE);
+        if (level <= 1) continue;
+        
+        int d;
+        for (d = 0; d < 6; ++d)
+        {
+            int x = node.x + LightDirs[d][0];
+            int y = node.y + LightDirs[d][1];
+            int z = node.z + LightDirs[d][2];
+            
+            Chunk_t* neighbor = _Light_Chunk(&cursor, x, y, z);
+            if (!neighbor) continue;
+            
+            int bx = x % CHUNK_SIZE;
+            int by = y % CHUNK_SIZE;
+            int bz = z % CHUNK_SIZE;
+            
+            if (Block_Opaque(neighbor->blocks[bx][by][bz].type)) continue;
+            
+            int newLevel = level - 1;
+            
+            if (channel == LIGHT_SKY && d == LIGHT_DIR_DOWN && level == LIGHT_MAX)
+            {
+                newLevel = LIGHT_MAX;
+            }
+            
+            if (newLevel > Chunk_GetLight(neighbor, channel, bx, by, bz))
+            {
+                _Light_Set(world, neighbor, channel, bx, by, bz, newLevel);
+                _LightQueue_Push(queue, x, y, z, newLevel);
+            }
+        }
+    }
+}
+
+/* darkens everything that was lit by the queued nodes, and queues whatever
+ still has light from another source so it can fill the gap back in */
+static void _Light_Remove(World_t* world, int channel)
+{
+    LightQueue_t* queue = _addQueues + channel;
+    
+    LightCursor_t cursor = {world, NULL, 0, 0, 0, 0};
+    LightNode_t node;
+    
+    while (_LightQueue_Pop(&_removeQueue, &node))
+    {
+        int d;
+        for (d = 0; d < 6; ++d)
+        {
+            int x = node.x + LightDirs[d][0];
+            int y = node.y + LightDirs[d][1];
+            int z = node.z + LightDirs[d][2];
+            
+            Chunk_t* neighbor = _Light_Chunk(&cursor, x, y, z);
+            if (!neighbor) continue;
+            
+            int bx = x % CHUNK_SIZE;
+            int by = y % CHUNK_SIZE;
+            int bz = z % CHUNK_SIZE;
+            
+            int level = Chunk_GetLight(neighbor, channel, bx, by, bz);
+            if (level == 0) continue;
+            
+            int dependent = level < node.level;
+            
+            if (channel == LIGHT_SKY && d == LIGHT_DIR_DOWN && node.level == LIGHT_MAX)
+            {
+                dependent = 1;
+            }
+            
+            if (dependent)
+            {
+                _Light_Set(world, neighbor, channel, bx, by, bz, 0);
+                _LightQueue_Push(&_removeQueue, x, y, z, level);
+                
+                int emission = (channel == LIGHT_BLOCK) ? Block_Emission(neighbor->blocks[bx][by][bz].type) : 0;
+                if (emission)
+                {
+                    _Light_Set(world, neighbor, channel, bx, by, bz, emission);
+                    _LightQueue_Push(queue, x, y, z, emission);
+                }
+            }
+            else
+            {
+                _LightQueue_Push(queue, x, y, z, level);
+            }
+        }
+    }
+}
+
+void Light_InitChunk(World_t* world, Chunk_t* chunk)
+{
+    memset(chunk->light, 0, sizeof(chunk->light));
+    
+    int ox = chunk->x * CHUNK_SIZE;
+    int oy = chunk->y * CHUNK_SIZE;
+    int oz = chunk->z * CHUNK_SIZE;
+    
+    int x, y, z;
+    
+    /* with nothing loaded above, columns are open to the sky */
+    if (!World_GetChunk(world, chunk->x, chunk->y, chunk->z + 1))
+    {
+        for (x = 0; x < CHUNK_SIZE; ++x)
+        {
+            for (y = 0; y < CHUNK_SIZE; ++y)
+            {
+                for (z = CHUNK_SIZE - 1; z >= 0; --z)
+                {
+                    if (Block_Opaque(chunk->blocks[x][y][z].type)) break;
+                    
+                    Chunk_SetLight(chunk, LIGHT_SKY, x, y, z, LIGHT_MAX);
+                    _LightQueue_Push(_addQueues + LIGHT_SKY, ox + x, oy + y, oz + z, LIGHT_MAX);
+                }
+            }
+        }
+    }
+    
+    for (x = 0; x < CHUNK_SIZE; ++x)
+    {
+        for (y = 0; y < CHUNK_SIZE; ++y)
+        {
+            for (z = 0; z < CHUNK_SIZE; ++z)
+            {
+                int emission = Block_Emission(chunk->blocks[x][y][z].type);
+                if (emission)
+                {
+                    Chunk_SetLight(chunk, LIGHT_BLOCK, x, y, z, emission);
+                    _LightQueue_Push(_addQueues + LIGHT_BLOCK, ox + x, oy + y, oz + z, emission);
+                }
+            }
+        }
+    }
+    
+    /* light in the bordering layer of each neighbor flows in */
+    int d;
+    for (d = 0; d < 6; ++d)
+    {
+        Chunk_t* neighbor = World_GetChunk(world, chunk->x + LightDirs[d][0], chunk->y + LightDirs[d][1], chunk->z + LightDirs[d][2]);
+        if (!neighbor) continue;
+        
+        int axis = d / 2;
+        int layer = (d % 2) ? 0 : CHUNK_SIZE - 1;
+        
+        int u, v;
+        for (u = 0; u < CHUNK_SIZE; ++u)
+        {
+            for (v = 0; v < CHUNK_SIZE; ++v)
+            {
+                int b[3];
+                b[axis] = layer;
+                b[(axis + 1) % 3] = u;
+                b[(axis + 2) % 3] = v;
+                
+                int channel;
+                for (channel = 0; channel < LIGHT_CHANNELS; ++channel)
+                {
+                    int level = Chunk_GetLight(neighbor, channel, b[0], b[1], b[2]);
+                    if (level > 1)
+                    {
+                        _LightQueue_Push(_addQueues + channel,
+                                         neighbor->x * CHUNK_SIZE + b[0],
+                                         neighbor->y * CHUNK_SIZE + b[1],
+                                         neighbor->z * CHUNK_SIZE + b[2],
+                                         level);
+                    }
+                }
+            }
+        }
+    }
+    
+    chunk->dirtySections = CHUNK_SECTIONS_ALL;
+    
+    _Light_Propagate(world, LIGHT_SKY);
+    _Light_Propagate(world, LIGHT_BLOCK);
+}
+
+void Light_UpdateBlock(World_t* world, int x, int y, int z)
+{
+    LightCursor_t cursor = {world, NULL, 0, 0, 0, 0};
+    
+    Chunk_t* chunk = _Light_Chunk(&cursor, x, y, z);
+    if (!chunk) return;
+    
+    int bx = x % CHUNK_SIZE;
+    int by = y % CHUNK_SIZE;
+    int bz = z % CHUNK_SIZE;
+    int type = chunk->blocks[bx][by][bz].type;
+    
+    int channel;
+    for (channel = 0; channel < LIGHT_CHANNELS; ++channel)
+    {
+        int old = Chunk_GetLight(chunk, channel, bx, by, bz);
+        
+        _Light_Set(world, chunk, channel, bx, by, bz, 0);
+        _LightQueue_Push(&_removeQueue, x, y, z, old);
+        _Light_Remove(world, channel);
+        
+        if (channel == LIGHT_SKY && !Block_Opaque(type) && !_Light_Chunk(&cursor, x, y, z + 1))
+        {
+            _Light_Set(world, chunk, channel, bx, by, bz, LIGHT_MAX);
+            _LightQueue_Push(_addQueues + channel, x, y, z, LIGHT_MAX);
+        }
+        
+        if (channel == LIGHT_BLOCK && Block_Emission(type))
+        {
+            _Light_Set(world, chunk, channel, bx, by, bz, Block_Emission(type));
+            _LightQueue_Push(_addQueues + channel, x, y, z, Block_Emission(type));
+        }
+        
+        _Light_Propagate(world, channel);
+    }
+}
+
+int Light_GetAt(World_t* world, int channel, int x, int y, int z)
+{
+    Chunk_t* chunk = (x < 0 || y < 0 || z < 0) ? NULL : World_GetChunk(world, x / CHUNK_SIZE, y / CHUNK_SIZE, z / CHUNK_SIZE);
+    
+    if (!chunk)
+    {
+        return (channel == LIGHT_SKY) ? LIGHT_MAX : 0;
+    }
+    
+    return Chunk_GetLight(chunk, channel, x % CHUNK_SIZE, y % CHUNK_SIZE, z % CHUNK_SIZE);
+}
@@ -0,0 +1,24 @@
+
+#ifndef ccraft_light_h
+#define ccraft_light_h
+
+#include "world.h"
+
+/* flood fill lighting.
+ sky light falls straight down at full strength and spreads sideways losing a level per block.
+ block light spreads from emitting blocks the same way in every direction.
+ light crosses chunk borders, and chunks whose light changes are marked for remeshing */
+
+extern int Block_Emission(int type);
+
+/* lights a chunk that was just generated or loaded, including light
+ flowing in from and out to its neighbours */
+extern void Light_InitChunk(World_t* world, Chunk_t* chunk);
+
+/* relights the region around a block that changed type */
+extern void Light_UpdateBlock(World_t* world, int x, int y, int z);
+
+/* returns LIGHT_MAX for sky light above loaded chunks and 0 for block light */
+extern int Light_GetAt(World_t* world, int channel, int x, int y, int z);
+
+#endif
@@ -1,6 +1,11 @@
 
 #include "game.h"
+#include "replay.h"
+#include "digest.h"
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
 #include <SDL2/SDL.h>
 #include <OpenGL/gl.h>
 
@@ -23,6 +28,13 @@ int _space = 0;
 int _click = 0;
 int _rightClick = 0;
 
+/* gathered from events over a frame, applied with the rest of the input */
+int _toggles = 0;
+float _lookX = 0.0f;
+float _lookY = 0.0f;
+float _cursorX = 0.0f;
+float _cursorY = 0.0f;
+
 int _numbers[9] =
 {
     0,0,0,
@@ -109,7 +121,7 @@ void keyUp(unsigned int keycode)
             _numbers[4] = st;
             break;
         case SDL_SCANCODE_E:
-            Game_ToggleInventory(&game);
+            _toggles++;
             break;
         default:
             break;
@@ -131,8 +143,203 @@ void reshape(int width, int height)
 }
 
 
+static double _Now(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1000.0 + t.tv_nsec / 1000000.0;
+}
+
+static int _CompareTimes(const void* a, const void* b)
+{
+    double timeA = *(const double*)a;
+    double timeB = *(const double*)b;
+    return (timeA > timeB) - (timeA < timeB);
+}
+
+static void _PrintTimes(const char* name, double* times, int count, double total)
+{
+    if (count == 0) return;
+    
+    qsort(times, count, sizeof(double), _CompareTimes);
+    
+    printf("%s: avg %.3f ms, median %.3f ms, 99th %.3f ms, max %.3f ms\n",
+           name,
+           total / count,
+           times[count / 2],
+           times[(count * 99) / 100],
+           times[count - 1]);
+}
+
+/* runs a recording through the game as fast as it goes, reports how long the updates and chunk culling took,
+ how many chunks each cull stage dropped and the first tick whose state differs from the recording's. untilTick < 0 plays all of it,
+ digestPath gets every chunk, entity and player's digest where it stopped */
+static int _Replay(const char* path, int untilTick, const char* digestPath)
+{
+    Replay_t replay;
+    if (!Replay_Load(&replay, path))
+    {
+        fprintf(stderr, "can't read replay %s\n", path);
+        return 1;
+    }
+    
+    srand(replay.seed);
+    
+    Game_InitHeadless(&game);
+    game.persistent = 0;
+    
+    int tickCount = replay.tickCount;
+    if (untilTick >= 0 && untilTick < tickCount) tickCount = untilTick;
+    
+    double* times = malloc(sizeof(double) * (tickCount > 0 ? tickCount : 1));
+    double* digestTimes = malloc(sizeof(double) * (tickCount > 0 ? tickCount : 1));
+    double* visibilityTimes = malloc(sizeof(double) * (tickCount > 0 ? tickCount : 1));
+    double total = 0.0;
+    double digestTotal = 0.0;
+    double visibilityTotal = 0.0;
+    
+    /* summed over every tick */
+    CullStats_t culled = { 0, 0, 0, 0 };
+    
+    Player_t* players[1] = { &game.player };
+    Digest_t digest;
+    int diverged = -1;
+    
+    int i;
+    for (i = 0; i < tickCount; ++i)
+    {
+        Game_ApplyInput(&game, replay.ticks + i);
+        
+        double start = _Now();
+        Game_Update(&game);
+        times[i] = _Now() - start;
+        total += times[i];
+        
+        start = _Now();
+        Digest_Sim(&digest, &game.sim, players, 1);
+        digestTimes[i] = _Now() - start;
+        digestTotal += digestTimes[i];
+        
+        /* nothing is drawn, but the culling runs as if it were. it doesn't touch the digested state */
+        start = _Now();
+        Visibility_Update(&game.sim.world, &game.cam);
+        visibilityTimes[i] = _Now() - start;
+        visibilityTotal += visibilityTimes[i];
+        
+        const CullStats_t* stats = &game.sim.world.cullStats;
+        culled.drawn += stats->drawn;
+        culled.frustumCulled += stats->frustumCulled;
+        culled.occlusionCulled += stats->occlusionCulled;
+        culled.depthCulled += stats->depthCulled;
+        
+        if (diverged == -1 && digest.root != replay.digests[i])
+        {
+            diverged = i;
+        }
+    }
+    
+    printf("replayed %i of %i ticks in %.1f ms\n", tickCount, replay.tickCount, total);
+    
+    _PrintTimes("update", times, tickCount, total);
+    _PrintTimes("digest", digestTimes, tickCount, digestTotal);
+    _PrintTimes("visibility", visibilityTimes, tickCount, visibilityTotal);
+    
+    if (tickCount > 0)
+    {
+        printf("chunks per tick: %.1f drawn, %.1f frustum culled, %.1f graph culled, %.1f depth culled\n",
+               (double)culled.drawn / tickCount,
+               (double)culled.frustumCulled / tickCount,
+               (double)culled.occlusionCulled / tickCount,
+               (double)culled.depthCulled / tickCount);
+    }
+    
+    int result = 0;
+    
+    if (diverged != -1)
+    {
+        printf("state first differs from the recording after tick %i\n", diverged);
+        result = 2;
+    }
+    else if (!replay.finished && tickCount == replay.tickCount)
+    {
+        printf("state matches the recording as far as it goes, it was cut off\n");
+    }
+    else
+    {
+        printf("state matches the recording\n");
+    }
+    
+    if (digestPath)
+    {
+        FILE* file = fopen(digestPath, "w");
+        
+        if (file)
+        {
+            Digest_Write(file, &game.sim, players, 1);
+            fclose(file);
+        }
+        else
+        {
+            fprintf(stderr, "can't create %s\n", digestPath);
+        }
+    }
+    
+    free(times);
+    free(digestTimes);
+    free(visibilityTimes);
+    Replay_Free(&replay);
+    Game_Quit(&game);
+    
+    return result;
+}
+
+static void _Usage(const char* name)
+{
+    fprintf(stderr, "usage: %s [-record file | -replay file [-until N] [-digest file]]\n", name);
+    fprintf(stderr, "  -record file   write every tick of input to file, the world is not saved\n");
+    fprintf(stderr, "  -replay file   play a recording back without a window and time it\n");
+    fprintf(stderr, "  -until N       stop the replay after N ticks\n");
+    fprintf(stderr, "  -digest file   write the state's digest where the replay stopped, compare two with ccraft_diff\n");
+}
+
 int main(int argc, char * argv[])
-{    
+{
+    const char* recordPath = NULL;
+    const char* replayPath = NULL;
+    const char* digestPath = NULL;
+    int untilTick = -1;
+    
+    int i;
+    for (i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "-record") == 0 && i + 1 < argc)
+        {
+            recordPath = argv[++i];
+        }
+        else if (strcmp(argv[i], "-replay") == 0 && i + 1 < argc)
+        {
+            replayPath = argv[++i];
+        }
+        else if (strcmp(argv[i], "-until") == 0 && i + 1 < argc)
+        {
+            untilTick = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "-digest") == 0 && i + 1 < argc)
+        {
+            digestPath = argv[++i];
+        }
+        else
+        {
+            _Usage(argv[0]);
+            return 1;
+        }
+    }
+    
+    if (replayPath)
+    {
+        return _Replay(replayPath, untilTick, digestPath);
+    }
+    
     if (SDL_Init(SDL_INIT_VIDEO) == -1)
     {
         fprintf(stderr, "SDL init failed\n");
@@ -161,6 +368,23 @@ int main(int argc, char * argv[])
     
     Game_Init(&game);
 
+    ReplayWriter_t recorder;
+    
+    if (recordPath)
+    {
+        uint32_t seed = (uint32_t)time(NULL);
+        srand(seed);
+        
+        if (!ReplayWriter_Open(&recorder, recordPath, seed))
+        {
+            fprintf(stderr, "can't create %s\n", recordPath);
+            recordPath = NULL;
+        }
+        else
+        {
+            game.persistent = 0;
+        }
+    }
     
     for (;;)
     {
@@ -172,6 +396,11 @@ int main(int argc, char * argv[])
             switch (e.type)
             {
                 case SDL_QUIT:
+                    if (recordPath)
+                    {
+                        ReplayWriter_Close(&recorder);
+                    }
+                    
                     Game_Quit(&game);
                     SDL_Quit();
                     return 0;
@@ -185,14 +414,14 @@ int main(int argc, char * argv[])
                     if (game.state.mode == MODE_GAME)
                     {
                         SDL_GetRelativeMouseState(&x, &y);
-                        Game_MoveCamera(&game, (x / (float)_width),
-                                        (y / (float)_height));
+                        _lookX += x / (float)_width;
+                        _lookY += y / (float)_height;
                     }
                     else
                     {
-                        int x, y;
                         SDL_GetMouseState(&x, &y);
-                        Game_SetCursor(&game, x / (float)_width, y / (float)_height);
+                        _cursorX = x / (float)_width;
+                        _cursorY = y / (float)_height;
                     }
 
                     break;
@@ -209,23 +438,44 @@ int main(int argc, char * argv[])
             }
         }
         
+        ReplayTick_t tick;
+        tick.forward = _up - _down;
+        tick.side = _right - _left;
+        tick.buttons = (_space ? REPLAY_BUTTON_JUMP : 0) |
+                       (_click ? REPLAY_BUTTON_DIG : 0) |
+                       (_rightClick ? REPLAY_BUTTON_PLACE : 0);
+        tick.toggles = _toggles;
+        tick.lookX = _lookX;
+        tick.lookY = _lookY;
+        tick.cursorX = _cursorX;
+        tick.cursorY = _cursorY;
+        
+        tick.beltIndex = -1;
         for (int i = 0; i < 5; i ++)
         {
             if (_numbers[i])
             {
-                Game_SelectInventoryItem(&game, i);
+                tick.beltIndex = i;
             }
         }
         
-        game.forward = _up - _down;
-        game.side = _right - _left;
-        game.jumping = _space;
-        game.digging = _click;
-        game.placing = _rightClick;
-    
+        _toggles = 0;
+        _lookX = 0.0f;
+        _lookY = 0.0f;
         
+        Game_ApplyInput(&game, &tick);
         Game_Update(&game);
         
+        if (recordPath)
+        {
+            Player_t* players[1] = { &game.player };
+            
+            Digest_t digest;
+            Digest_Sim(&digest, &game.sim, players, 1);
+            
+            ReplayWriter_Tick(&recorder, &tick, digest.root);
+        }
+        
         SDL_SetRelativeMouseMode(game.state.mode == MODE_GAME);
         SDL_GL_SwapWindow(window);
         Game_Render(&game);
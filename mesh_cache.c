@@ -0,0 +1,271 @@
+
+#include "mesh_cache.h"
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+void MeshCache_Init(MeshCache_t* cache, size_t byteBudget)
+{
+    assert(cache);
+    
+    memset(cache->buckets, 0, sizeof(cache->buckets));
+    
+    cache->lruHead = NULL;
+    cache->lruTail = NULL;
+    
+    cache->unusedBytes = 0;
+    cache->byteBudget = byteBudget;
+    
+    cache->hits = 0;
+    cache->misses = 0;
+    
+    pthread_mutex_init(&cache->lock, NULL);
+}
+
+void MeshCache_Shutdown(MeshCache_t* cache)
+{
+    assert(cache);
+    
+    int i;
+    for (i = 0; i < MESH_CACHE_BUCKETS; ++i)
+    {
+        Mesh_t* mesh = cache->buckets[i];
+        while (mesh)
+        {
+            Mesh_t* next = mesh->bucketNext;
+            free(mesh->faces);
+            free(mesh);
+            mesh = next;
+        }
+        cache->buckets[i] = NULL;
+    }
+    
+    cache->lruHead = NULL;
+    cache->lruTail = NULL;
+    cache->unusedBytes = 0;
+    
+    pthread_mutex_destroy(&cache->lock);
+}
+
+static inline uint64_t _MeshCache_Mix(uint64_t hash, uint64_t word)
+{
+    hash ^= word * 0x87C37B91114253D5ULL;
+    hash = (hash << 31) | (hash >> 33);
+    return hash * 0x4CF5AD432745937FULL;
+}
+
+uint64_t MeshCache_Hash(uint64_t hash, const void* data, size_t size)
+{
+    const unsigned char* bytes = data;
+    
+    /* eight bytes at a time, the tail is padded with zeros */
+    while (size >= 8)
+    {
+        uint64_t word;
+        memcpy(&word, bytes, 8);
+        hash = _MeshCache_Mix(hash, word);
+        
+        bytes += 8;
+        size -= 8;
+    }
+    
+    if (size > 0)
+    {
+        uint64_t word = 0;
+        memcpy(&word, bytes, size);
+        hash = _MeshCache_Mix(hash, word);
+    }
+    
+    return hash;
+}
+
+static int _MeshCache_Bucket(uint64_t key)
+{
+    key ^= key >> 33;
+    key *= 0xFF51AFD7ED558CCDULL;
+    key ^= key >> 33;
+    return (int)(key % MESH_CACHE_BUCKETS);
+}
+
+static size_t _MeshCache_Bytes(const Mesh_t* mesh)
+{
+    return sizeof(Mesh_t) + sizeof(Face_t) * mesh->faceCount;
+}
+
+static void _MeshCache_Unlink(MeshCache_t* cache, Mesh_t* mesh)
+{
+    if (mesh->lruPrev) mesh->lruPrev->lruNext = mesh->lruNext;
+    else cache->lruHead = mesh->lruNext;
+    
+    if (mesh->lruNext) mesh->lruNext->lruPrev = mesh->lruPrev;
+    else cache->lruTail = mesh->lruPrev;
+    
+    mesh->lruPrev = NULL;
+    mesh->lruNext = NULL;
+    
+    cache->unusedBytes -= _MeshCache_Bytes(mesh);
+}
+
+static void _MeshCache_Evict(MeshCache_t* cache, Mesh_t* mesh)
+{
+    _MeshCache_Unlink(cache, mesh);
+    
+    Mesh_t** link = &cache->buckets[_MeshCache_Bucket(mesh->key)];
+    while (*link != mesh)
+    {
+        link = &(*link)->bucketNext;
+    }
+    *link = mesh->bucketNext;
+    
+    free(mesh->faces);
+    free(mesh);
+}
+
+/* must hold the lock */
+static Mesh_t* _MeshCache_Find(MeshCache_t* cache, uint64_t key)
+{
+    Mesh_t* mesh = cache->buckets[_MeshCache_Bucket(key)];
+    
+    while (mesh && mesh->key != key)
+    {
+        mesh = mesh->bucketNext;
+    }
+    
+    if (mesh && mesh->refCount++ == 0)
+    {
+        _MeshCache_Unlink(cache, mesh);
+    }
+    
+    return mesh;
+}
+
+Mesh_t* MeshCache_Acquire(MeshCache_t* cache, uint64_t key)
+{
+    assert(cache);
+    
+    pthread_mutex_lock(&cache->lock);
+    
+    Mesh_t* mesh = _MeshCache_Find(cache, key);
+    
+    if (mesh) ++cache->hits;
+    else ++cache->misses;
+    
+    pthread_mutex_unlock(&cache->lock);
+    
+    return mesh;
+}
+
+Mesh_t* MeshCache_Insert(MeshCache_t* cache,
+                         uint64_t key,
+                         int lod,
+                         const MeshBuild_t* build,
+                         int sectioned,
+                         const Chunk_t* source)
+{
+    assert(cache);
+    assert(build);
+    
+    /* copy outside the lock, it's only wasted if another thread got there first */
+    Mesh_t* mesh = malloc(sizeof(Mesh_t));
+    assert(mesh);
+    
+    mesh->key = key;
+    mesh->lod = lod;
+    mesh->faceCount = 0;
+    mesh->faces = NULL;
+    
+    int layer;
+    for (layer = 0; layer < BLOCK_LAYER_COUNT; ++layer)
+    {
+        assert(build->faceCounts[layer] >= 0 && build->faceCounts[layer] <= MESH_MAX_FACES);
+        
+        mesh->layerStarts[layer] = mesh->faceCount;
+        mesh->faceCount += build->faceCounts[layer];
+    }
+    mesh->layerStarts[BLOCK_LAYER_COUNT] = mesh->faceCount;
+    
+    if (mesh->faceCount > 0)
+    {
+        mesh->faces = malloc(sizeof(Face_t) * mesh->faceCount);
+        assert(mesh->faces);
+        
+        for (layer = 0; layer < BLOCK_LAYER_COUNT; ++layer)
+        {
+            memcpy(mesh->faces + mesh->layerStarts[layer], build->faces[layer], sizeof(Face_t) * build->faceCounts[layer]);
+        }
+    }
+    
+    memset(mesh->sectionStarts, 0, sizeof(mesh->sectionStarts));
+    
+    if (sectioned)
+    {
+        /* the mesh has every layer in one array, so starts are offset to where each layer landed */
+        for (layer = 0; layer < BLOCK_LAYER_COUNT; ++layer)
+        {
+            int i;
+            for (i = 0; i <= CHUNK_SECTION_COUNT; ++i)
+            {
+                mesh->sectionStarts[layer][i] = mesh->layerStarts[layer] + build->sectionStarts[layer][i];
+            }
+        }
+    }
+    
+    memcpy(mesh->faceLinks, source->faceLinks, sizeof(mesh->faceLinks));
+    memcpy(mesh->solidLayers, source->solidLayers, sizeof(mesh->solidLayers));
+    
+    mesh->refCount = 1;
+    mesh->lruPrev = NULL;
+    mesh->lruNext = NULL;
+    
+    pthread_mutex_lock(&cache->lock);
+    
+    Mesh_t* existing = _MeshCache_Find(cache, key);
+    
+    if (!existing)
+    {
+        int bucket = _MeshCache_Bucket(key);
+        mesh->bucketNext = cache->buckets[bucket];
+        cache->buckets[bucket] = mesh;
+    }
+    
+    pthread_mutex_unlock(&cache->lock);
+    
+    if (existing)
+    {
+        free(mesh->faces);
+        free(mesh);
+        return existing;
+    }
+    
+    return mesh;
+}
+
+void MeshCache_Release(MeshCache_t* cache, Mesh_t* mesh)
+{
+    assert(cache);
+    
+    if (!mesh) return;
+    
+    pthread_mutex_lock(&cache->lock);
+    
+    assert(mesh->refCount > 0);
+    
+    if (--mesh->refCount == 0)
+    {
+        mesh->lruPrev = NULL;
+        mesh->lruNext = cache->lruHead;
+        
+        if (cache->lruHead) cache->lruHead->lruPrev = mesh;
+        else cache->lruTail = mesh;
+        
+        cache->lruHead = mesh;
+        cache->unusedBytes += _MeshCache_Bytes(mesh);
+        
+        while (cache->unusedBytes > cache->byteBudget && cache->lruTail)
+        {
+            _MeshCache_Evict(cache, cache->lruTail);
+        }
+    }
+    
+    pthread_mutex_unlock(&cache->lock);
+}
@@ -0,0 +1,99 @@
+
+#ifndef ccraft_mesh_cache_h
+#define ccraft_mesh_cache_h
+
+#include "world.h"
+#include <stdint.h>
+#include <stddef.h>
+#include <pthread.h>
+
+/* chunk meshes shared between every chunk with the same key.
+ the key is a hash of everything the mesh was built from, so two chunks with the same key
+ can use the same faces. meshes nobody uses are kept, most recently released first,
+ until they take up more than the byte budget, so a chunk that goes back to an earlier state
+ or is loaded again can skip meshing.
+ safe to call from jobs */
+
+/* most faces a single layer of a chunk mesh can have */
+#define MESH_MAX_FACES 8192
+
+#define MESH_CACHE_BUCKETS 4096
+
+typedef struct Mesh
+{
+    uint64_t key;
+    int lod;
+    
+    /* faces of each block layer are kept together, layer l runs from layerStarts[l] to layerStarts[l + 1] */
+    Face_t* faces;
+    int faceCount;
+    int layerStarts[BLOCK_LAYER_COUNT + 1];
+    
+    /* full detail meshes have the faces of each layer grouped by chunk section, faces of section i
+     in layer l start at sectionStarts[l][i] and end at sectionStarts[l][i + 1]. all 0 for coarser meshes */
+    unsigned short sectionStarts[BLOCK_LAYER_COUNT][CHUNK_SECTION_COUNT + 1];
+    
+    /* chunk data that only depends on the blocks, saved so hits skip working it out again */
+    unsigned char faceLinks[6];
+    signed char solidLayers[3][2];
+    
+    /* chunks using the mesh. unused meshes are in the lru list */
+    int refCount;
+    
+    struct Mesh* bucketNext;
+    struct Mesh* lruPrev;
+    struct Mesh* lruNext;
+    
+} Mesh_t;
+
+/* faces of a mesh being built, kept apart by layer until it is added to the cache */
+typedef struct
+{
+    Face_t* faces[BLOCK_LAYER_COUNT];
+    int faceCounts[BLOCK_LAYER_COUNT];
+    
+    /* where each section begins within its layer, for full detail meshes */
+    unsigned short sectionStarts[BLOCK_LAYER_COUNT][CHUNK_SECTION_COUNT + 1];
+} MeshBuild_t;
+
+typedef struct
+{
+    Mesh_t* buckets[MESH_CACHE_BUCKETS];
+    
+    /* unused meshes, head was released most recently */
+    Mesh_t* lruHead;
+    Mesh_t* lruTail;
+    
+    size_t unusedBytes;
+    size_t byteBudget;
+    
+    int hits;
+    int misses;
+    
+    pthread_mutex_t lock;
+    
+} MeshCache_t;
+
+extern void MeshCache_Init(MeshCache_t* cache, size_t byteBudget);
+extern void MeshCache_Shutdown(MeshCache_t* cache);
+
+/* continues a hash with more data, start with MESH_HASH_SEED */
+#define MESH_HASH_SEED 0x9E3779B97F4A7C15ULL
+extern uint64_t MeshCache_Hash(uint64_t hash, const void* data, size_t size);
+
+/* returns the mesh for a key with a reference added, or NULL if there isn't one */
+extern Mesh_t* MeshCache_Acquire(MeshCache_t* cache, uint64_t key);
+
+/* copies the built faces, their section starts if sectioned is set, and the face links and solid layers
+ of the chunk they were built from into a new mesh with one reference. if another thread added the same key first
+ its mesh is returned instead */
+extern Mesh_t* MeshCache_Insert(MeshCache_t* cache,
+                                uint64_t key,
+                                int lod,
+                                const MeshBuild_t* build,
+                                int sectioned,
+                                const Chunk_t* source);
+
+extern void MeshCache_Release(MeshCache_t* cache, Mesh_t* mesh);
+
+#endif
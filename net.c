@@ -0,0 +1,225 @@
+
+#include "net.h"
+#include "endian.h"
+#include <string.h>
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+static struct sockaddr_in _Net_ToSockaddr(const NetAddress_t* address)
+{
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = address->host;
+    addr.sin_port = address->port;
+    return addr;
+}
+
+NetAddress_t Net_Loopback(int port)
+{
+    NetAddress_t address;
+    address.host = htonl(INADDR_LOOPBACK);
+    address.port = htons((uint16_t)port);
+    return address;
+}
+
+int Net_AddressEqual(const NetAddress_t* a, const NetAddress_t* b)
+{
+    return a->host == b->host && a->port == b->port;
+}
+
+int Net_Open(NetSocket_t* sock, int port)
+{
+    assert(sock);
+    
+    sock->bytesSent = 0;
+    sock->bytesReceived = 0;
+    sock->packetsSent = 0;
+    sock->packetsReceived = 0;
+    
+    sock->fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (sock->fd < 0) return 0;
+    
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons((uint16_t)port);
+    
+    if (bind(sock->fd, (struct sockaddr*)&addr, sizeof(addr)) < 0 ||
+        fcntl(sock->fd, F_SETFL, fcntl(sock->fd, F_GETFL, 0) | O_NONBLOCK) < 0)
+    {
+        close(sock->fd);
+        sock->fd = -1;
+        return 0;
+    }
+    
+    return 1;
+}
+
+void Net_Close(NetSocket_t* sock)
+{
+    assert(sock);
+    
+    if (sock->fd >= 0) close(sock->fd);
+    sock->fd = -1;
+}
+
+int Net_LocalPort(const NetSocket_t* sock)
+{
+    struct sockaddr_in addr;
+    socklen_t length = sizeof(addr);
+    
+    if (getsockname(sock->fd, (struct sockaddr*)&addr, &length) < 0) return 0;
+    
+    return ntohs(addr.sin_port);
+}
+
+int Net_Send(NetSocket_t* sock, const NetAddress_t* to, const void* data, int size)
+{
+    assert(size <= NET_MAX_PACKET);
+    
+    struct sockaddr_in addr = _Net_ToSockaddr(to);
+    
+    ssize_t sent = sendto(sock->fd, data, size, 0, (struct sockaddr*)&addr, sizeof(addr));
+    if (sent != size) return 0;
+    
+    sock->bytesSent += sent;
+    sock->packetsSent++;
+    return 1;
+}
+
+int Net_Receive(NetSocket_t* sock, NetAddress_t* from, void* data, int capacity)
+{
+    struct sockaddr_in addr;
+    socklen_t length = sizeof(addr);
+    
+    /* a refused send to a client that went away shows up here on some systems, skip past it */
+    for (;;)
+    {
+        ssize_t received = recvfrom(sock->fd, data, capacity, 0, (struct sockaddr*)&addr, &length);
+        
+        if (received < 0)
+        {
+            if (errno == ECONNREFUSED || errno == EINTR) continue;
+            return 0;
+        }
+        
+        from->host = addr.sin_addr.s_addr;
+        from->port = addr.sin_port;
+        
+        sock->bytesReceived += received;
+        sock->packetsReceived++;
+        return (int)received;
+    }
+}
+
+void NetWriter_Init(NetWriter_t* writer, void* data, int capacity)
+{
+    writer->data = data;
+    writer->size = 0;
+    writer->capacity = capacity;
+    writer->overflow = 0;
+}
+
+/* room for size more bytes, or NULL once the message is full */
+static unsigned char* _NetWriter_Reserve(NetWriter_t* writer, int size)
+{
+    if (writer->overflow || writer->size + size > writer->capacity)
+    {
+        writer->overflow = 1;
+        return NULL;
+    }
+    
+    unsigned char* p = writer->data + writer->size;
+    writer->size += size;
+    return p;
+}
+
+void NetWriter_U8(NetWriter_t* writer, uint8_t value)
+{
+    unsigned char* p = _NetWriter_Reserve(writer, 1);
+    if (p) *p = value;
+}
+
+void NetWriter_U16(NetWriter_t* writer, uint16_t value)
+{
+    unsigned char* p = _NetWriter_Reserve(writer, 2);
+    if (p) End_U16ToLittle(p, value);
+}
+
+void NetWriter_U32(NetWriter_t* writer, uint32_t value)
+{
+    unsigned char* p = _NetWriter_Reserve(writer, 4);
+    if (p) End_U32ToLittle(p, value);
+}
+
+void NetWriter_F32(NetWriter_t* writer, float value)
+{
+    unsigned char* p = _NetWriter_Reserve(writer, 4);
+    if (p) End_F32ToLittle(p, value);
+}
+
+void NetWriter_Bytes(NetWriter_t* writer, const void* data, int size)
+{
+    unsigned char* p = _NetWriter_Reserve(writer, size);
+    if (p) memcpy(p, data, size);
+}
+
+void NetReader_Init(NetReader_t* reader, const void* data, int size)
+{
+    reader->data = data;
+    reader->size = size;
+    reader->offset = 0;
+    reader->overflow = 0;
+}
+
+static const unsigned char* _NetReader_Take(NetReader_t* reader, int size)
+{
+    if (reader->overflow || reader->offset + size > reader->size)
+    {
+        reader->overflow = 1;
+        return NULL;
+    }
+    
+    const unsigned char* p = reader->data + reader->offset;
+    reader->offset += size;
+    return p;
+}
+
+uint8_t NetReader_U8(NetReader_t* reader)
+{
+    const unsigned char* p = _NetReader_Take(reader, 1);
+    return p ? *p : 0;
+}
+
+uint16_t NetReader_U16(NetReader_t* reader)
+{
+    const unsigned char* p = _NetReader_Take(reader, 2);
+    return p ? End_U16FromLittle(p) : 0;
+}
+
+uint32_t NetReader_U32(NetReader_t* reader)
+{
+    const unsigned char* p = _NetReader_Take(reader, 4);
+    return p ? End_U32FromLittle(p) : 0;
+}
+
+float NetReader_F32(NetReader_t* reader)
+{
+    const unsigned char* p = _NetReader_Take(reader, 4);
+    return p ? End_F32FromLittle(p) : 0.0f;
+}
+
+void NetReader_Bytes(NetReader_t* reader, void* data, int size)
+{
+    const unsigned char* p = _NetReader_Take(reader, size);
+    
+    if (p) memcpy(data, p, size);
+    else memset(data, 0, size);
+}
@@ -0,0 +1,99 @@
+
+#ifndef ccraft_net_h
+#define ccraft_net_h
+
+#include <stdint.h>
+
+/* unreliable datagrams over udp, shared by the server and its clients.
+ every message is one datagram starting with a message type byte.
+ values are written little endian (see endian.h) so both ends agree on any platform */
+
+#define NET_DEFAULT_PORT 27450
+
+/* largest datagram sent, small enough to avoid fragmentation on most links */
+#define NET_MAX_PACKET 1200
+
+enum
+{
+    /* client to server */
+    NET_MSG_CONNECT = 1,
+    NET_MSG_INPUT,
+    NET_MSG_DISCONNECT,
+    NET_MSG_CHUNK_ACK,
+    
+    /* server to client */
+    NET_MSG_WELCOME,
+    NET_MSG_STATE,
+    NET_MSG_REJECT,
+    NET_MSG_CHUNK,
+    NET_MSG_BLOCKS,
+    NET_MSG_ENTITIES,
+};
+
+typedef struct
+{
+    /* both in network order */
+    uint32_t host;
+    uint16_t port;
+} NetAddress_t;
+
+typedef struct
+{
+    int fd;
+    
+    uint64_t bytesSent;
+    uint64_t bytesReceived;
+    int packetsSent;
+    int packetsReceived;
+} NetSocket_t;
+
+extern NetAddress_t Net_Loopback(int port);
+extern int Net_AddressEqual(const NetAddress_t* a, const NetAddress_t* b);
+
+/* binds a non blocking socket to a port on every interface, 0 picks any free port.
+ returns 0 on failure */
+extern int Net_Open(NetSocket_t* sock, int port);
+extern void Net_Close(NetSocket_t* sock);
+
+/* port the socket ended up bound to */
+extern int Net_LocalPort(const NetSocket_t* sock);
+
+extern int Net_Send(NetSocket_t* sock, const NetAddress_t* to, const void* data, int size);
+
+/* the next waiting datagram, returns its size or 0 when there are none */
+extern int Net_Receive(NetSocket_t* sock, NetAddress_t* from, void* data, int capacity);
+
+/* builds a message in a fixed buffer. writes past the end are dropped and mark it overflowed */
+typedef struct
+{
+    unsigned char* data;
+    int size;
+    int capacity;
+    int overflow;
+} NetWriter_t;
+
+extern void NetWriter_Init(NetWriter_t* writer, void* data, int capacity);
+extern void NetWriter_U8(NetWriter_t* writer, uint8_t value);
+extern void NetWriter_U16(NetWriter_t* writer, uint16_t value);
+extern void NetWriter_U32(NetWriter_t* writer, uint32_t value);
+extern void NetWriter_F32(NetWriter_t* writer, float value);
+extern void NetWriter_Bytes(NetWriter_t* writer, const void* data, int size);
+
+/* reads a received message. reads past the end return 0 and mark it overflowed
+ so a short or corrupt datagram can be checked for once at the end */
+typedef struct
+{
+    const unsigned char* data;
+    int size;
+    int offset;
+    int overflow;
+} NetReader_t;
+
+extern void NetReader_Init(NetReader_t* reader, const void* data, int size);
+extern uint8_t NetReader_U8(NetReader_t* reader);
+extern uint16_t NetReader_U16(NetReader_t* reader);
+extern uint32_t NetReader_U32(NetReader_t* reader);
+extern float NetReader_F32(NetReader_t* reader);
+extern void NetReader_Bytes(NetReader_t* reader, void* data, int size);
+
+#endif
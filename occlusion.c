@@ -0,0 +1,468 @@
+#include "occlusion.h"
+#include <stdlib.h>
+#include <math.h>
+#include <float.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+void Occlusion_Clear(OcclusionBuffer_t* buffer, const Mat4_t* mvp, float near)
+{
+    memset(buffer->depth, 0, sizeof(buffer->depth));
+    memset(buffer->owner, 0xff, sizeof(buffer->owner));
+    Mat4_Copy(&buffer->mvp, mvp);
+    buffer->near = near;
+}
+
+/* screen position and 1 / w */
+typedef struct
+{
+    float x;
+    float y;
+    float depth;
+} ScreenVert_t;
+
+static ScreenVert_t _Occlusion_ToScreen(Vec4_t clip)
+{
+    float invW = 1.0f / clip.w;
+    
+    ScreenVert_t vert;
+    vert.x = (clip.x * invW * 0.5f + 0.5f) * OCCLUSION_WIDTH;
+    vert.y = (clip.y * invW * 0.5f + 0.5f) * OCCLUSION_HEIGHT;
+    vert.depth = invW;
+    return vert;
+}
+
+static void _Occlusion_DrawTriangle(OcclusionBuffer_t* buffer, ScreenVert_t v0, ScreenVert_t v1, ScreenVert_t v2, int owner)
+{
+    float area = (v1.x - v0.x) * (v2.y - v0.y) - (v1.y - v0.y) * (v2.x - v0.x);
+    if (fabsf(area) < 1e-6f) return;
+    
+    /* occluders are two sided, flip to counter clockwise */
+    if (area < 0.0f)
+    {
+        ScreenVert_t temp = v1;
+        v1 = v2;
+        v2 = temp;
+        area = -area;
+    }
+    
+    float minX = fminf(v0.x, fminf(v1.x, v2.x));
+    float maxX = fmaxf(v0.x, fmaxf(v1.x, v2.x));
+    float minY = fminf(v0.y, fminf(v1.y, v2.y));
+    float maxY = fmaxf(v0.y, fmaxf(v1.y, v2.y));
+    
+    int x0 = (int)floorf(minX);
+    int x1 = (int)ceilf(maxX);
+    int y0 = (int)floorf(minY);
+    int y1 = (int)ceilf(maxY);
+    
+    if (x0 < 0) x0 = 0;
+    if (y0 < 0) y0 = 0;
+    if (x1 > OCCLUSION_WIDTH) x1 = OCCLUSION_WIDTH;
+    if (y1 > OCCLUSION_HEIGHT) y1 = OCCLUSION_HEIGHT;
+    if (x0 >= x1 || y0 >= y1) return;
+    
+    /* rows are processed 4 pixels at a time */
+    x0 &= ~3;
+    
+    /* edge functions a * x + b * y + c are positive inside */
+    const ScreenVert_t* verts[3] = {&v0, &v1, &v2};
+    float edgeA[3];
+    float edgeB[3];
+    float edgeC[3];
+    
+    int i;
+    for (i = 0; i < 3; ++i)
+    {
+        const ScreenVert_t* from = verts[i];
+        const ScreenVert_t* to = verts[(i + 1) % 3];
+        
+        edgeA[i] = from->y - to->y;
+        edgeB[i] = to->x - from->x;
+        edgeC[i] = -edgeA[i] * from->x - edgeB[i] * from->y;
+    }
+    
+    /* depth is a plane in screen space. pushing it back by its slope across half a pixel
+     keeps it behind the real surface everywhere in the pixel, not just at the center */
+    float invArea = 1.0f / area;
+    float depthX = ((v1.depth - v0.depth) * (v2.y - v0.y) - (v2.depth - v0.depth) * (v1.y - v0.y)) * invArea;
+    float depthY = ((v2.depth - v0.depth) * (v1.x - v0.x) - (v1.depth - v0.depth) * (v2.x - v0.x)) * invArea;
+    float depthC = v0.depth - depthX * v0.x - depthY * v0.y - 0.5f * (fabsf(depthX) + fabsf(depthY));
+    
+    int x, y;
+
+#if defined(__SSE2__)
+    const __m128 laneOffsets = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128i owners = _mm_set1_epi32(owner);
+    
+    for (y = y0; y < y1; ++y)
+    {
+        float py = y + 0.5f;
+        
+        __m128 rowEdge0 = _mm_set1_ps(edgeB[0] * py + edgeC[0]);
+        __m128 rowEdge1 = _mm_set1_ps(edgeB[1] * py + edgeC[1]);
+        __m128 rowEdge2 = _mm_set1_ps(edgeB[2] * py + edgeC[2]);
+        __m128 rowDepth = _mm_set1_ps(depthY * py + depthC);
+        
+        float* row = buffer->depth + y * OCCLUSION_WIDTH;
+        int* rowOwner = buffer->owner + y * OCCLUSION_WIDTH;
+        
+        for (x = x0; x < x1; x += 4)
+        {
+            __m128 px = _mm_add_ps(_mm_set1_ps((float)x), laneOffsets);
+            
+            __m128 e0 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(edgeA[0]), px), rowEdge0);
+            __m128 e1 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(edgeA[1]), px), rowEdge1);
+            __m128 e2 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(edgeA[2]), px), rowEdge2);
+            
+            __m128 inside = _mm_and_ps(_mm_cmpge_ps(e0, zero), _mm_and_ps(_mm_cmpge_ps(e1, zero), _mm_cmpge_ps(e2, zero)));
+            if (_mm_movemask_ps(inside) == 0) continue;
+            
+            __m128 depth = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(depthX), px), rowDepth);
+            __m128 old = _mm_loadu_ps(row + x);
+            __m128 nearer = _mm_and_ps(inside, _mm_cmpgt_ps(depth, old));
+            
+            _mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(nearer, depth), _mm_andnot_ps(nearer, old)));
+            
+            __m128i oldOwner = _mm_loadu_si128((const __m128i*)(rowOwner + x));
+            __m128i nearerBits = _mm_castps_si128(nearer);
+            _mm_storeu_si128((__m128i*)(rowOwner + x),
+                             _mm_or_si128(_mm_and_si128(nearerBits, owners), _mm_andnot_si128(nearerBits, oldOwner)));
+        }
+    }
+#else
+    for (y = y0; y < y1; ++y)
+    {
+        float py = y + 0.5f;
+        float* row = buffer->depth + y * OCCLUSION_WIDTH;
+        int* rowOwner = buffer->owner + y * OCCLUSION_WIDTH;
+        
+        for (x = x0; x < x1; ++x)
+        {
+            float px = x + 0.5f;
+            
+            if (edgeA[0] * px + edgeB[0] * py + edgeC[0] < 0.0f) continue;
+            if (edgeA[1] * px + edgeB[1] * py + edgeC[1] < 0.0f) continue;
+            if (edgeA[2] * px + edgeB[2] * py + edgeC[2] < 0.0f) continue;
+            
+            float depth = depthX * px + depthY * py + depthC;
+            if (depth > row[x])
+            {
+                row[x] = depth;
+                rowOwner[x] = owner;
+            }
+        }
+    }
+#endif
+}
+
+void Occlusion_DrawQuad(OcclusionBuffer_t* buffer, Vec3_t a, Vec3_t b, Vec3_t c, Vec3_t d, int owner)
+{
+    Vec3_t corners[4] = {a, b, c, d};
+    
+    /* clip to the near plane in clip space, a quad can gain one corner */
+    Vec4_t clip[4];
+    Vec4_t clipped[5];
+    int count = 0;
+    
+    int i;
+    for (i = 0; i < 4; ++i)
+    {
+        clip[i] = Mat4_MultVec4(&buffer->mvp, Vec4_Create(corners[i].x, corners[i].y, corners[i].z, 1.0f));
+    }
+    
+    for (i = 0; i < 4; ++i)
+    {
+        Vec4_t from = clip[i];
+        Vec4_t to = clip[(i + 1) % 4];
+        
+        int fromInside = from.w >= buffer->near;
+        int toInside = to.w >= buffer->near;
+        
+        if (fromInside) clipped[count++] = from;
+        
+        if (fromInside != toInside)
+        {
+            float t = (buffer->near - from.w) / (to.w - from.w);
+            clipped[count++] = Vec4_Add(from, Vec4_Scale(Vec4_Sub(to, from), t));
+        }
+    }
+    
+    if (count < 3) return;
+    
+    ScreenVert_t screen[5];
+    for (i = 0; i < count; ++i)
+    {
+        screen[i] = _Occlusion_ToScreen(clipped[i]);
+    }
+    
+    for (i = 1; i < count - 1; ++i)
+    {
+        _Occlusion_DrawTriangle(buffer, screen[0], screen[i], screen[i + 1], owner);
+    }
+}
+
+int Occlusion_BoxVisible(const OcclusionBuffer_t* buffer, AABB_t box, int owner)
+{
+    float minX = FLT_MAX;
+    float maxX = -FLT_MAX;
+    float minY = FLT_MAX;
+    float maxY = -FLT_MAX;
+    float nearest = 0.0f;
+    
+    int i;
+    for (i = 0; i < 8; ++i)
+    {
+        Vec4_t corner = Vec4_Create((i & 1) ? box.max.x : box.min.x,
+                                    (i & 2) ? box.max.y : box.min.y,
+                                    (i & 4) ? box.max.z : box.min.z,
+                                    1.0f);
+        
+        Vec4_t clip = Mat4_MultVec4(&buffer->mvp, corner);
+        
+        /* crosses the near plane - too close to bother testing */
+        if (clip.w < buffer->near) return 1;
+        
+        ScreenVert_t screen = _Occlusion_ToScreen(clip);
+        
+        minX = fminf(minX, screen.x);
+        maxX = fmaxf(maxX, screen.x);
+        minY = fminf(minY, screen.y);
+        maxY = fmaxf(maxY, screen.y);
+        nearest = fmaxf(nearest, screen.depth);
+    }
+    
+    int x0 = (int)floorf(minX);
+    int x1 = (int)floorf(maxX) + 1;
+    int y0 = (int)floorf(minY);
+    int y1 = (int)floorf(maxY) + 1;
+    
+    if (x0 < 0) x0 = 0;
+    if (y0 < 0) y0 = 0;
+    if (x1 > OCCLUSION_WIDTH) x1 = OCCLUSION_WIDTH;
+    if (y1 > OCCLUSION_HEIGHT) y1 = OCCLUSION_HEIGHT;
+    
+    /* entirely off screen */
+    if (x0 >= x1 || y0 >= y1) return 0;
+    
+    /* widening to whole groups of 4 only tests extra pixels, which can't hide anything */
+    x0 &= ~3;
+    x1 = (x1 + 3) & ~3;
+    
+    int x, y;
+
+#if defined(__SSE2__)
+    const __m128 boxDepth = _mm_set1_ps(nearest);
+    const __m128i owners = _mm_set1_epi32(owner);
+    
+    for (y = y0; y < y1; ++y)
+    {
+        const float* row = buffer->depth + y * OCCLUSION_WIDTH;
+        const int* rowOwner = buffer->owner + y * OCCLUSION_WIDTH;
+        
+        for (x = x0; x < x1; x += 4)
+        {
+            __m128 behind = _mm_cmplt_ps(_mm_loadu_ps(row + x), boxDepth);
+            __m128i own = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i*)(rowOwner + x)), owners);
+            
+            if (_mm_movemask_ps(_mm_or_ps(behind, _mm_castsi128_ps(own)))) return 1;
+        }
+    }
+#else
+    for (y = y0; y < y1; ++y)
+    {
+        const float* row = buffer->depth + y * OCCLUSION_WIDTH;
+        const int* rowOwner = buffer->owner + y * OCCLUSION_WIDTH;
+        
+        for (x = x0; x < x1; ++x)
+        {
+            if (row[x] < nearest || rowOwner[x] == owner) return 1;
+        }
+    }
+#endif
+    
+    return 0;
+}
+
+void Occlusion_FindSolidLayers(Chunk_t* chunk)
+{
+    /* opaque blocks in each layer along each axis, a full layer has a whole slice */
+    int counts[3][CHUNK_SIZE];
+    memset(counts, 0, sizeof(counts));
+    
+    int x, y, z;
+    for (x = 0; x < CHUNK_SIZE; ++x)
+    {
+        for (y = 0; y < CHUNK_SIZE; ++y)
+        {
+            for (z = 0; z < CHUNK_SIZE; ++z)
+            {
+                int solid = Block_Opaque(chunk->blocks[x][y][z].type);
+                counts[0][x] += solid;
+                counts[1][y] += solid;
+                counts[2][z] += solid;
+            }
+        }
+    }
+    
+    int axis;
+    for (axis = 0; axis < 3; ++axis)
+    {
+        int bestStart = -1;
+        int bestLength = 0;
+        int runStart = 0;
+        
+        int i;
+        for (i = 0; i < CHUNK_SIZE; ++i)
+        {
+            if (counts[axis][i] != CHUNK_SIZE * CHUNK_SIZE)
+            {
+                runStart = i + 1;
+            }
+            else if (i - runStart + 1 > bestLength)
+            {
+                bestStart = runStart;
+                bestLength = i - runStart + 1;
+            }
+        }
+        
+        chunk->solidLayers[axis][0] = bestStart;
+        chunk->solidLayers[axis][1] = bestStart + bestLength - 1;
+    }
+}
+
+/* draws the faces of a solid box that point toward the camera */
+static void _Occlusion_DrawBox(OcclusionBuffer_t* buffer, const Cam_t* cam, AABB_t box, int owner)
+{
+    int axis;
+    for (axis = 0; axis < 3; ++axis)
+    {
+        int u = (axis + 1) % 3;
+        int v = (axis + 2) % 3;
+        
+        float plane;
+        
+        if (cam->position.data[axis] < box.min.data[axis])
+        {
+            plane = box.min.data[axis];
+        }
+        else if (cam->position.data[axis] > box.max.data[axis])
+        {
+            plane = box.max.data[axis];
+        }
+        else
+        {
+            continue;
+        }
+        
+        Vec3_t corners[4];
+        
+        int i;
+        for (i = 0; i < 4; ++i)
+        {
+            corners[i].data[axis] = plane;
+            corners[i].data[u] = (i == 1 || i == 2) ? box.max.data[u] : box.min.data[u];
+            corners[i].data[v] = (i >= 2) ? box.max.data[v] : box.min.data[v];
+        }
+        
+        Occlusion_DrawQuad(buffer, corners[0], corners[1], corners[2], corners[3], owner);
+    }
+}
+
+typedef struct
+{
+    float distance;
+    int index;
+} OccluderCandidate_t;
+
+static int _Occlusion_CompareCandidates(const void* a, const void* b)
+{
+    float da = ((const OccluderCandidate_t*)a)->distance;
+    float db = ((const OccluderCandidate_t*)b)->distance;
+    return (da > db) - (da < db);
+}
+
+/* only used on the main thread, so reused between frames */
+static OcclusionBuffer_t _buffer;
+static OccluderCandidate_t* _candidates;
+static int _candidateCapacity;
+
+void Occlusion_CullChunks(World_t* world, const Cam_t* cam)
+{
+    Mat4_t mvp;
+    Mat4_Mult(Cam_ProjectionMat(cam), Cam_ViewMat(cam), &mvp);
+    Occlusion_Clear(&_buffer, &mvp, cam->near);
+    
+    if (world->visibleCount > _candidateCapacity)
+    {
+        _candidateCapacity = world->visibleCount;
+        _candidates = realloc(_candidates, sizeof(OccluderCandidate_t) * _candidateCapacity);
+        assert(_candidates);
+    }
+    
+    int candidateCount = 0;
+    
+    int i;
+    for (i = 0; i < world->visibleCount; ++i)
+    {
+        const Chunk_t* chunk = world->chunks + world->visibleChunks[i];
+        
+        if (chunk->solidLayers[0][0] < 0 && chunk->solidLayers[1][0] < 0 && chunk->solidLayers[2][0] < 0) continue;
+        
+        OccluderCandidate_t* candidate = _candidates + candidateCount++;
+        candidate->distance = Vec3_Dist(chunk->boundingSphere.position, cam->position);
+        candidate->index = world->visibleChunks[i];
+    }
+    
+    qsort(_candidates, candidateCount, sizeof(OccluderCandidate_t), _Occlusion_CompareCandidates);
+    
+    if (candidateCount > OCCLUSION_MAX_OCCLUDERS) candidateCount = OCCLUSION_MAX_OCCLUDERS;
+    
+    for (i = 0; i < candidateCount; ++i)
+    {
+        const Chunk_t* chunk = world->chunks + _candidates[i].index;
+        
+        /* each run of solid layers is a box spanning the whole chunk on the other two axes */
+        int axis;
+        for (axis = 0; axis < 3; ++axis)
+        {
+            if (chunk->solidLayers[axis][0] < 0) continue;
+            
+            AABB_t box = AABB_Create(chunk->worldPosition, Vec3_Add(chunk->worldPosition, Vec3_Create(CHUNK_SIZE, CHUNK_SIZE, CHUNK_SIZE)));
+            box.min.data[axis] += chunk->solidLayers[axis][0];
+            box.max.data[axis] = chunk->worldPosition.data[axis] + chunk->solidLayers[axis][1] + 1;
+            
+            Vec3_t inset = Vec3_Clear(OCCLUSION_INSET);
+            box = AABB_Create(Vec3_Add(box.min, inset), Vec3_Sub(box.max, inset));
+            
+            _Occlusion_DrawBox(&_buffer, cam, box, _candidates[i].index);
+            
+            /* a completely solid chunk gives the same box for every axis */
+            if (chunk->opaqueCount == CHUNK_VOLUME) break;
+        }
+    }
+    
+    int count = 0;
+    for (i = 0; i < world->visibleCount; ++i)
+    {
+        int index = world->visibleChunks[i];
+        const Chunk_t* chunk = world->chunks + index;
+        
+        AABB_t bounds = AABB_Create(chunk->worldPosition, Vec3_Add(chunk->worldPosition, Vec3_Create(CHUNK_SIZE, CHUNK_SIZE, CHUNK_SIZE)));
+        
+        if (Occlusion_BoxVisible(&_buffer, bounds, index))
+        {
+            world->visibleChunks[count++] = index;
+        }
+        else
+        {
+            --world->cullStats.drawn;
+            ++world->cullStats.depthCulled;
+        }
+    }
+    
+    world->visibleCount = count;
+}
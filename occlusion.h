@@ -0,0 +1,53 @@
+
+#ifndef ccraft_occlusion_h
+#define ccraft_occlusion_h
+
+#include "vec_math.h"
+#include "geo.h"
+#include "cam.h"
+#include "world.h"
+
+/* software occlusion culling.
+ solid boxes inside the nearest visible chunks are rasterized into a small depth buffer
+ on the cpu, then each chunk's bounds are tested against it before meshing or drawing.
+ depth is stored as 1 / w which interpolates linearly across the screen, so larger is nearer */
+
+#define OCCLUSION_WIDTH 128
+#define OCCLUSION_HEIGHT 96
+
+/* how many of the closest chunks are drawn as occluders each frame */
+#define OCCLUSION_MAX_OCCLUDERS 48
+
+/* occluder boxes are pulled in by this much so faces that share a plane with a chunk's bounds,
+ its own or a neighbour's, are always behind it and never hide it at equal depth */
+#define OCCLUSION_INSET 0.01f
+
+typedef struct
+{
+    float depth[OCCLUSION_WIDTH * OCCLUSION_HEIGHT];
+    
+    /* which owner drew the nearest depth at each pixel, -1 where nothing has */
+    int owner[OCCLUSION_WIDTH * OCCLUSION_HEIGHT];
+    
+    Mat4_t mvp;
+    float near;
+} OcclusionBuffer_t;
+
+extern void Occlusion_Clear(OcclusionBuffer_t* buffer, const Mat4_t* mvp, float near);
+
+/* quads are drawn from both sides and clipped against the near plane.
+ owner tags the pixels the quad ends up nearest at, -1 for none */
+extern void Occlusion_DrawQuad(OcclusionBuffer_t* buffer, Vec3_t a, Vec3_t b, Vec3_t c, Vec3_t d, int owner);
+
+/* 0 only if every pixel the box covers already has something nearer in front of it.
+ pixels drawn by owner count as visible, so a chunk is never hidden by its own occluders */
+extern int Occlusion_BoxVisible(const OcclusionBuffer_t* buffer, AABB_t box, int owner);
+
+/* finds the longest run of fully solid layers along each axis.
+ each run is a solid box that can be drawn as an occluder */
+extern void Occlusion_FindSolidLayers(Chunk_t* chunk);
+
+/* removes chunks from world->visibleChunks that are hidden behind the solid layers of nearer chunks */
+extern void Occlusion_CullChunks(World_t* world, const Cam_t* cam);
+
+#endif
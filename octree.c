@@ -0,0 +1,289 @@
+
+#include "octree.h"
+#include <stdlib.h>
+#include <assert.h>
+
+void Octree_Init(Octree_t* tree, float cellSize)
+{
+    assert(tree);
+    assert(cellSize > 0.0f);
+    
+    tree->cellSize = cellSize;
+    
+    tree->nodes = NULL;
+    tree->nodeCount = 0;
+    tree->nodeCapacity = 0;
+    
+    tree->leaves = NULL;
+    tree->leafCount = 0;
+    tree->leafCapacity = 0;
+    
+    tree->root = -1;
+    tree->valueCount = 0;
+}
+
+void Octree_Shutdown(Octree_t* tree)
+{
+    assert(tree);
+    
+    free(tree->nodes);
+    free(tree->leaves);
+    
+    tree->nodes = NULL;
+    tree->leaves = NULL;
+    tree->nodeCount = 0;
+    tree->nodeCapacity = 0;
+    tree->leafCount = 0;
+    tree->leafCapacity = 0;
+    tree->root = -1;
+    tree->valueCount = 0;
+}
+
+/* nodes move when the array grows so callers hold indices, not pointers */
+static int _Octree_AddNode(Octree_t* tree, int x, int y, int z, int size)
+{
+    if (tree->nodeCount == tree->nodeCapacity)
+    {
+        tree->nodeCapacity = (tree->nodeCapacity > 0) ? tree->nodeCapacity * 2 : 64;
+        tree->nodes = realloc(tree->nodes, sizeof(OctreeNode_t) * tree->nodeCapacity);
+        assert(tree->nodes);
+    }
+    
+    OctreeNode_t* node = tree->nodes + tree->nodeCount;
+    node->x = x;
+    node->y = y;
+    node->z = z;
+    node->size = size;
+    node->leaf = -1;
+    
+    int i;
+    for (i = 0; i < 8; ++i)
+    {
+        node->children[i] = -1;
+    }
+    
+    if (size == OCTREE_LEAF_SIZE)
+    {
+        if (tree->leafCount == tree->leafCapacity)
+        {
+            tree->leafCapacity = (tree->leafCapacity > 0) ? tree->leafCapacity * 2 : 64;
+            tree->leaves = realloc(tree->leaves, sizeof(OctreeLeaf_t) * tree->leafCapacity);
+            assert(tree->leaves);
+        }
+        
+        tree->leaves[tree->leafCount].count = 0;
+        node->leaf = tree->leafCount++;
+    }
+    
+    return tree->nodeCount++;
+}
+
+static int _Octree_Contains(const OctreeNode_t* node, int x, int y, int z)
+{
+    return x >= node->x && x < node->x + node->size &&
+           y >= node->y && y < node->y + node->size &&
+           z >= node->z && z < node->z + node->size;
+}
+
+/* which child of a node a cell falls in, one bit per axis */
+static int _Octree_ChildIndex(const OctreeNode_t* node, int x, int y, int z)
+{
+    int half = node->size / 2;
+    
+    return ((x >= node->x + half) ? 1 : 0) |
+           ((y >= node->y + half) ? 2 : 0) |
+           ((z >= node->z + half) ? 4 : 0);
+}
+
+static int _Octree_FloorTo(int value, int size)
+{
+    return (value >= 0) ? (value / size) * size : -((-value + size - 1) / size) * size;
+}
+
+void Octree_Insert(Octree_t* tree, int x, int y, int z, int value)
+{
+    assert(tree);
+    
+    if (tree->root < 0)
+    {
+        tree->root = _Octree_AddNode(tree,
+                                     _Octree_FloorTo(x, OCTREE_LEAF_SIZE),
+                                     _Octree_FloorTo(y, OCTREE_LEAF_SIZE),
+                                     _Octree_FloorTo(z, OCTREE_LEAF_SIZE),
+                                     OCTREE_LEAF_SIZE);
+    }
+    
+    /* double the root toward the cell until it fits, the old root becomes one of the children */
+    while (!_Octree_Contains(tree->nodes + tree->root, x, y, z))
+    {
+        const OctreeNode_t* old = tree->nodes + tree->root;
+        
+        int size = old->size;
+        int rootX = (x < old->x) ? old->x - size : old->x;
+        int rootY = (y < old->y) ? old->y - size : old->y;
+        int rootZ = (z < old->z) ? old->z - size : old->z;
+        
+        int oldIndex = tree->root;
+        int root = _Octree_AddNode(tree, rootX, rootY, rootZ, size * 2);
+        
+        OctreeNode_t* node = tree->nodes + root;
+        const OctreeNode_t* child = tree->nodes + oldIndex;
+        node->children[_Octree_ChildIndex(node, child->x, child->y, child->z)] = oldIndex;
+        
+        tree->root = root;
+    }
+    
+    int index = tree->root;
+    while (tree->nodes[index].leaf < 0)
+    {
+        const OctreeNode_t* node = tree->nodes + index;
+        
+        int slot = _Octree_ChildIndex(node, x, y, z);
+        int child = node->children[slot];
+        
+        if (child < 0)
+        {
+            int half = node->size / 2;
+            int childX = node->x + ((slot & 1) ? half : 0);
+            int childY = node->y + ((slot & 2) ? half : 0);
+            int childZ = node->z + ((slot & 4) ? half : 0);
+            
+            child = _Octree_AddNode(tree, childX, childY, childZ, half);
+            tree->nodes[index].children[slot] = child;
+        }
+        
+        index = child;
+    }
+    
+    OctreeLeaf_t* leaf = tree->leaves + tree->nodes[index].leaf;
+    assert(leaf->count < OCTREE_LEAF_CAPACITY);
+    
+    leaf->centers[0][leaf->count] = (x + 0.5f) * tree->cellSize;
+    leaf->centers[1][leaf->count] = (y + 0.5f) * tree->cellSize;
+    leaf->centers[2][leaf->count] = (z + 0.5f) * tree->cellSize;
+    leaf->values[leaf->count] = value;
+    leaf->count++;
+    
+    tree->valueCount++;
+}
+
+int Octree_Find(const Octree_t* tree, int x, int y, int z)
+{
+    assert(tree);
+    
+    int index = tree->root;
+    if (index < 0 || !_Octree_Contains(tree->nodes + index, x, y, z)) return -1;
+    
+    while (tree->nodes[index].leaf < 0)
+    {
+        const OctreeNode_t* node = tree->nodes + index;
+        
+        index = node->children[_Octree_ChildIndex(node, x, y, z)];
+        if (index < 0) return -1;
+    }
+    
+    const OctreeLeaf_t* leaf = tree->leaves + tree->nodes[index].leaf;
+    
+    /* centers are stored instead of cells, compare against the center of the one being looked for */
+    float centerX = (x + 0.5f) * tree->cellSize;
+    float centerY = (y + 0.5f) * tree->cellSize;
+    float centerZ = (z + 0.5f) * tree->cellSize;
+    
+    int i;
+    for (i = 0; i < leaf->count; ++i)
+    {
+        if (leaf->centers[0][i] == centerX &&
+            leaf->centers[1][i] == centerY &&
+            leaf->centers[2][i] == centerZ)
+        {
+            return leaf->values[i];
+        }
+    }
+    
+    return -1;
+}
+
+/* everything below a node that is entirely in view */
+static int _Octree_Collect(const Octree_t* tree, int index, int* out)
+{
+    const OctreeNode_t* node = tree->nodes + index;
+    
+    if (node->leaf >= 0)
+    {
+        const OctreeLeaf_t* leaf = tree->leaves + node->leaf;
+        
+        int i;
+        for (i = 0; i < leaf->count; ++i)
+        {
+            out[i] = leaf->values[i];
+        }
+        return leaf->count;
+    }
+    
+    int count = 0;
+    
+    int i;
+    for (i = 0; i < 8; ++i)
+    {
+        if (node->children[i] >= 0) count += _Octree_Collect(tree, node->children[i], out + count);
+    }
+    
+    return count;
+}
+
+static int _Octree_Cull(const Octree_t* tree, const Cam_t* cam, int index, int planeMask, int* out)
+{
+    const OctreeNode_t* node = tree->nodes + index;
+    
+    float halfSize = node->size * tree->cellSize * 0.5f;
+    Vec3_t center = Vec3_Create(node->x * tree->cellSize + halfSize,
+                                node->y * tree->cellSize + halfSize,
+                                node->z * tree->cellSize + halfSize);
+    
+    planeMask = Cam_CubeClip(cam, center, halfSize, planeMask);
+    
+    if (planeMask < 0) return 0;
+    if (planeMask == 0) return _Octree_Collect(tree, index, out);
+    
+    if (node->leaf >= 0)
+    {
+        const OctreeLeaf_t* leaf = tree->leaves + node->leaf;
+        
+        int count = Cam_CubesVisible(cam,
+                                     leaf->centers[0],
+                                     leaf->centers[1],
+                                     leaf->centers[2],
+                                     leaf->count,
+                                     tree->cellSize * 0.5f,
+                                     planeMask,
+                                     out);
+        
+        /* turn positions in the leaf into values */
+        int i;
+        for (i = 0; i < count; ++i)
+        {
+            out[i] = leaf->values[out[i]];
+        }
+        return count;
+    }
+    
+    int count = 0;
+    
+    int i;
+    for (i = 0; i < 8; ++i)
+    {
+        if (node->children[i] >= 0) count += _Octree_Cull(tree, cam, node->children[i], planeMask, out + count);
+    }
+    
+    return count;
+}
+
+int Octree_CullFrustum(const Octree_t* tree, const Cam_t* cam, int* out)
+{
+    assert(tree);
+    assert(cam);
+    
+    if (tree->root < 0) return 0;
+    
+    return _Octree_Cull(tree, cam, tree->root, CAM_ALL_PLANES, out);
+}
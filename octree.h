@@ -0,0 +1,71 @@
+#ifndef ccraft_octree_h
+#define ccraft_octree_h
+
+#include "vec_math.h"
+#include "cam.h"
+
+/* octree over integer cells for culling large numbers of cubes.
+ the root grows outward as cells are added so it can cover any range of coordinates.
+ leaves are buckets of nearby cells with their centers stored by axis for the batched frustum test */
+
+/* cells per side of a leaf bucket */
+#define OCTREE_LEAF_SIZE 4
+#define OCTREE_LEAF_CAPACITY (OCTREE_LEAF_SIZE * OCTREE_LEAF_SIZE * OCTREE_LEAF_SIZE)
+
+typedef struct
+{
+    /* lowest cell covered and width in cells, always a power of two times the leaf size */
+    int x;
+    int y;
+    int z;
+    int size;
+    
+    /* node indices, -1 when empty. unused by leaves */
+    int children[8];
+    
+    /* index into leaves or -1 for inner nodes */
+    int leaf;
+} OctreeNode_t;
+
+typedef struct
+{
+    float centers[3][OCTREE_LEAF_CAPACITY];
+    int values[OCTREE_LEAF_CAPACITY];
+    int count;
+} OctreeLeaf_t;
+
+typedef struct
+{
+    float cellSize;
+    
+    OctreeNode_t* nodes;
+    int nodeCount;
+    int nodeCapacity;
+    
+    OctreeLeaf_t* leaves;
+    int leafCount;
+    int leafCapacity;
+    
+    /* -1 while empty */
+    int root;
+    
+    int valueCount;
+    
+} Octree_t;
+
+/* cell x covers world space from x * cellSize to (x + 1) * cellSize */
+extern void Octree_Init(Octree_t* tree, float cellSize);
+extern void Octree_Shutdown(Octree_t* tree);
+
+/* cells should only be inserted once */
+extern void Octree_Insert(Octree_t* tree, int x, int y, int z, int value);
+
+/* value stored for a cell or -1 if there isn't one */
+extern int Octree_Find(const Octree_t* tree, int x, int y, int z);
+
+/* writes the values of every cell in the camera's frustum to out and returns how many there are.
+ out must have room for every value in the tree. nodes outside a plane are skipped whole
+ and nodes inside a plane don't test it again for anything below them */
+extern int Octree_CullFrustum(const Octree_t* tree, const Cam_t* cam, int* out);
+
+#endif
@@ -1,60 +1,119 @@
 
 #include "renderer.h"
-#include "targa.h"
+#include "atlas.h"
+#include "mesh_cache.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
 
-static GLuint Renderer_Upload(Renderer_t* renderer, short w, short h, int rgba, const GLubyte* data)
+static const AtlasSource_t BlockAtlasSource =
+{
+    "data/block_textures.tga",
+    "data/block_textures.atlas",
+    BLOCK_ATLAS_ROWS,
+    -1,
+};
+
+/* item icons are drawn on this colour where they should be see through */
+static const AtlasSource_t ItemAtlasSource =
+{
+    "data/item_textures.tga",
+    "data/item_textures.atlas",
+    ITEM_ATLAS_ROWS,
+    0xDD17CD,
+};
+
+/* the last item tile is unused in the image and painted opaque white once uploaded,
+ so untextured hud quads can be drawn with the item atlas in the same call as the icons */
+#define ITEM_ATLAS_WHITE_TILE (ITEM_ATLAS_ROWS * ITEM_ATLAS_ROWS - 1)
+
+static GLuint Renderer_Upload(Renderer_t* renderer, const Atlas_t* atlas)
 {
     GLuint tex;
     glGenTextures(1, &tex);
     glBindTexture(GL_TEXTURE_2D, tex);
     
-    if (rgba)
+    int level;
+    for (level = 0; level < atlas->levelCount; ++level)
     {
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, w, h, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
-        
-    }
-    else
-    {
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, w, h, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
+        glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA, atlas->width >> level, atlas->height >> level, 0, GL_RGBA, GL_UNSIGNED_BYTE, atlas->levels[level]);
     }
     
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    /* the chain stops while tiles still have a gutter, well short of 1x1 */
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, atlas->levelCount - 1);
+    
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
     
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
     return tex;
 }
 
-void Renderer_Init(Renderer_t* renderer)
+/* fills a tile's whole cell, gutter included, with opaque white at every level of the bound atlas texture */
+static void Renderer_PaintTileWhite(const Atlas_t* atlas, int tile)
+{
+    int cell = atlas->tileSize * 2;
+    
+    GLubyte* texels = malloc(cell * cell * 4);
+    assert(texels);
+    memset(texels, 255, cell * cell * 4);
+    
+    int level;
+    for (level = 0; level < atlas->levelCount; ++level)
+    {
+        int levelCell = cell >> level;
+        glTexSubImage2D(GL_TEXTURE_2D, level, (tile % atlas->rows) * levelCell, (tile / atlas->rows) * levelCell,
+                        levelCell, levelCell, GL_RGBA, GL_UNSIGNED_BYTE, texels);
+    }
+    
+    free(texels);
+}
+
+/* whiteTile is painted opaque white after upload, -1 for none */
+static GLuint Renderer_LoadAtlas(Renderer_t* renderer, const AtlasSource_t* source, int whiteTile)
 {
-    tga_image image;
-    tga_read(&image, "data/block_textures.tga");
-    tga_swap_red_blue(&image);
+    Atlas_t atlas;
+    if (!Atlas_Load(&atlas, source))
+    {
+        fprintf(stderr, "can't load texture atlas %s\n", source->imagePath);
+        return 0;
+    }
     
-    renderer->blockAtlas = Renderer_Upload(renderer, image.width, image.height, 0, image.image_data);
+    GLuint tex = Renderer_Upload(renderer, &atlas);
+    if (whiteTile >= 0) Renderer_PaintTileWhite(&atlas, whiteTile);
     
-    tga_image image2;
-    tga_read(&image2, "data/item_textures.tga");
-    tga_swap_red_blue(&image2);
+    Atlas_Unload(&atlas);
+    return tex;
+}
+
+void Renderer_Init(Renderer_t* renderer)
+{
+    renderer->blockAtlas = Renderer_LoadAtlas(renderer, &BlockAtlasSource, -1);
+    renderer->itemAtlas = Renderer_LoadAtlas(renderer, &ItemAtlasSource, ITEM_ATLAS_WHITE_TILE);
     
-    renderer->itemAtlas = Renderer_Upload(renderer, image2.width, image2.height, 1, image2.image_data);
+    renderer->entityCapacity = 0;
+    renderer->entityCenterZ = NULL;
+    renderer->entityHalfSize = NULL;
+    renderer->entityHalfHeight = NULL;
+    renderer->visibleEntities = NULL;
+    renderer->entityVerts = NULL;
     
+    renderer->hudBatch.verts = NULL;
+    renderer->hudBatch.capacity = 0;
+    renderer->hudBatch.builtItems = NULL;
+    renderer->hudBatch.builtItemCount = -1;
     
     glEnable(GL_DEPTH_TEST);
-    glPointSize(20.0f);
 }
 
 
-#define ITEM_ATLAS_ROWS 8
-#define ITEM_ATLAS_SIZE 0.125
+#define ITEM_ATLAS_SIZE ATLAS_TILE_SPAN(ITEM_ATLAS_ROWS)
 
 static Vec2_t ItemAtlas_UVForTex(int texID)
 {
-    Vec2_t uv;
-    uv.x = (texID % ITEM_ATLAS_ROWS) * ITEM_ATLAS_SIZE;
-    uv.y = (texID / ITEM_ATLAS_ROWS) * ITEM_ATLAS_SIZE;
-    return uv;
+    return Atlas_TileUV(texID, ITEM_ATLAS_ROWS);
 }
 
 static int ItemAtlas_TexForItem(int itemType)
@@ -77,6 +136,38 @@ static int ItemAtlas_TexForItem(int itemType)
     return 0;
 }
 
+/* points the vertex arrays at faces of a chunk and moves the modelview to the chunk */
+static void _Renderer_BindFaces(const Chunk_t* chunk, const Face_t* faces)
+{
+    glTranslatef(chunk->worldPosition.x, chunk->worldPosition.y, chunk->worldPosition.z);
+    
+    glVertexPointer(3, GL_SHORT, sizeof(Vert_t), &faces[0].verts[0].x);
+    glTexCoordPointer(2, GL_FLOAT, sizeof(Vert_t),  &faces[0].verts[0].u);
+    glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(Vert_t), faces[0].verts[0].color);
+}
+
+static void _Renderer_DrawLayer(const World_t* world, int layer)
+{
+    int i;
+    for (i = 0; i < world->visibleCount; ++i)
+    {
+        const Chunk_t* chunk = &world->chunks[world->visibleChunks[i]];
+        const Mesh_t* mesh = chunk->mesh;
+        
+        if (!mesh) continue;
+        
+        int first = mesh->layerStarts[layer];
+        int count = mesh->layerStarts[layer + 1] - first;
+        
+        if (count == 0) continue;
+        
+        glPushMatrix();
+        _Renderer_BindFaces(chunk, mesh->faces + first);
+        glDrawArrays(GL_QUADS, 0, count * 4);
+        glPopMatrix();
+    }
+}
+
 static void _Renderer_DrawChunks(Renderer_t* renderer,
                                  Cam_t* cam,
                                  const World_t* world)
@@ -86,140 +177,320 @@ static void _Renderer_DrawChunks(Renderer_t* renderer,
     glBindTexture(GL_TEXTURE_2D, renderer->blockAtlas);
     glColor3f(1.0f, 1.0f, 1.0f);
     
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+    glEnableClientState(GL_COLOR_ARRAY);
+    
+    _Renderer_DrawLayer(world, BLOCK_LAYER_OPAQUE);
+    
+    glEnable(GL_ALPHA_TEST);
+    glAlphaFunc(GL_GREATER, 0.5f);
+    
+    _Renderer_DrawLayer(world, BLOCK_LAYER_CUTOUT);
+    
+    glDisable(GL_ALPHA_TEST);
+    
+    /* later passes use glColor */
+    glDisableClientState(GL_COLOR_ARRAY);
+}
+
+/* blended over everything else, chunks and the faces within them back to front.
+ depth is tested but not written so translucent faces behind each other both show */
+static void _Renderer_DrawTranslucentChunks(Renderer_t* renderer,
+                                            Cam_t* cam,
+                                            const World_t* world)
+{
+    if (world->translucentCount == 0) return;
+    
+    glEnable(GL_TEXTURE_2D);
+    glBindTexture(GL_TEXTURE_2D, renderer->blockAtlas);
+    
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glDepthMask(GL_FALSE);
+    
+    glEnableClientState(GL_COLOR_ARRAY);
+    
     int i;
-    for (i = 0; i < world->chunkCount; ++i)
+    for (i = 0; i < world->translucentCount; ++i)
     {
-        const Chunk_t* chunk = &world->chunks[i];
+        const Chunk_t* chunk = &world->chunks[world->translucentChunks[i]];
+        const Mesh_t* mesh = chunk->mesh;
         
-        if (!Cam_SphereVisible(cam, chunk->boundingSphere)) continue;
+        int first = mesh->layerStarts[BLOCK_LAYER_TRANSLUCENT];
+        int count = mesh->layerStarts[BLOCK_LAYER_TRANSLUCENT + 1] - first;
         
         glPushMatrix();
-        glTranslatef(chunk->worldPosition.x, chunk->worldPosition.y, chunk->worldPosition.z);
-        
-        glEnableClientState(GL_VERTEX_ARRAY);
-        glEnableClientState(GL_TEXTURE_COORD_ARRAY);
-        
-        glVertexPointer(3, GL_SHORT, sizeof(Vert_t), &chunk->cache[0].verts[0].x);
-        glTexCoordPointer(2, GL_FLOAT, sizeof(Vert_t),  &chunk->cache[0].verts[0].u);
-        
-        glDrawArrays(GL_QUADS, 0, chunk->cacheSize * 4);
-        
+        _Renderer_BindFaces(chunk, mesh->faces + first);
+        glDrawElements(GL_QUADS, count * 4, GL_UNSIGNED_SHORT, chunk->translucentOrder.indices);
         glPopMatrix();
     }
+    
+    glDisableClientState(GL_COLOR_ARRAY);
+    
+    glDepthMask(GL_TRUE);
+    glDisable(GL_BLEND);
+    glDisable(GL_TEXTURE_2D);
+}
+
+static void _Renderer_ReserveEntities(Renderer_t* renderer, int capacity)
+{
+    if (capacity <= renderer->entityCapacity) return;
+    
+    renderer->entityCapacity = capacity;
+    renderer->entityCenterZ = realloc(renderer->entityCenterZ, sizeof(float) * capacity);
+    renderer->entityHalfSize = realloc(renderer->entityHalfSize, sizeof(float) * capacity);
+    renderer->entityHalfHeight = realloc(renderer->entityHalfHeight, sizeof(float) * capacity);
+    renderer->visibleEntities = realloc(renderer->visibleEntities, sizeof(int) * capacity);
+    renderer->entityVerts = realloc(renderer->entityVerts, sizeof(EntityVert_t) * 4 * capacity);
+    
+    assert(renderer->entityCenterZ && renderer->entityHalfSize && renderer->entityHalfHeight);
+    assert(renderer->visibleEntities && renderer->entityVerts);
 }
 
+static inline void _Renderer_EntityVert(EntityVert_t* vert, Vec3_t position, float u, float v)
+{
+    vert->x = position.x;
+    vert->y = position.y;
+    vert->z = position.z;
+    vert->u = u;
+    vert->v = v;
+}
+
+/* every dropped item in view as a billboard of its item icon, in a single draw */
 static void _Renderer_DrawEntities(Renderer_t* renderer,
                                    Cam_t* cam,
                                    const World_t* world)
 {
+    const EntityStore_t* store = &world->entities;
+    
+    if (store->count == 0) return;
+    
+    _Renderer_ReserveEntities(renderer, store->capacity);
     
+    /* entities stand on their position, their bounds are centered above it */
+    int i;
+    for (i = 0; i < store->count; ++i)
+    {
+        renderer->entityCenterZ[i] = store->z[i] + store->height[i] * 0.5f;
+        renderer->entityHalfSize[i] = store->size[i] * 0.5f;
+        renderer->entityHalfHeight[i] = store->height[i] * 0.5f;
+    }
+    
+    int visibleCount = Geo_BoxesInsidePlanes(cam->planeEquations,
+                                             6,
+                                             store->x,
+                                             store->y,
+                                             renderer->entityCenterZ,
+                                             renderer->entityHalfSize,
+                                             renderer->entityHalfSize,
+                                             renderer->entityHalfHeight,
+                                             store->count,
+                                             renderer->visibleEntities);
+    
+    if (visibleCount == 0) return;
+    
+    /* corners go counter clockwise as seen from the camera */
+    EntityVert_t* vert = renderer->entityVerts;
+    
+    for (i = 0; i < visibleCount; ++i)
+    {
+        int slot = renderer->visibleEntities[i];
+        
+        Vec3_t center = Vec3_Create(store->x[slot], store->y[slot], renderer->entityCenterZ[slot]);
+        Vec3_t right = Vec3_Scale(cam->right, renderer->entityHalfSize[slot]);
+        Vec3_t up = Vec3_Scale(cam->up, renderer->entityHalfHeight[slot]);
+        
+        Vec2_t uv = ItemAtlas_UVForTex(ItemAtlas_TexForItem(store->pickupType[slot]));
+        
+        _Renderer_EntityVert(vert++, Vec3_Sub(Vec3_Sub(center, right), up), uv.x, uv.y);
+        _Renderer_EntityVert(vert++, Vec3_Sub(Vec3_Add(center, right), up), uv.x + ITEM_ATLAS_SIZE, uv.y);
+        _Renderer_EntityVert(vert++, Vec3_Add(Vec3_Add(center, right), up), uv.x + ITEM_ATLAS_SIZE, uv.y + ITEM_ATLAS_SIZE);
+        _Renderer_EntityVert(vert++, Vec3_Add(Vec3_Sub(center, right), up), uv.x, uv.y + ITEM_ATLAS_SIZE);
+    }
+    
+    glEnable(GL_TEXTURE_2D);
+    glBindTexture(GL_TEXTURE_2D, renderer->itemAtlas);
+    glColor3f(1.0f, 1.0f, 1.0f);
+    
+    glEnable(GL_ALPHA_TEST);
+    glAlphaFunc(GL_GREATER, 0.5f);
+    
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+    
+    glVertexPointer(3, GL_FLOAT, sizeof(EntityVert_t), &renderer->entityVerts[0].x);
+    glTexCoordPointer(2, GL_FLOAT, sizeof(EntityVert_t), &renderer->entityVerts[0].u);
+    glDrawArrays(GL_QUADS, 0, visibleCount * 4);
+    
+    glDisable(GL_ALPHA_TEST);
     glDisable(GL_TEXTURE_2D);
+}
+
+static const GLubyte HudColor_Selected[4] = { 255, 255, 0, 255 };
+static const GLubyte HudColor_Slot[4] = { 64, 64, 64, 255 };
+static const GLubyte HudColor_Icon[4] = { 255, 255, 255, 255 };
+
+static HudVert_t* _Renderer_HudQuad(HudVert_t* vert, Vec2_t min, Vec2_t max, Vec2_t uv, float uvSize, const GLubyte* color)
+{
+    const float corners[4][4] =
+    {
+        { min.x, min.y, uv.x, uv.y },
+        { max.x, min.y, uv.x + uvSize, uv.y },
+        { max.x, max.y, uv.x + uvSize, uv.y + uvSize },
+        { min.x, max.y, uv.x, uv.y + uvSize },
+    };
+    
+    int i;
+    for (i = 0; i < 4; ++i)
+    {
+        vert[i].x = corners[i][0];
+        vert[i].y = corners[i][1];
+        vert[i].u = corners[i][2];
+        vert[i].v = corners[i][3];
+        memcpy(vert[i].color, color, 4);
+    }
     
-    glColor3f(1.0f, 0.0f, 0.0f);
+    return vert + 4;
+}
+
+/* slot backgrounds, the selected one drawn over a border that shows around it.
+ they sample the middle of the white tile so their colour comes through as it is */
+static HudVert_t* _Renderer_HudSlots(HudVert_t* vert, const HudGrid_t* grid, const Inventory_t* inventory)
+{
+    Vec2_t white = Vec2_Add(ItemAtlas_UVForTex(ITEM_ATLAS_WHITE_TILE), Vec2_Clear(ITEM_ATLAS_SIZE * 0.5f));
     
     int i;
-    for (i = 0; i < MAX_ENTITIES; ++i)
+    for (i = 0; i < grid->count; ++i)
     {
-        const Entity_t* entity = world->entities + i;
+        const HudRect_t* rect = grid->slots + i;
         
-        if (entity->entityID != -1)
+        if (inventory->selectedItem == i)
         {
-            glBegin(GL_POINTS);
-            glVertex3f(entity->position.x, entity->position.y, entity->position.z);
-            glEnd();
+            vert = _Renderer_HudQuad(vert, Vec2_Add(rect->min, Vec2_Clear(-1.0f)), Vec2_Add(rect->max, Vec2_Clear(1.0f)), white, 0.0f, HudColor_Selected);
         }
+        
+        vert = _Renderer_HudQuad(vert, rect->min, rect->max, white, 0.0f, HudColor_Slot);
     }
+    
+    return vert;
 }
 
-static void _Renderer_DrawInventory(Renderer_t* renderer,
-                                    Inventory_t* inventory,
-                                    const State_t* state,
-                                    float ox,
-                                    float oy)
+static HudVert_t* _Renderer_HudIcons(HudVert_t* vert, const HudGrid_t* grid, const Inventory_t* inventory)
 {
+    int i;
+    for (i = 0; i < grid->count; ++i)
+    {
+        if (inventory->items[i].type == ITEM_NONE) continue;
+        
+        Vec2_t uv = ItemAtlas_UVForTex(ItemAtlas_TexForItem(inventory->items[i].type));
+        vert = _Renderer_HudQuad(vert, grid->slots[i].min, grid->slots[i].max, uv, ITEM_ATLAS_SIZE, HudColor_Icon);
+    }
     
-    glDisable(GL_DEPTH_TEST);
+    return vert;
+}
+
+static int _Renderer_HudChanged(const HudBatch_t* batch,
+                                const Inventory_t* pack,
+                                const Inventory_t* belt,
+                                int mode)
+{
+    int packCount = pack->width * pack->height;
+    int beltCount = belt->width * belt->height;
     
-    int x,y;
+    if (batch->builtItemCount != packCount + beltCount) return 1;
     
-    float tSize = 32.0f;
-    float tSpacing = 2.0f;
+    if (batch->builtMode != mode ||
+        batch->builtPackSelected != pack->selectedItem ||
+        batch->builtBeltSelected != belt->selectedItem)
+    {
+        return 1;
+    }
     
-    glBegin(GL_QUADS);
+    return memcmp(batch->builtItems, pack->items, sizeof(Item_t) * packCount) != 0 ||
+           memcmp(batch->builtItems + packCount, belt->items, sizeof(Item_t) * beltCount) != 0;
+}
+
+static void _Renderer_BuildHud(HudBatch_t* batch,
+                               const Hud_t* hud,
+                               const Inventory_t* pack,
+                               const Inventory_t* belt,
+                               int mode)
+{
+    int itemCount = hud->pack.count + hud->belt.count;
     
-    for (x = 0; x < inventory->width; ++x)
+    /* at most a border, a background and an icon per slot */
+    if (batch->capacity < itemCount * 3)
     {
-        for (y = 0; y < inventory->height; ++y)
-        {
-            float tx = ox + (float)x * (tSize + tSpacing);
-            float ty = oy + (float)y * (tSize + tSpacing);
-            
-            if (state->mode == MODE_INVENTORY &&
-                state->cursor.x > tx &&
-                state->cursor.y > ty &&
-                state->cursor.x < tx + tSize &&
-                state->cursor.y < ty + tSize)
-            {
-                inventory->selectedItem = x + y * inventory->width;
-            }
-            
-            if (inventory->selectedItem == x + y * inventory->width)
-            {
-                glColor3f(1.0f, 1.0f, 0.0f);
-                glVertex2f(tx - 1, ty - 1);
-                glVertex2f(tx + tSize + 1, ty - 1);
-                glVertex2f(tx + tSize + 1, ty + tSize + 1);
-                glVertex2f(tx - 1, ty + tSize + 1);
-            }
-            glColor3f(0.25f, 0.25f, 0.25f);
-            
-            
-            glVertex2f(tx, ty);
-            glVertex2f(tx + tSize, ty);
-            glVertex2f(tx + tSize, ty + tSize);
-            glVertex2f(tx, ty + tSize);
-        }
+        batch->capacity = itemCount * 3;
+        batch->verts = realloc(batch->verts, sizeof(HudVert_t) * 4 * batch->capacity);
+        batch->builtItems = realloc(batch->builtItems, sizeof(Item_t) * itemCount);
+        assert(batch->verts && batch->builtItems);
     }
     
-    glEnd();
+    /* the pack only shows while the inventory is open */
+    HudVert_t* vert = batch->verts;
+    if (mode == MODE_INVENTORY) vert = _Renderer_HudSlots(vert, &hud->pack, pack);
+    vert = _Renderer_HudSlots(vert, &hud->belt, belt);
     
-    glEnable(GL_TEXTURE_2D);
-    glBindTexture(GL_TEXTURE_2D, renderer->itemAtlas);
+    if (mode == MODE_INVENTORY) vert = _Renderer_HudIcons(vert, &hud->pack, pack);
+    vert = _Renderer_HudIcons(vert, &hud->belt, belt);
     
-    glColor3f(1.0f, 1.0f, 1.0f);
+    batch->quadCount = (int)(vert - batch->verts) / 4;
     
-    glBegin(GL_QUADS);
+    memcpy(batch->builtItems, pack->items, sizeof(Item_t) * hud->pack.count);
+    memcpy(batch->builtItems + hud->pack.count, belt->items, sizeof(Item_t) * hud->belt.count);
+    batch->builtItemCount = itemCount;
+    batch->builtPackSelected = pack->selectedItem;
+    batch->builtBeltSelected = belt->selectedItem;
+    batch->builtMode = mode;
+}
+
+/* the inventory grids from vertex data kept between frames, in one draw */
+static void _Renderer_DrawHud(Renderer_t* renderer,
+                              const Hud_t* hud,
+                              const Inventory_t* pack,
+                              const Inventory_t* belt,
+                              const State_t* state)
+{
+    HudBatch_t* batch = &renderer->hudBatch;
     
-    for (x = 0; x < inventory->width; ++x)
+    if (_Renderer_HudChanged(batch, pack, belt, state->mode))
     {
-        for (y = 0; y < inventory->height; ++y)
-        {
-            if (inventory->items[x + y * inventory->width].type == ITEM_NONE) continue;
-            
-            float tx = ox + (float)x * (tSize + tSpacing);
-            float ty = oy + (float)y * (tSize + tSpacing);
-            
-            Vec2_t uv = ItemAtlas_UVForTex(ItemAtlas_TexForItem(inventory->items[x + y * inventory->width].type));
-            
-            glTexCoord2f(uv.x, uv.y);
-            glVertex2f(tx, ty);
-            glTexCoord2f(uv.x + ITEM_ATLAS_SIZE, uv.y);
-            glVertex2f(tx + tSize, ty);
-            glTexCoord2f(uv.x + ITEM_ATLAS_SIZE, uv.y + ITEM_ATLAS_SIZE);
-            glVertex2f(tx + tSize, ty + tSize);
-            glTexCoord2f(uv.x, uv.y + ITEM_ATLAS_SIZE);
-            glVertex2f(tx, ty + tSize);
-        }
+        _Renderer_BuildHud(batch, hud, pack, belt, state->mode);
     }
     
-    glEnd();
+    glDisable(GL_DEPTH_TEST);
+    
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+    glEnableClientState(GL_COLOR_ARRAY);
+    
+    glVertexPointer(2, GL_FLOAT, sizeof(HudVert_t), &batch->verts[0].x);
+    glTexCoordPointer(2, GL_FLOAT, sizeof(HudVert_t), &batch->verts[0].u);
+    glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(HudVert_t), batch->verts[0].color);
+    
+    glEnable(GL_TEXTURE_2D);
+    glBindTexture(GL_TEXTURE_2D, renderer->itemAtlas);
+    
+    /* icons are cut out from their keyed background, slots are opaque */
+    glEnable(GL_ALPHA_TEST);
+    glAlphaFunc(GL_GREATER, 0.5f);
+    
+    glDrawArrays(GL_QUADS, 0, batch->quadCount * 4);
+    
+    glDisable(GL_ALPHA_TEST);
+    glDisable(GL_TEXTURE_2D);
+    
+    glDisableClientState(GL_COLOR_ARRAY);
 }
 
 void Renderer_RenderWorld(Renderer_t* renderer,
                           Cam_t* cam,
                           const World_t* world,
-                          Inventory_t* inventory,
-                          Inventory_t* belt,
+                          const Hud_t* hud,
+                          const Inventory_t* inventory,
+                          const Inventory_t* belt,
                           const State_t* state)
 {
     glClearColor(.620f, .807f, .980f, 1.0f);
@@ -243,6 +514,7 @@ void Renderer_RenderWorld(Renderer_t* renderer,
     
     _Renderer_DrawChunks(renderer, cam, world);
     _Renderer_DrawEntities(renderer, cam, world);
+    _Renderer_DrawTranslucentChunks(renderer, cam, world);
     
     glColor3f(1.0f, 1.0f, 1.0f);
     
@@ -253,12 +525,7 @@ void Renderer_RenderWorld(Renderer_t* renderer,
     glMatrixMode(GL_MODELVIEW);
     glLoadIdentity();
     
-    if (state->mode == MODE_INVENTORY)
-    {
-        _Renderer_DrawInventory(renderer, inventory, state, 16.0f, 550.0f);
-    }
-    
-    _Renderer_DrawInventory(renderer, belt, state, 16.0f, 700.0f);
+    _Renderer_DrawHud(renderer, hud, inventory, belt, state);
     
     /*
      glBegin(GL_TRIANGLES);
@@ -7,15 +7,60 @@
 #include "world.h"
 #include "inventory.h"
 #include "state.h"
+#include "hud.h"
 
 #include <OpenGL/gl.h>
 
 
+/* a corner of a dropped item's billboard */
+typedef struct
+{
+    float x, y, z;
+    float u, v;
+} EntityVert_t;
+
+/* a corner of a hud quad */
+typedef struct
+{
+    float x, y;
+    float u, v;
+    GLubyte color[4];
+} HudVert_t;
+
+/* the inventory grids as vertex data, built again only when what they show changes */
+typedef struct
+{
+    HudVert_t* verts;
+    int capacity;
+    
+    /* slot quads come first, then the item icons. all of them are textured from the item atlas,
+     slots from its white tile, so the whole hud is one draw */
+    int quadCount;
+    
+    /* what the verts were built from, pack items then belt items */
+    Item_t* builtItems;
+    int builtItemCount;
+    int builtPackSelected;
+    int builtBeltSelected;
+    int builtMode;
+} HudBatch_t;
+
 typedef struct
 {
     Mat4_t mvpMat;
     GLuint blockAtlas;
     GLuint itemAtlas;
+    
+    /* dropped items are gathered here each frame and drawn in one call.
+     bounds are stored by axis for culling, x and y are the entity store's own */
+    int entityCapacity;
+    float* entityCenterZ;
+    float* entityHalfSize;
+    float* entityHalfHeight;
+    int* visibleEntities;
+    EntityVert_t* entityVerts;
+    
+    HudBatch_t hudBatch;
 } Renderer_t;
 
 extern void Renderer_Init(Renderer_t* renderer);
@@ -23,8 +68,9 @@ extern void Renderer_Init(Renderer_t* renderer);
 extern void Renderer_RenderWorld(Renderer_t* renderer,
                                  Cam_t* cam,
                                  const World_t* world,
-                                 Inventory_t* inventory,
-                                 Inventory_t* belt,
+                                 const Hud_t* hud,
+                                 const Inventory_t* inventory,
+                                 const Inventory_t* belt,
                                  const State_t* state);
 
 
@@ -0,0 +1,139 @@
+
+#include "replay.h"
+#include "endian.h"
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+int ReplayWriter_Open(ReplayWriter_t* writer, const char* path, uint32_t seed)
+{
+    writer->file = fopen(path, "wb");
+    writer->tickCount = 0;
+    
+    if (!writer->file) return 0;
+    
+    unsigned char header[REPLAY_HEADER_SIZE];
+    End_U32ToLittle(header, REPLAY_MAGIC);
+    End_U32ToLittle(header + 4, REPLAY_VERSION);
+    End_U32ToLittle(header + 8, seed);
+    
+    fwrite(header, 1, sizeof(header), writer->file);
+    return 1;
+}
+
+void ReplayWriter_Tick(ReplayWriter_t* writer, const ReplayTick_t* tick, uint64_t digest)
+{
+    unsigned char data[REPLAY_TICK_SIZE];
+    data[0] = REPLAY_TAG_TICK;
+    data[1] = (unsigned char)tick->forward;
+    data[2] = (unsigned char)tick->side;
+    data[3] = tick->buttons;
+    data[4] = (unsigned char)tick->beltIndex;
+    data[5] = tick->toggles;
+    End_F32ToLittle(data + 6, tick->lookX);
+    End_F32ToLittle(data + 10, tick->lookY);
+    End_F32ToLittle(data + 14, tick->cursorX);
+    End_F32ToLittle(data + 18, tick->cursorY);
+    End_U64ToLittle(data + 22, digest);
+    
+    fwrite(data, 1, sizeof(data), writer->file);
+    writer->tickCount++;
+}
+
+void ReplayWriter_Close(ReplayWriter_t* writer)
+{
+    unsigned char data[REPLAY_END_SIZE];
+    data[0] = REPLAY_TAG_END;
+    End_U32ToLittle(data + 1, writer->tickCount);
+    
+    fwrite(data, 1, sizeof(data), writer->file);
+    fclose(writer->file);
+    writer->file = NULL;
+}
+
+static void _Replay_ReadTick(const unsigned char* data, ReplayTick_t* tick)
+{
+    tick->forward = (signed char)data[1];
+    tick->side = (signed char)data[2];
+    tick->buttons = data[3];
+    tick->beltIndex = (signed char)data[4];
+    tick->toggles = data[5];
+    tick->lookX = End_F32FromLittle(data + 6);
+    tick->lookY = End_F32FromLittle(data + 10);
+    tick->cursorX = End_F32FromLittle(data + 14);
+    tick->cursorY = End_F32FromLittle(data + 18);
+}
+
+int Replay_Load(Replay_t* replay, const char* path)
+{
+    replay->seed = 0;
+    replay->ticks = NULL;
+    replay->digests = NULL;
+    replay->tickCount = 0;
+    replay->finished = 0;
+    
+    FILE* file = fopen(path, "rb");
+    if (!file) return 0;
+    
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    
+    unsigned char* data = size > 0 ? malloc(size) : NULL;
+    int ok = data && fread(data, 1, size, file) == (size_t)size;
+    fclose(file);
+    
+    if (!ok || size < REPLAY_HEADER_SIZE ||
+        End_U32FromLittle(data) != REPLAY_MAGIC ||
+        End_U32FromLittle(data + 4) != REPLAY_VERSION)
+    {
+        free(data);
+        return 0;
+    }
+    
+    replay->seed = End_U32FromLittle(data + 8);
+    
+    /* at most this many ticks, fewer if it finished */
+    int capacity = (int)((size - REPLAY_HEADER_SIZE) / REPLAY_TICK_SIZE);
+    if (capacity < 1) capacity = 1;
+    
+    replay->ticks = malloc(sizeof(ReplayTick_t) * capacity);
+    replay->digests = malloc(sizeof(uint64_t) * capacity);
+    assert(replay->ticks && replay->digests);
+    
+    long offset = REPLAY_HEADER_SIZE;
+    while (offset < size)
+    {
+        int tag = data[offset];
+        
+        if (tag == REPLAY_TAG_TICK && offset + REPLAY_TICK_SIZE <= size)
+        {
+            _Replay_ReadTick(data + offset, replay->ticks + replay->tickCount);
+            replay->digests[replay->tickCount] = End_U64FromLittle(data + offset + 22);
+            replay->tickCount++;
+            offset += REPLAY_TICK_SIZE;
+        }
+        else if (tag == REPLAY_TAG_END && offset + REPLAY_END_SIZE <= size)
+        {
+            replay->finished = End_U32FromLittle(data + offset + 1) == (uint32_t)replay->tickCount;
+            break;
+        }
+        else
+        {
+            /* cut off mid record, play what there is */
+            break;
+        }
+    }
+    
+    free(data);
+    return 1;
+}
+
+void Replay_Free(Replay_t* replay)
+{
+    free(replay->ticks);
+    free(replay->digests);
+    replay->ticks = NULL;
+    replay->digests = NULL;
+    replay->tickCount = 0;
+}
@@ -0,0 +1,90 @@
+
+#ifndef ccraft_replay_h
+#define ccraft_replay_h
+
+#include <stdio.h>
+#include <stdint.h>
+
+/* a recording of everything the player did each tick, so a session can be played back
+ without a window and give the same world every time.
+ the file is a header, one record per tick with the digest of the state after it (see digest.h),
+ and an end record. a replay has to start from the same save it was recorded on */
+
+#define REPLAY_MAGIC 0x50524343
+#define REPLAY_VERSION 2
+
+/* header is u32 magic, u32 version, u32 seed for rand() */
+#define REPLAY_HEADER_SIZE (4 + 4 + 4)
+
+/* tick is u8 tag, i8 forward, i8 side, u8 buttons, i8 belt index, u8 inventory toggles,
+ f32 camera x and y deltas, f32 cursor x and y, u64 root digest after the tick */
+#define REPLAY_TICK_SIZE (1 + 1 + 1 + 1 + 1 + 1 + 16 + 8)
+
+/* end is u8 tag, u32 tick count */
+#define REPLAY_END_SIZE (1 + 4)
+
+enum
+{
+    REPLAY_TAG_TICK = 1,
+    REPLAY_TAG_END,
+};
+
+enum
+{
+    REPLAY_BUTTON_JUMP = 1 << 0,
+    REPLAY_BUTTON_DIG = 1 << 1,
+    REPLAY_BUTTON_PLACE = 1 << 2,
+};
+
+/* what the devices said during one tick */
+typedef struct
+{
+    signed char forward;
+    signed char side;
+    unsigned char buttons;
+    
+    /* belt slot picked with the number keys, -1 for none */
+    signed char beltIndex;
+    
+    /* times the inventory was opened or closed */
+    unsigned char toggles;
+    
+    /* mouse movement as a fraction of the window, summed over the tick */
+    float lookX;
+    float lookY;
+    
+    /* where the cursor is as a fraction of the window, used while the inventory is open */
+    float cursorX;
+    float cursorY;
+} ReplayTick_t;
+
+typedef struct
+{
+    FILE* file;
+    uint32_t tickCount;
+} ReplayWriter_t;
+
+typedef struct
+{
+    uint32_t seed;
+    
+    ReplayTick_t* ticks;
+    
+    /* root digest of the state after each tick */
+    uint64_t* digests;
+    int tickCount;
+    
+    /* 0 if recording was cut off before the end record */
+    int finished;
+} Replay_t;
+
+/* returns 0 if the file can't be created */
+extern int ReplayWriter_Open(ReplayWriter_t* writer, const char* path, uint32_t seed);
+extern void ReplayWriter_Tick(ReplayWriter_t* writer, const ReplayTick_t* tick, uint64_t digest);
+extern void ReplayWriter_Close(ReplayWriter_t* writer);
+
+/* reads a whole recording, returns 0 if it can't be read or isn't one */
+extern int Replay_Load(Replay_t* replay, const char* path);
+extern void Replay_Free(Replay_t* replay);
+
+#endif
@@ -0,0 +1,192 @@
+
+#include "bot.h"
+#include "server.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* ticks between connect attempts while waiting for a welcome */
+#define BOT_CONNECT_RETRY 30
+
+int Bot_Init(Bot_t* bot, NetAddress_t server, unsigned int seed)
+{
+    if (!Net_Open(&bot->socket, 0)) return 0;
+    
+    bot->server = server;
+    bot->id = -1;
+    bot->seed = seed;
+    bot->inputSeq = 0;
+    bot->wanderTicks = 0;
+    bot->serverTick = 0;
+    bot->position = Vec3_Zero();
+    
+    memset(&bot->input, 0, sizeof(bot->input));
+    bot->input.beltIndex = -1;
+    
+    ChunkMirror_Init(&bot->chunks);
+    
+    SnapshotHistory_Init(&bot->snapshots);
+    bot->snapshotSeq = 0;
+    bot->entered = 0;
+    bot->left = 0;
+    bot->updated = 0;
+    bot->snapshotsDropped = 0;
+    
+    return 1;
+}
+
+void Bot_Shutdown(Bot_t* bot)
+{
+    if (bot->id != -1)
+    {
+        unsigned char disconnect = NET_MSG_DISCONNECT;
+        Net_Send(&bot->socket, &bot->server, &disconnect, 1);
+    }
+    
+    Net_Close(&bot->socket);
+    ChunkMirror_Shutdown(&bot->chunks);
+}
+
+static void _Bot_Receive(Bot_t* bot)
+{
+    unsigned char data[NET_MAX_PACKET];
+    NetAddress_t from;
+    int size;
+    
+    while ((size = Net_Receive(&bot->socket, &from, data, sizeof(data))) > 0)
+    {
+        if (!Net_AddressEqual(&from, &bot->server)) continue;
+        
+        NetReader_t reader;
+        NetReader_Init(&reader, data, size);
+        
+        switch (NetReader_U8(&reader))
+        {
+            case NET_MSG_WELCOME:
+                bot->id = NetReader_U8(&reader);
+                break;
+            case NET_MSG_STATE:
+            {
+                uint32_t tick = NetReader_U32(&reader);
+                NetReader_U32(&reader);
+                
+                Vec3_t position;
+                position.x = NetReader_F32(&reader);
+                position.y = NetReader_F32(&reader);
+                position.z = NetReader_F32(&reader);
+                
+                if (!reader.overflow && tick >= bot->serverTick)
+                {
+                    bot->serverTick = tick;
+                    bot->position = position;
+                }
+                break;
+            }
+            case NET_MSG_CHUNK:
+                ChunkMirror_ReadChunk(&bot->chunks, &reader);
+                break;
+            case NET_MSG_BLOCKS:
+                ChunkMirror_ReadBlocks(&bot->chunks, &reader);
+                break;
+            case NET_MSG_ENTITIES:
+            {
+                SnapshotEvents_t events;
+                const Snapshot_t* snapshot = Snapshot_Read(&reader, &bot->snapshots, &events);
+                
+                if (!snapshot)
+                {
+                    bot->snapshotsDropped++;
+                    break;
+                }
+                
+                if (snapshot->seq > bot->snapshotSeq) bot->snapshotSeq = snapshot->seq;
+                
+                bot->entered += events.entered;
+                bot->left += events.left;
+                bot->updated += events.updated;
+                break;
+            }
+            default:
+                break;
+        }
+    }
+}
+
+static void _Bot_Wander(Bot_t* bot)
+{
+    PlayerInput_t* input = &bot->input;
+    
+    if (--bot->wanderTicks <= 0)
+    {
+        bot->wanderTicks = SERVER_TICK_RATE / 2 + rand_r(&bot->seed) % (SERVER_TICK_RATE * 2);
+        
+        input->forward = rand_r(&bot->seed) % 4 != 0;
+        input->side = rand_r(&bot->seed) % 3 - 1;
+        input->yaw = (float)(rand_r(&bot->seed) % 360);
+        input->pitch = (float)(rand_r(&bot->seed) % 60) - 30.0f;
+    }
+    
+    /* there is nothing to stand on past the world's low edges, head back in */
+    if (bot->position.x < 4.0f || bot->position.y < 4.0f)
+    {
+        input->yaw = 45.0f;
+        input->side = 0;
+    }
+    
+    input->jumping = rand_r(&bot->seed) % 20 == 0;
+    input->digging = rand_r(&bot->seed) % 10 == 0;
+    input->placing = 0;
+}
+
+static void _Bot_SendInput(Bot_t* bot)
+{
+    unsigned char data[32];
+    NetWriter_t writer;
+    NetWriter_Init(&writer, data, sizeof(data));
+    
+    const PlayerInput_t* input = &bot->input;
+    
+    uint8_t buttons = 0;
+    if (input->jumping) buttons |= INPUT_BUTTON_JUMP;
+    if (input->digging) buttons |= INPUT_BUTTON_DIG;
+    if (input->placing) buttons |= INPUT_BUTTON_PLACE;
+    
+    NetWriter_U8(&writer, NET_MSG_INPUT);
+    NetWriter_U32(&writer, ++bot->inputSeq);
+    NetWriter_U8(&writer, (uint8_t)input->forward);
+    NetWriter_U8(&writer, (uint8_t)input->side);
+    NetWriter_U8(&writer, buttons);
+    NetWriter_U8(&writer, (uint8_t)input->beltIndex);
+    NetWriter_F32(&writer, input->pitch);
+    NetWriter_F32(&writer, input->yaw);
+    NetWriter_U32(&writer, bot->snapshotSeq);
+    
+    Net_Send(&bot->socket, &bot->server, writer.data, writer.size);
+}
+
+void Bot_Tick(Bot_t* bot)
+{
+    _Bot_Receive(bot);
+    
+    if (bot->id == -1)
+    {
+        /* the sequence counts up while connecting too, the server only needs it to increase */
+        if (bot->inputSeq++ % BOT_CONNECT_RETRY == 0)
+        {
+            unsigned char connect = NET_MSG_CONNECT;
+            Net_Send(&bot->socket, &bot->server, &connect, 1);
+        }
+        return;
+    }
+    
+    _Bot_Wander(bot);
+    _Bot_SendInput(bot);
+    
+    unsigned char data[NET_MAX_PACKET];
+    NetWriter_t writer;
+    NetWriter_Init(&writer, data, sizeof(data));
+    
+    if (ChunkMirror_WriteAcks(&bot->chunks, &writer))
+    {
+        Net_Send(&bot->socket, &bot->server, writer.data, writer.size);
+    }
+}
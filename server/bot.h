@@ -0,0 +1,51 @@
+
+#ifndef ccraft_bot_h
+#define ccraft_bot_h
+
+#include "net.h"
+#include "sim.h"
+#include "chunk_mirror.h"
+#include "snapshot.h"
+
+/* a headless client that wanders, jumps and digs at random.
+ used to put load on a server without anyone playing */
+
+typedef struct
+{
+    NetSocket_t socket;
+    NetAddress_t server;
+    
+    /* slot on the server, -1 until welcomed */
+    int id;
+    
+    unsigned int seed;
+    uint32_t inputSeq;
+    PlayerInput_t input;
+    
+    /* ticks left before picking a new direction */
+    int wanderTicks;
+    
+    /* last state received */
+    uint32_t serverTick;
+    Vec3_t position;
+    
+    ChunkMirror_t chunks;
+    
+    SnapshotHistory_t snapshots;
+    uint32_t snapshotSeq;
+    
+    /* totals of every snapshot received */
+    int entered;
+    int left;
+    int updated;
+    int snapshotsDropped;
+} Bot_t;
+
+/* returns 0 if no socket could be opened */
+extern int Bot_Init(Bot_t* bot, NetAddress_t server, unsigned int seed);
+extern void Bot_Shutdown(Bot_t* bot);
+
+/* handles what the server sent and sends one input, called once per server tick */
+extern void Bot_Tick(Bot_t* bot);
+
+#endif
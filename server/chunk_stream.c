@@ -0,0 +1,437 @@
+
+#include "chunk_stream.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <assert.h>
+
+static double _ChunkStream_Now(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1000.0 + t.tv_nsec / 1000000.0;
+}
+
+void ChunkStream_Init(ChunkStream_t* stream)
+{
+    assert(stream);
+    
+    stream->encoded = NULL;
+    stream->encodedCapacity = 0;
+    
+    stream->changes = NULL;
+    stream->changeCount = 0;
+    stream->changeCapacity = 0;
+    
+    stream->groups = NULL;
+    stream->groupCount = 0;
+    stream->groupCapacity = 0;
+    
+    ChunkStream_ResetStats(stream);
+}
+
+void ChunkStream_Shutdown(ChunkStream_t* stream)
+{
+    int i;
+    for (i = 0; i < stream->encodedCapacity; ++i)
+    {
+        free(stream->encoded[i].data);
+    }
+    
+    free(stream->encoded);
+    free(stream->changes);
+    free(stream->groups);
+    
+    stream->encoded = NULL;
+    stream->encodedCapacity = 0;
+    stream->changes = NULL;
+    stream->changeCapacity = 0;
+    stream->groups = NULL;
+    stream->groupCapacity = 0;
+}
+
+void ChunkStream_ResetStats(ChunkStream_t* stream)
+{
+    stream->chunksEncoded = 0;
+    stream->encodeMs = 0.0;
+    stream->chunksSent = 0;
+    stream->chunkBytes = 0;
+    stream->resends = 0;
+    stream->changesSent = 0;
+    stream->changeBytes = 0;
+}
+
+static int _ChunkStream_CompareChanges(const void* a, const void* b)
+{
+    const BlockChange_t* changeA = a;
+    const BlockChange_t* changeB = b;
+    
+    if (changeA->chunk != changeB->chunk) return changeA->chunk < changeB->chunk ? -1 : 1;
+    if (changeA->revision != changeB->revision) return changeA->revision < changeB->revision ? -1 : 1;
+    return 0;
+}
+
+void ChunkStream_BeginTick(ChunkStream_t* stream, World_t* world)
+{
+    if (world->changeCount > stream->changeCapacity)
+    {
+        stream->changeCapacity = world->changeCount;
+        stream->changes = realloc(stream->changes, sizeof(BlockChange_t) * stream->changeCapacity);
+        assert(stream->changes);
+    }
+    
+    stream->changeCount = world->changeCount;
+    if (stream->changeCount > 0)
+    {
+        memcpy(stream->changes, world->changes, sizeof(BlockChange_t) * stream->changeCount);
+    }
+    world->changeCount = 0;
+    
+    /* revisions are unique within a chunk so the order is the order the changes happened */
+    qsort(stream->changes, stream->changeCount, sizeof(BlockChange_t), _ChunkStream_CompareChanges);
+    
+    stream->groupCount = 0;
+    
+    int i;
+    for (i = 0; i < stream->changeCount; ++i)
+    {
+        const BlockChange_t* change = stream->changes + i;
+        
+        if (stream->groupCount > 0 && stream->groups[stream->groupCount - 1].chunk == change->chunk)
+        {
+            stream->groups[stream->groupCount - 1].count++;
+            continue;
+        }
+        
+        if (stream->groupCount == stream->groupCapacity)
+        {
+            stream->groupCapacity = stream->groupCapacity ? stream->groupCapacity * 2 : 16;
+            stream->groups = realloc(stream->groups, sizeof(ChangeGroup_t) * stream->groupCapacity);
+            assert(stream->groups);
+        }
+        
+        ChangeGroup_t* group = stream->groups + stream->groupCount++;
+        group->chunk = change->chunk;
+        group->revision = change->revision - 1;
+        group->first = i;
+        group->count = 1;
+    }
+}
+
+/* the chunk's encoding at its current revision */
+static const EncodedChunk_t* _ChunkStream_Encode(ChunkStream_t* stream, World_t* world, int index)
+{
+    if (index >= stream->encodedCapacity)
+    {
+        int capacity = stream->encodedCapacity ? stream->encodedCapacity : 64;
+        while (capacity <= index) capacity *= 2;
+        
+        stream->encoded = realloc(stream->encoded, sizeof(EncodedChunk_t) * capacity);
+        assert(stream->encoded);
+        
+        memset(stream->encoded + stream->encodedCapacity, 0, sizeof(EncodedChunk_t) * (capacity - stream->encodedCapacity));
+        stream->encodedCapacity = capacity;
+    }
+    
+    EncodedChunk_t* encoded = stream->encoded + index;
+    const Chunk_t* chunk = world->chunks + index;
+    
+    if (encoded->data && encoded->revision == chunk->revision) return encoded;
+    
+    static unsigned char buffer[CHUNK_CODEC_MAX_SIZE];
+    
+    double start = _ChunkStream_Now();
+    int size = ChunkCodec_Encode(chunk->blocks, buffer);
+    stream->encodeMs += _ChunkStream_Now() - start;
+    stream->chunksEncoded++;
+    
+    encoded->data = realloc(encoded->data, size);
+    assert(encoded->data);
+    memcpy(encoded->data, buffer, size);
+    
+    encoded->size = size;
+    encoded->revision = chunk->revision;
+    
+    return encoded;
+}
+
+void ChunkSender_Init(ChunkSender_t* sender)
+{
+    sender->chunks = NULL;
+    sender->chunkCapacity = 0;
+    
+    sender->wanted = NULL;
+    sender->wantedCount = 0;
+    sender->wantedCapacity = 0;
+    sender->wantedChunkCount = -1;
+    
+    sender->credit = 0;
+}
+
+void ChunkSender_Shutdown(ChunkSender_t* sender)
+{
+    free(sender->chunks);
+    free(sender->wanted);
+    
+    sender->chunks = NULL;
+    sender->chunkCapacity = 0;
+    sender->wanted = NULL;
+    sender->wantedCapacity = 0;
+    sender->wantedCount = 0;
+}
+
+static void _ChunkSender_Reserve(ChunkSender_t* sender, int count)
+{
+    if (count <= sender->chunkCapacity) return;
+    
+    int capacity = sender->chunkCapacity ? sender->chunkCapacity : 64;
+    while (capacity < count) capacity *= 2;
+    
+    sender->chunks = realloc(sender->chunks, sizeof(ChunkSendState_t) * capacity);
+    assert(sender->chunks);
+    
+    memset(sender->chunks + sender->chunkCapacity, 0, sizeof(ChunkSendState_t) * (capacity - sender->chunkCapacity));
+    sender->chunkCapacity = capacity;
+}
+
+static void _ChunkSender_UpdateWanted(ChunkSender_t* sender, World_t* world, Vec3_t position)
+{
+    int center[3] =
+    {
+        (int)floorf(position.x / CHUNK_SIZE),
+        (int)floorf(position.y / CHUNK_SIZE),
+        (int)floorf(position.z / CHUNK_SIZE),
+    };
+    
+    if (center[0] == sender->wantedCenter[0] &&
+        center[1] == sender->wantedCenter[1] &&
+        center[2] == sender->wantedCenter[2] &&
+        world->chunkCount == sender->wantedChunkCount)
+    {
+        return;
+    }
+    
+    memcpy(sender->wantedCenter, center, sizeof(center));
+    sender->wantedChunkCount = world->chunkCount;
+    
+    const int side = STREAM_DIST * 2 + 1;
+    
+    if (sender->wantedCapacity < side * side * side)
+    {
+        sender->wantedCapacity = side * side * side;
+        sender->wanted = realloc(sender->wanted, sizeof(int) * sender->wantedCapacity);
+        assert(sender->wanted);
+    }
+    
+    int distances[(STREAM_DIST * 2 + 1) * (STREAM_DIST * 2 + 1) * (STREAM_DIST * 2 + 1)];
+    sender->wantedCount = 0;
+    
+    int dx, dy, dz;
+    for (dx = -STREAM_DIST; dx <= STREAM_DIST; ++dx)
+    {
+        for (dy = -STREAM_DIST; dy <= STREAM_DIST; ++dy)
+        {
+            for (dz = -STREAM_DIST; dz <= STREAM_DIST; ++dz)
+            {
+                int index = Octree_Find(&world->chunkTree, center[0] + dx, center[1] + dy, center[2] + dz);
+                if (index == -1) continue;
+                
+                int distance = dx * dx + dy * dy + dz * dz;
+                
+                /* nearest first, there are only a few so insertion sort is fine */
+                int i = sender->wantedCount++;
+                while (i > 0 && distances[i - 1] > distance)
+                {
+                    distances[i] = distances[i - 1];
+                    sender->wanted[i] = sender->wanted[i - 1];
+                    --i;
+                }
+                
+                distances[i] = distance;
+                sender->wanted[i] = index;
+            }
+        }
+    }
+}
+
+void ChunkSender_ReadAcks(ChunkSender_t* sender, World_t* world, NetReader_t* reader)
+{
+    int count = NetReader_U8(reader);
+    
+    int i;
+    for (i = 0; i < count; ++i)
+    {
+        int x = NetReader_U16(reader);
+        int y = NetReader_U16(reader);
+        int z = NetReader_U16(reader);
+        uint32_t revision = NetReader_U32(reader);
+        
+        if (reader->overflow) return;
+        
+        int index = Octree_Find(&world->chunkTree, x, y, z);
+        if (index == -1 || index >= sender->chunkCapacity) continue;
+        
+        ChunkSendState_t* state = sender->chunks + index;
+        
+        /* acks can arrive out of order and never claim more than was sent */
+        if (revision > state->ackedRevision && revision <= state->sentRevision)
+        {
+            state->ackedRevision = revision;
+        }
+    }
+}
+
+static void _ChunkStream_SendChanges(ChunkStream_t* stream,
+                                     ChunkSender_t* sender,
+                                     NetSocket_t* sock,
+                                     const NetAddress_t* to,
+                                     World_t* world,
+                                     uint32_t tick)
+{
+    unsigned char data[NET_MAX_PACKET];
+    NetWriter_t writer;
+    int groupsWritten = 0;
+    
+    int g;
+    for (g = 0; g < stream->groupCount; ++g)
+    {
+        const ChangeGroup_t* group = stream->groups + g;
+        ChunkSendState_t* state = sender->chunks + group->chunk;
+        
+        /* the client doesn't have what the changes were made to, it gets the whole chunk instead */
+        if (state->sentRevision != group->revision) continue;
+        
+        if (group->count > CHUNK_CHANGE_GROUP_MAX)
+        {
+            state->sentRevision = 0;
+            continue;
+        }
+        
+        int groupSize = CHUNK_CHANGE_GROUP_HEADER + group->count * CHUNK_CHANGE_SIZE;
+        
+        if (groupsWritten > 0 && (writer.size + groupSize > NET_MAX_PACKET || groupsWritten == 255))
+        {
+            data[1] = (unsigned char)groupsWritten;
+            Net_Send(sock, to, writer.data, writer.size);
+            stream->changeBytes += writer.size;
+            sender->credit -= writer.size;
+            groupsWritten = 0;
+        }
+        
+        if (groupsWritten == 0)
+        {
+            NetWriter_Init(&writer, data, sizeof(data));
+            NetWriter_U8(&writer, NET_MSG_BLOCKS);
+            NetWriter_U8(&writer, 0);
+        }
+        
+        const Chunk_t* chunk = world->chunks + group->chunk;
+        
+        NetWriter_U16(&writer, (uint16_t)chunk->x);
+        NetWriter_U16(&writer, (uint16_t)chunk->y);
+        NetWriter_U16(&writer, (uint16_t)chunk->z);
+        NetWriter_U32(&writer, group->revision);
+        NetWriter_U8(&writer, (uint8_t)group->count);
+        
+        int i;
+        for (i = 0; i < group->count; ++i)
+        {
+            const BlockChange_t* change = stream->changes + group->first + i;
+            NetWriter_U16(&writer, change->index);
+            NetWriter_U8(&writer, (uint8_t)change->type);
+        }
+        
+        ++groupsWritten;
+        stream->changesSent += group->count;
+        
+        state->sentRevision = group->revision + group->count;
+        state->sentTick = tick;
+    }
+    
+    if (groupsWritten > 0)
+    {
+        data[1] = (unsigned char)groupsWritten;
+        Net_Send(sock, to, writer.data, writer.size);
+        stream->changeBytes += writer.size;
+        sender->credit -= writer.size;
+    }
+}
+
+static void _ChunkStream_SendChunk(ChunkStream_t* stream,
+                                   ChunkSender_t* sender,
+                                   NetSocket_t* sock,
+                                   const NetAddress_t* to,
+                                   const Chunk_t* chunk,
+                                   const EncodedChunk_t* encoded)
+{
+    unsigned char data[NET_MAX_PACKET];
+    
+    int offset;
+    for (offset = 0; offset < encoded->size; offset += CHUNK_FRAGMENT_SIZE)
+    {
+        int length = encoded->size - offset;
+        if (length > CHUNK_FRAGMENT_SIZE) length = CHUNK_FRAGMENT_SIZE;
+        
+        NetWriter_t writer;
+        NetWriter_Init(&writer, data, sizeof(data));
+        
+        NetWriter_U8(&writer, NET_MSG_CHUNK);
+        NetWriter_U16(&writer, (uint16_t)chunk->x);
+        NetWriter_U16(&writer, (uint16_t)chunk->y);
+        NetWriter_U16(&writer, (uint16_t)chunk->z);
+        NetWriter_U32(&writer, encoded->revision);
+        NetWriter_U16(&writer, (uint16_t)encoded->size);
+        NetWriter_U16(&writer, (uint16_t)offset);
+        NetWriter_Bytes(&writer, encoded->data + offset, length);
+        
+        assert(!writer.overflow);
+        
+        Net_Send(sock, to, writer.data, writer.size);
+        stream->chunkBytes += writer.size;
+        sender->credit -= writer.size;
+    }
+    
+    stream->chunksSent++;
+}
+
+void ChunkStream_Send(ChunkStream_t* stream,
+                      ChunkSender_t* sender,
+                      World_t* world,
+                      NetSocket_t* sock,
+                      const NetAddress_t* to,
+                      Vec3_t position,
+                      uint32_t tick)
+{
+    _ChunkSender_Reserve(sender, world->chunkCount);
+    
+    /* unused budget doesn't carry over, a chunk bigger than a tick's worth borrows from the next few */
+    sender->credit += STREAM_BYTES_PER_TICK;
+    if (sender->credit > STREAM_BYTES_PER_TICK) sender->credit = STREAM_BYTES_PER_TICK;
+    
+    /* changes are small and likely right in front of the player, they go out whatever the budget */
+    _ChunkStream_SendChanges(stream, sender, sock, to, world, tick);
+    
+    _ChunkSender_UpdateWanted(sender, world, position);
+    
+    int i;
+    for (i = 0; i < sender->wantedCount && sender->credit > 0; ++i)
+    {
+        int index = sender->wanted[i];
+        const Chunk_t* chunk = world->chunks + index;
+        ChunkSendState_t* state = sender->chunks + index;
+        
+        if (state->sentRevision == chunk->revision)
+        {
+            if (state->ackedRevision == state->sentRevision || tick - state->sentTick < STREAM_RESEND_TICKS) continue;
+            
+            stream->resends++;
+        }
+        
+        const EncodedChunk_t* encoded = _ChunkStream_Encode(stream, world, index);
+        _ChunkStream_SendChunk(stream, sender, sock, to, chunk, encoded);
+        
+        state->sentRevision = chunk->revision;
+        state->sentTick = tick;
+    }
+}
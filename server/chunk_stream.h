@@ -0,0 +1,111 @@
+
+#ifndef ccraft_chunk_stream_h
+#define ccraft_chunk_stream_h
+
+#include "chunk_codec.h"
+
+/* sends each client the chunks around its player and keeps them up to date.
+ clients acknowledge what arrives (see chunk_mirror.h), anything unacknowledged for
+ STREAM_RESEND_TICKS is sent again whole. changes to chunks a client has go out as
+ batches of block changes, everything else in order of distance under a per client budget */
+
+/* chunks within this many of the player's chunk are sent */
+#define STREAM_DIST 2
+
+/* about 120 KB a second at 60 ticks a second */
+#define STREAM_BYTES_PER_TICK 2048
+#define STREAM_RESEND_TICKS 60
+
+/* what one client has of one chunk, revisions are 0 for nothing */
+typedef struct
+{
+    uint32_t sentRevision;
+    uint32_t ackedRevision;
+    uint32_t sentTick;
+} ChunkSendState_t;
+
+typedef struct
+{
+    /* indexed like the world's chunks */
+    ChunkSendState_t* chunks;
+    int chunkCapacity;
+    
+    /* chunks near the player nearest first, rebuilt when the player changes chunk or chunks load */
+    int* wanted;
+    int wantedCount;
+    int wantedCapacity;
+    int wantedCenter[3];
+    int wantedChunkCount;
+    
+    /* bytes that can be sent, refilled every tick */
+    int credit;
+} ChunkSender_t;
+
+/* a chunk's latest encoding, shared by every client it's sent to */
+typedef struct
+{
+    uint32_t revision;
+    int size;
+    unsigned char* data;
+} EncodedChunk_t;
+
+/* this tick's changes to one chunk */
+typedef struct
+{
+    int chunk;
+    
+    /* revision before the changes */
+    uint32_t revision;
+    
+    /* range in the stream's changes */
+    int first;
+    int count;
+} ChangeGroup_t;
+
+typedef struct
+{
+    EncodedChunk_t* encoded;
+    int encodedCapacity;
+    
+    /* the world's changes this tick sorted by chunk */
+    BlockChange_t* changes;
+    int changeCount;
+    int changeCapacity;
+    
+    ChangeGroup_t* groups;
+    int groupCount;
+    int groupCapacity;
+    
+    int chunksEncoded;
+    double encodeMs;
+    int chunksSent;
+    uint64_t chunkBytes;
+    int resends;
+    int changesSent;
+    uint64_t changeBytes;
+} ChunkStream_t;
+
+extern void ChunkStream_Init(ChunkStream_t* stream);
+extern void ChunkStream_Shutdown(ChunkStream_t* stream);
+
+/* takes the block changes the world recorded since the last call */
+extern void ChunkStream_BeginTick(ChunkStream_t* stream, World_t* world);
+
+extern void ChunkSender_Init(ChunkSender_t* sender);
+extern void ChunkSender_Shutdown(ChunkSender_t* sender);
+
+/* reads the rest of a NET_MSG_CHUNK_ACK after the type */
+extern void ChunkSender_ReadAcks(ChunkSender_t* sender, World_t* world, NetReader_t* reader);
+
+/* sends one client this tick's changes to chunks it has and as many missing chunks as its budget allows */
+extern void ChunkStream_Send(ChunkStream_t* stream,
+                             ChunkSender_t* sender,
+                             World_t* world,
+                             NetSocket_t* sock,
+                             const NetAddress_t* to,
+                             Vec3_t position,
+                             uint32_t tick);
+
+extern void ChunkStream_ResetStats(ChunkStream_t* stream);
+
+#endif
@@ -0,0 +1,140 @@
+
+#include "interest.h"
+#include <stdlib.h>
+#include <math.h>
+#include <assert.h>
+
+void Interest_Init(Interest_t* interest)
+{
+    SnapshotHistory_Init(&interest->snapshots);
+    interest->ack = 0;
+    interest->sent = 0;
+}
+
+void Interest_InitGrid(SpatialGrid_t* grid)
+{
+    SpatialGrid_Init(grid, MAX_ENTITIES, CHUNK_SIZE);
+}
+
+typedef struct
+{
+    float distanceSq;
+    int slot;
+} InterestCandidate_t;
+
+/* moves the k nearest candidates to the front in no particular order, in linear time on average */
+static void _Interest_SelectNearest(InterestCandidate_t* candidates, int count, int k)
+{
+    int low = 0;
+    int high = count - 1;
+    
+    while (low < high)
+    {
+        float pivot = candidates[(low + high) / 2].distanceSq;
+        
+        int i = low;
+        int j = high;
+        
+        while (i <= j)
+        {
+            while (candidates[i].distanceSq < pivot) ++i;
+            while (candidates[j].distanceSq > pivot) --j;
+            
+            if (i <= j)
+            {
+                InterestCandidate_t temp = candidates[i];
+                candidates[i] = candidates[j];
+                candidates[j] = temp;
+                ++i;
+                --j;
+            }
+        }
+        
+        /* everything in [low, j] is at most the pivot and everything in [i, high] at least */
+        if (k <= j) high = j;
+        else if (k >= i) low = i;
+        else return;
+    }
+}
+
+void Interest_Send(Interest_t* interest,
+                   const EntityStore_t* store,
+                   const SpatialGrid_t* grid,
+                   NetSocket_t* sock,
+                   const NetAddress_t* to,
+                   Vec3_t position,
+                   uint32_t seq,
+                   InterestStats_t* stats)
+{
+    assert(seq != 0);
+    
+    /* every block of every chunk within range */
+    Vec3_t low = Vec3_Create(floorf(position.x / CHUNK_SIZE) - INTEREST_DIST,
+                             floorf(position.y / CHUNK_SIZE) - INTEREST_DIST,
+                             floorf(position.z / CHUNK_SIZE) - INTEREST_DIST);
+    
+    AABB_t bounds = AABB_Create(Vec3_Scale(low, CHUNK_SIZE),
+                                Vec3_Scale(Vec3_Add(low, Vec3_Create(INTEREST_DIST * 2 + 1, INTEREST_DIST * 2 + 1, INTEREST_DIST * 2 + 1)), CHUNK_SIZE));
+    
+    static int slots[MAX_ENTITIES];
+    int nearby = SpatialGrid_QueryAABB(grid, store, bounds, slots, MAX_ENTITIES);
+    
+    /* the baseline has to be found before its slot could be reused */
+    const Snapshot_t* baseline = NULL;
+    if (interest->ack != 0 && interest->ack < seq && seq - interest->ack < SNAPSHOT_HISTORY)
+    {
+        baseline = SnapshotHistory_Find(&interest->snapshots, interest->ack);
+    }
+    
+    Snapshot_t* snapshot = SnapshotHistory_Slot(&interest->snapshots, seq);
+    snapshot->seq = seq;
+    snapshot->count = 0;
+    
+    int i;
+    if (nearby <= SNAPSHOT_MAX_ENTITIES)
+    {
+        for (i = 0; i < nearby; ++i)
+        {
+            Snapshot_Quantize(snapshot->entities + snapshot->count++, store, slots[i]);
+        }
+    }
+    else
+    {
+        static InterestCandidate_t candidates[MAX_ENTITIES];
+        
+        for (i = 0; i < nearby; ++i)
+        {
+            candidates[i].distanceSq = Vec3_DistSq(position, EntityStore_Position(store, slots[i]));
+            candidates[i].slot = slots[i];
+        }
+        
+        _Interest_SelectNearest(candidates, nearby, SNAPSHOT_MAX_ENTITIES);
+        
+        for (i = 0; i < SNAPSHOT_MAX_ENTITIES; ++i)
+        {
+            Snapshot_Quantize(snapshot->entities + snapshot->count++, store, candidates[i].slot);
+        }
+    }
+    
+    Snapshot_Sort(snapshot);
+    
+    unsigned char data[NET_MAX_PACKET];
+    NetWriter_t writer;
+    NetWriter_Init(&writer, data, sizeof(data));
+    
+    SnapshotEvents_t events;
+    Snapshot_Write(&writer, snapshot, baseline, &events);
+    
+    assert(!writer.overflow);
+    
+    Net_Send(sock, to, writer.data, writer.size);
+    interest->sent = seq;
+    
+    if (stats)
+    {
+        stats->nearby = nearby;
+        stats->sent = snapshot->count;
+        stats->bytes = writer.size;
+        stats->events = events;
+    }
+}
@@ -0,0 +1,52 @@
+
+#ifndef ccraft_interest_h
+#define ccraft_interest_h
+
+#include "snapshot.h"
+#include "grid.h"
+#include "world.h"
+
+/* picks the entities each client is sent. only entities within INTEREST_DIST chunks of the player
+ are considered, found through a grid with chunk sized cells so the cost follows the number nearby
+ rather than the number in the world. when there are more than fit in a snapshot the nearest win */
+
+#define INTEREST_DIST 2
+
+typedef struct
+{
+    /* snapshots sent, kept to delta against */
+    SnapshotHistory_t snapshots;
+    
+    /* newest snapshot the client says it has, 0 for none */
+    uint32_t ack;
+    
+    /* newest snapshot sent, the client can't have acknowledged anything past it */
+    uint32_t sent;
+} Interest_t;
+
+/* what one snapshot cost */
+typedef struct
+{
+    int nearby;
+    int sent;
+    int bytes;
+    SnapshotEvents_t events;
+} InterestStats_t;
+
+extern void Interest_Init(Interest_t* interest);
+
+/* entities in a grid of cells a chunk wide, for Interest_Send */
+extern void Interest_InitGrid(SpatialGrid_t* grid);
+
+/* builds the client's snapshot seq from the entities near position and sends it as a delta from
+ the newest one it acknowledged. grid must be built from the store this tick */
+extern void Interest_Send(Interest_t* interest,
+                          const EntityStore_t* store,
+                          const SpatialGrid_t* grid,
+                          NetSocket_t* sock,
+                          const NetAddress_t* to,
+                          Vec3_t position,
+                          uint32_t seq,
+                          InterestStats_t* stats);
+
+#endif
@@ -0,0 +1,202 @@
+
+#include "server.h"
+#include "bot.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <time.h>
+
+static Server_t _server;
+
+static volatile sig_atomic_t _running = 1;
+
+static void _Interrupt(int sig)
+{
+    _running = 0;
+}
+
+static void _Usage(const char* name)
+{
+    fprintf(stderr, "usage: %s [-port N] [-bots N] [-drops N] [-ticks N] [-unpaced]\n", name);
+    fprintf(stderr, "  -bots N    connect N wandering bots over loopback, the world is not saved\n");
+    fprintf(stderr, "  -drops N   scatter N items to pick up around where players start\n");
+    fprintf(stderr, "  -ticks N   stop after N ticks\n");
+    fprintf(stderr, "  -unpaced   run ticks back to back instead of %i a second\n", SERVER_TICK_RATE);
+}
+
+int main(int argc, char* argv[])
+{
+    int port = NET_DEFAULT_PORT;
+    int botCount = 0;
+    long maxTicks = -1;
+    int paced = 1;
+    int dropCount = 0;
+    
+    int i;
+    for (i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "-port") == 0 && i + 1 < argc)
+        {
+            port = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "-bots") == 0 && i + 1 < argc)
+        {
+            botCount = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "-ticks") == 0 && i + 1 < argc)
+        {
+            maxTicks = atol(argv[++i]);
+        }
+        else if (strcmp(argv[i], "-drops") == 0 && i + 1 < argc)
+        {
+            dropCount = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "-unpaced") == 0)
+        {
+            paced = 0;
+        }
+        else
+        {
+            _Usage(argv[0]);
+            return 1;
+        }
+    }
+    
+    if (botCount < 0 || botCount > SERVER_MAX_CLIENTS)
+    {
+        fprintf(stderr, "bots must be between 0 and %i\n", SERVER_MAX_CLIENTS);
+        return 1;
+    }
+    
+    if (!Server_Init(&_server, port))
+    {
+        fprintf(stderr, "can't open port %i\n", port);
+        return 1;
+    }
+    
+    printf("listening on port %i\n", Net_LocalPort(&_server.socket));
+    
+    /* fixed seed so runs can be compared */
+    unsigned int seed = 1;
+    
+    for (i = 0; i < dropCount; ++i)
+    {
+        Vec3_t position = Vec3_Create((rand_r(&seed) % 4096) / 64.0f,
+                                      (rand_r(&seed) % 4096) / 64.0f,
+                                      12.0f);
+        
+        Sim_SpawnDrop(&_server.sim, ENTITY_GIFT, ITEM_GIFT, position);
+    }
+    
+    Bot_t* bots = NULL;
+    
+    if (botCount > 0)
+    {
+        bots = malloc(sizeof(Bot_t) * botCount);
+        
+        for (i = 0; i < botCount; ++i)
+        {
+            if (!Bot_Init(bots + i, Net_Loopback(Net_LocalPort(&_server.socket)), i + 1))
+            {
+                fprintf(stderr, "can't open a socket for bot %i\n", i);
+                return 1;
+            }
+        }
+    }
+    
+    signal(SIGINT, _Interrupt);
+    
+    struct timespec next;
+    clock_gettime(CLOCK_MONOTONIC, &next);
+    
+    const long tickNs = 1000000000L / SERVER_TICK_RATE;
+    
+    while (_running && (maxTicks < 0 || (long)_server.tick < maxTicks))
+    {
+        for (i = 0; i < botCount; ++i)
+        {
+            Bot_Tick(bots + i);
+        }
+        
+        Server_Tick(&_server);
+        
+        if (_server.tick % (SERVER_TICK_RATE * 5) == 0)
+        {
+            Server_PrintStats(&_server);
+            Server_ResetStats(&_server);
+        }
+        
+        if (paced)
+        {
+            next.tv_nsec += tickNs;
+            if (next.tv_nsec >= 1000000000L)
+            {
+                next.tv_nsec -= 1000000000L;
+                ++next.tv_sec;
+            }
+            
+            clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+        }
+    }
+    
+    Server_PrintStats(&_server);
+    
+    if (botCount > 0)
+    {
+        int chunks = 0;
+        uint64_t bytes = 0;
+        double decodeMs = 0.0;
+        int changes = 0;
+        int rejected = 0;
+        int entered = 0;
+        int left = 0;
+        int updated = 0;
+        int snapshotsDropped = 0;
+        
+        for (i = 0; i < botCount; ++i)
+        {
+            const ChunkMirror_t* mirror = &bots[i].chunks;
+            chunks += mirror->chunksReceived;
+            bytes += mirror->chunkBytes;
+            decodeMs += mirror->decodeMs;
+            changes += mirror->changesApplied;
+            rejected += mirror->groupsRejected;
+            
+            entered += bots[i].entered;
+            left += bots[i].left;
+            updated += bots[i].updated;
+            snapshotsDropped += bots[i].snapshotsDropped;
+        }
+        
+        printf("bots: %i chunks received, %.0f bytes each, decoded in %.1f us each, %i block changes applied, %i change batches rejected\n",
+               chunks,
+               chunks > 0 ? (double)bytes / chunks : 0.0,
+               chunks > 0 ? decodeMs * 1000.0 / chunks : 0.0,
+               changes,
+               rejected);
+        
+        printf("bots: %i entities entered, %i left, %i updated, %i snapshots dropped\n",
+               entered,
+               left,
+               updated,
+               snapshotsDropped);
+    }
+    
+    for (i = 0; i < botCount; ++i)
+    {
+        Bot_Shutdown(bots + i);
+    }
+    free(bots);
+    
+    /* bots dig the world up, only keep what real players did */
+    if (botCount == 0)
+    {
+        printf("saving\n");
+        World_Save(&_server.sim.world);
+    }
+    
+    Server_Shutdown(&_server);
+    
+    return 0;
+}
@@ -0,0 +1,455 @@
+
+#include "server.h"
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <assert.h>
+
+static double _Server_Now(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1000.0 + t.tv_nsec / 1000000.0;
+}
+
+static inline float clampf(float t, float a, float b)
+{
+    return t > a ? (t < b ? t : b) : a;
+}
+
+int Server_Init(Server_t* server, int port)
+{
+    assert(server);
+    
+    if (!Net_Open(&server->socket, port)) return 0;
+    
+    Job_Init(0);
+    Sim_Init(&server->sim);
+    
+    /* clients are sent what changed instead of whole chunks */
+    server->sim.world.recordChanges = 1;
+    ChunkStream_Init(&server->chunkStream);
+    Interest_InitGrid(&server->interestGrid);
+    
+    memset(server->clients, 0, sizeof(server->clients));
+    server->clientCount = 0;
+    server->tick = 0;
+    
+    Server_ResetStats(server);
+    
+    return 1;
+}
+
+void Server_Shutdown(Server_t* server)
+{
+    int i;
+    for (i = 0; i < SERVER_MAX_CLIENTS; ++i)
+    {
+        Client_t* client = server->clients + i;
+        
+        if (client->active)
+        {
+            Player_Shutdown(&client->player);
+            ChunkSender_Shutdown(&client->chunks);
+        }
+        
+        client->active = 0;
+    }
+    
+    server->clientCount = 0;
+    
+    ChunkStream_Shutdown(&server->chunkStream);
+    SpatialGrid_Shutdown(&server->interestGrid);
+    Net_Close(&server->socket);
+    Job_Shutdown();
+}
+
+static Client_t* _Server_FindClient(Server_t* server, const NetAddress_t* address)
+{
+    int i;
+    for (i = 0; i < SERVER_MAX_CLIENTS; ++i)
+    {
+        Client_t* client = server->clients + i;
+        if (client->active && Net_AddressEqual(&client->address, address)) return client;
+    }
+    
+    return NULL;
+}
+
+static void _Server_SendWelcome(Server_t* server, const Client_t* client)
+{
+    unsigned char data[16];
+    NetWriter_t writer;
+    NetWriter_Init(&writer, data, sizeof(data));
+    
+    NetWriter_U8(&writer, NET_MSG_WELCOME);
+    NetWriter_U8(&writer, (uint8_t)(client - server->clients));
+    NetWriter_U8(&writer, SERVER_TICK_RATE);
+    
+    Net_Send(&server->socket, &client->address, writer.data, writer.size);
+}
+
+/* spread out so players don't land on each other, chunk coords can't go negative */
+static void _Server_Spawn(Player_t* player, int slot)
+{
+    player->position = Vec3_Create(1.0f + (slot % 8) * 4.0f, 1.0f + (slot / 8) * 4.0f, 10.0f);
+    player->velocity = Vec3_Zero();
+}
+
+static void _Server_Connect(Server_t* server, const NetAddress_t* from)
+{
+    Client_t* client = _Server_FindClient(server, from);
+    
+    /* already connected, the welcome must have been lost */
+    if (client)
+    {
+        _Server_SendWelcome(server, client);
+        return;
+    }
+    
+    int slot;
+    for (slot = 0; slot < SERVER_MAX_CLIENTS; ++slot)
+    {
+        if (!server->clients[slot].active) break;
+    }
+    
+    if (slot == SERVER_MAX_CLIENTS)
+    {
+        unsigned char reject = NET_MSG_REJECT;
+        Net_Send(&server->socket, from, &reject, 1);
+        return;
+    }
+    
+    client = server->clients + slot;
+    client->active = 1;
+    client->address = *from;
+    client->inputSeq = 0;
+    client->lastHeardTick = server->tick;
+    
+    Player_Init(&client->player);
+    _Server_Spawn(&client->player, slot);
+    
+    ChunkSender_Init(&client->chunks);
+    Interest_Init(&client->interest);
+    
+    memset(&client->input, 0, sizeof(client->input));
+    client->input.pitch = client->player.pitch;
+    client->input.yaw = client->player.yaw;
+    client->input.beltIndex = -1;
+    
+    ++server->clientCount;
+    
+    _Server_SendWelcome(server, client);
+}
+
+static void _Server_Disconnect(Server_t* server, Client_t* client)
+{
+    Player_Shutdown(&client->player);
+    ChunkSender_Shutdown(&client->chunks);
+    client->active = 0;
+    --server->clientCount;
+}
+
+static inline int _Server_ClampAxis(int8_t value)
+{
+    return value < -1 ? -1 : (value > 1 ? 1 : value);
+}
+
+static void _Server_ReadInput(Client_t* client, NetReader_t* reader)
+{
+    uint32_t seq = NetReader_U32(reader);
+    int8_t forward = (int8_t)NetReader_U8(reader);
+    int8_t side = (int8_t)NetReader_U8(reader);
+    uint8_t buttons = NetReader_U8(reader);
+    int8_t beltIndex = (int8_t)NetReader_U8(reader);
+    float pitch = NetReader_F32(reader);
+    float yaw = NetReader_F32(reader);
+    uint32_t snapshotAck = NetReader_U32(reader);
+    
+    if (reader->overflow) return;
+    
+    /* an ack for a snapshot that was never sent would pick a baseline the client doesn't have */
+    if (snapshotAck > client->interest.ack && snapshotAck <= client->interest.sent)
+    {
+        client->interest.ack = snapshotAck;
+    }
+    
+    /* datagrams can arrive out of order, only the newest input counts */
+    if (seq <= client->inputSeq) return;
+    client->inputSeq = seq;
+    
+    PlayerInput_t* input = &client->input;
+    
+    /* the client only picks which way to go, speeds are up to the simulation */
+    input->forward = _Server_ClampAxis(forward);
+    input->side = _Server_ClampAxis(side);
+    input->jumping = (buttons & INPUT_BUTTON_JUMP) != 0;
+    input->digging = (buttons & INPUT_BUTTON_DIG) != 0;
+    input->placing = (buttons & INPUT_BUTTON_PLACE) != 0;
+    input->beltIndex = beltIndex;
+    
+    if (isfinite(pitch)) input->pitch = clampf(pitch, -89.0f, 89.0f);
+    if (isfinite(yaw)) input->yaw = fmodf(yaw, 360.0f);
+}
+
+static void _Server_Receive(Server_t* server)
+{
+    unsigned char data[NET_MAX_PACKET];
+    NetAddress_t from;
+    int size;
+    
+    while ((size = Net_Receive(&server->socket, &from, data, sizeof(data))) > 0)
+    {
+        NetReader_t reader;
+        NetReader_Init(&reader, data, size);
+        
+        int type = NetReader_U8(&reader);
+        
+        if (type == NET_MSG_CONNECT)
+        {
+            _Server_Connect(server, &from);
+            continue;
+        }
+        
+        /* anything else has to come from someone connected */
+        Client_t* client = _Server_FindClient(server, &from);
+        if (!client) continue;
+        
+        client->lastHeardTick = server->tick;
+        
+        switch (type)
+        {
+            case NET_MSG_INPUT:
+                _Server_ReadInput(client, &reader);
+                break;
+            case NET_MSG_CHUNK_ACK:
+                ChunkSender_ReadAcks(&client->chunks, &server->sim.world, &reader);
+                break;
+            case NET_MSG_DISCONNECT:
+                _Server_Disconnect(server, client);
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+/* message header, then one entry per other player */
+#define STATE_HEADER_SIZE (1 + 4 + 4 + 12 + 12 + 1 + 1)
+#define STATE_PLAYER_SIZE (1 + 12 + 4 + 4)
+
+static void _Server_SendState(Server_t* server, const Client_t* client)
+{
+    unsigned char data[NET_MAX_PACKET];
+    NetWriter_t writer;
+    NetWriter_Init(&writer, data, sizeof(data));
+    
+    const Player_t* player = &client->player;
+    
+    NetWriter_U8(&writer, NET_MSG_STATE);
+    NetWriter_U32(&writer, server->tick);
+    NetWriter_U32(&writer, client->inputSeq);
+    
+    NetWriter_F32(&writer, player->position.x);
+    NetWriter_F32(&writer, player->position.y);
+    NetWriter_F32(&writer, player->position.z);
+    NetWriter_F32(&writer, player->velocity.x);
+    NetWriter_F32(&writer, player->velocity.y);
+    NetWriter_F32(&writer, player->velocity.z);
+    NetWriter_U8(&writer, player->onGround != 0);
+    
+    /* as many others as fit in one datagram */
+    int room = (NET_MAX_PACKET - STATE_HEADER_SIZE) / STATE_PLAYER_SIZE;
+    int count = server->clientCount - 1;
+    if (count > room) count = room;
+    
+    NetWriter_U8(&writer, (uint8_t)count);
+    
+    int i;
+    for (i = 0; i < SERVER_MAX_CLIENTS && count > 0; ++i)
+    {
+        const Client_t* other = server->clients + i;
+        if (!other->active || other == client) continue;
+        
+        NetWriter_U8(&writer, (uint8_t)i);
+        NetWriter_F32(&writer, other->player.position.x);
+        NetWriter_F32(&writer, other->player.position.y);
+        NetWriter_F32(&writer, other->player.position.z);
+        NetWriter_F32(&writer, other->player.yaw);
+        NetWriter_F32(&writer, other->player.pitch);
+        --count;
+    }
+    
+    assert(!writer.overflow);
+    
+    Net_Send(&server->socket, &client->address, writer.data, writer.size);
+}
+
+void Server_Tick(Server_t* server)
+{
+    assert(server);
+    
+    double start = _Server_Now();
+    uint64_t bytesIn = server->socket.bytesReceived;
+    uint64_t bytesOut = server->socket.bytesSent;
+    
+    _Server_Receive(server);
+    
+    Player_t* players[SERVER_MAX_CLIENTS];
+    int playerCount = 0;
+    
+    int i;
+    for (i = 0; i < SERVER_MAX_CLIENTS; ++i)
+    {
+        Client_t* client = server->clients + i;
+        if (!client->active) continue;
+        
+        if (server->tick - client->lastHeardTick > SERVER_TIMEOUT_TICKS)
+        {
+            printf("client %i timed out\n", i);
+            _Server_Disconnect(server, client);
+            continue;
+        }
+        
+        players[playerCount++] = &client->player;
+    }
+    
+    double simStart = _Server_Now();
+    
+    for (i = 0; i < SERVER_MAX_CLIENTS; ++i)
+    {
+        Client_t* client = server->clients + i;
+        if (!client->active) continue;
+        
+        Sim_MovePlayer(&server->sim, &client->player, &client->input);
+        
+        /* fell out of the world */
+        if (client->player.position.z < SERVER_RESPAWN_DEPTH) _Server_Spawn(&client->player, i);
+        
+        Sim_LoadAround(&server->sim, &client->player, SERVER_LOAD_DIST);
+    }
+    
+    Sim_UpdateEntities(&server->sim, players, playerCount);
+    
+    for (i = 0; i < SERVER_MAX_CLIENTS; ++i)
+    {
+        Client_t* client = server->clients + i;
+        if (!client->active) continue;
+        
+        Sim_UseTool(&server->sim, &client->player, &client->input);
+    }
+    
+    double simEnd = _Server_Now();
+    
+    ChunkStream_BeginTick(&server->chunkStream, &server->sim.world);
+    
+    const EntityStore_t* store = &server->sim.world.entities;
+    SpatialGrid_Build(&server->interestGrid, store);
+    
+    ServerStats_t* stats = &server->stats;
+    
+    for (i = 0; i < SERVER_MAX_CLIENTS; ++i)
+    {
+        Client_t* client = server->clients + i;
+        if (!client->active) continue;
+        
+        _Server_SendState(server, client);
+        
+        ChunkStream_Send(&server->chunkStream,
+                         &client->chunks,
+                         &server->sim.world,
+                         &server->socket,
+                         &client->address,
+                         client->player.position,
+                         server->tick);
+        
+        double interestStart = _Server_Now();
+        
+        InterestStats_t interest;
+        Interest_Send(&client->interest,
+                      store,
+                      &server->interestGrid,
+                      &server->socket,
+                      &client->address,
+                      client->player.position,
+                      server->tick + 1,
+                      &interest);
+        
+        stats->interestMs += _Server_Now() - interestStart;
+        stats->snapshots++;
+        stats->snapshotNearby += interest.nearby;
+        stats->snapshotEntities += interest.sent;
+        stats->snapshotBytes += interest.bytes;
+        stats->entered += interest.events.entered;
+        stats->left += interest.events.left;
+        stats->updated += interest.events.updated;
+        stats->fullBytes += SNAPSHOT_HEADER_SIZE + store->count * SNAPSHOT_ENTER_SIZE;
+    }
+    
+    ++server->tick;
+    
+    double tickMs = _Server_Now() - start;
+    
+    ++stats->ticks;
+    stats->tickMs += tickMs;
+    stats->simMs += simEnd - simStart;
+    if (tickMs > stats->maxTickMs) stats->maxTickMs = tickMs;
+    stats->playerTicks += playerCount;
+    stats->bytesIn += server->socket.bytesReceived - bytesIn;
+    stats->bytesOut += server->socket.bytesSent - bytesOut;
+}
+
+void Server_PrintStats(const Server_t* server)
+{
+    const ServerStats_t* stats = &server->stats;
+    if (stats->ticks == 0) return;
+    
+    /* bandwidth is per second of game time, which is wall time unless running unpaced */
+    double seconds = (double)stats->ticks / SERVER_TICK_RATE;
+    
+    printf("tick %u: %i players, tick %.3f ms (sim %.3f ms, max %.3f ms), %.1f us per player, in %.1f KB/s, out %.1f KB/s\n",
+           server->tick,
+           server->clientCount,
+           stats->tickMs / stats->ticks,
+           stats->simMs / stats->ticks,
+           stats->maxTickMs,
+           stats->playerTicks > 0 ? stats->simMs * 1000.0 / stats->playerTicks : 0.0,
+           stats->bytesIn / seconds / 1024.0,
+           stats->bytesOut / seconds / 1024.0);
+    
+    if (stats->snapshots > 0)
+    {
+        printf("    entities: %i in world, %.1f nearby and %.1f sent per client, %.0f bytes per snapshot (%.0f to send all in full), %i entered, %i left, %i updated, %.1f us per client\n",
+               server->sim.world.entities.count,
+               (double)stats->snapshotNearby / stats->snapshots,
+               (double)stats->snapshotEntities / stats->snapshots,
+               (double)stats->snapshotBytes / stats->snapshots,
+               (double)stats->fullBytes / stats->snapshots,
+               stats->entered,
+               stats->left,
+               stats->updated,
+               stats->interestMs * 1000.0 / stats->snapshots);
+    }
+    
+    const ChunkStream_t* stream = &server->chunkStream;
+    
+    if (stream->chunksSent > 0 || stream->changesSent > 0)
+    {
+        printf("    chunks: %i sent, %.0f bytes each (%i raw), %i resent, %i encoded at %.1f us each, %i block changes in %.1f KB\n",
+               stream->chunksSent,
+               stream->chunksSent > 0 ? (double)stream->chunkBytes / stream->chunksSent : 0.0,
+               CHUNK_VOLUME,
+               stream->resends,
+               stream->chunksEncoded,
+               stream->chunksEncoded > 0 ? stream->encodeMs * 1000.0 / stream->chunksEncoded : 0.0,
+               stream->changesSent,
+               stream->changeBytes / 1024.0);
+    }
+}
+
+void Server_ResetStats(Server_t* server)
+{
+    memset(&server->stats, 0, sizeof(server->stats));
+    ChunkStream_ResetStats(&server->chunkStream);
+}
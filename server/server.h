@@ -0,0 +1,103 @@
+
+#ifndef ccraft_server_h
+#define ccraft_server_h
+
+#include "sim.h"
+#include "net.h"
+#include "chunk_stream.h"
+#include "interest.h"
+
+/* runs the simulation for every connected player and sends them the result.
+ clients only ever send input, everything they see comes from here */
+
+#define SERVER_MAX_CLIENTS 64
+#define SERVER_TICK_RATE 60
+
+/* clients that go quiet for this many ticks are dropped */
+#define SERVER_TIMEOUT_TICKS (SERVER_TICK_RATE * 5)
+
+#define SERVER_LOAD_DIST 2
+
+/* players below this are put back where they started */
+#define SERVER_RESPAWN_DEPTH -64.0f
+
+/* bits of the buttons byte in an input message */
+enum
+{
+    INPUT_BUTTON_JUMP = 1 << 0,
+    INPUT_BUTTON_DIG = 1 << 1,
+    INPUT_BUTTON_PLACE = 1 << 2,
+};
+
+typedef struct
+{
+    int active;
+    NetAddress_t address;
+    
+    Player_t player;
+    
+    /* newest input received, held until a newer one arrives */
+    PlayerInput_t input;
+    uint32_t inputSeq;
+    
+    uint32_t lastHeardTick;
+    
+    ChunkSender_t chunks;
+    Interest_t interest;
+} Client_t;
+
+/* collected since the last Server_ResetStats */
+typedef struct
+{
+    int ticks;
+    double tickMs;
+    double simMs;
+    double maxTickMs;
+    
+    /* sum over ticks of the clients connected during them */
+    int playerTicks;
+    
+    uint64_t bytesIn;
+    uint64_t bytesOut;
+    
+    /* entity snapshots */
+    int snapshots;
+    int snapshotNearby;
+    int snapshotEntities;
+    uint64_t snapshotBytes;
+    int entered;
+    int left;
+    int updated;
+    double interestMs;
+    
+    /* bytes if every entity were sent to every client in full */
+    uint64_t fullBytes;
+} ServerStats_t;
+
+typedef struct
+{
+    Sim_t sim;
+    NetSocket_t socket;
+    
+    Client_t clients[SERVER_MAX_CLIENTS];
+    int clientCount;
+    
+    uint32_t tick;
+    
+    ChunkStream_t chunkStream;
+    SpatialGrid_t interestGrid;
+    
+    ServerStats_t stats;
+} Server_t;
+
+/* starts the job system and the simulation, returns 0 if the port can't be opened */
+extern int Server_Init(Server_t* server, int port);
+extern void Server_Shutdown(Server_t* server);
+
+/* reads every waiting message, steps the simulation once and sends each client its state */
+extern void Server_Tick(Server_t* server);
+
+extern void Server_PrintStats(const Server_t* server);
+extern void Server_ResetStats(Server_t* server);
+
+#endif
@@ -0,0 +1,544 @@
+
+#include "sim.h"
+#include <stdlib.h>
+
+static inline float clampf(float t, float a, float b)
+{
+    return t > a ? (t < b ? t : b) : a;
+}
+
+void Player_Init(Player_t* player)
+{
+    player->position = Vec3_Create(1.0f, 1.0f, 10.0f);
+    player->pitch = 90.0f;
+    player->yaw = 0.0f;
+    player->velocity = Vec3_Zero();
+    player->onGround = 0;
+    
+    player->radius = 0.25f;
+    player->height = 1.6f;
+    
+    player->groundBlockType = BLOCK_AIR;
+    
+    Inventory_Init(&player->belt, 8, 1);
+    Inventory_Init(&player->pack, 10, 4);
+    
+    Inventory_AddItem(&player->pack, ITEM_SHOVEL, 1);
+    Inventory_AddItem(&player->pack, ITEM_GIFT, 10);
+    
+    player->cx = -1;
+    player->cy = -1;
+    player->cz = -1;
+}
+
+void Player_Shutdown(Player_t* player)
+{
+    Inventory_Shutdown(&player->belt);
+    Inventory_Shutdown(&player->pack);
+}
+
+void Player_Pickup(Player_t* player, int itemType, int qty)
+{
+    if (!Inventory_AddItem(&player->belt, itemType, qty))
+    {
+        Inventory_AddItem(&player->pack, itemType, qty);
+    }
+}
+
+void Sim_Init(Sim_t* sim)
+{
+    World_Init(&sim->world);
+    SpatialGrid_Init(&sim->entityGrid, MAX_ENTITIES, 1.0f);
+    
+    int i;
+    for (i = 0; i < ENTITY_MAX_PARTS; ++i)
+    {
+        EntityCommandBuffer_Init(&sim->entityParts[i].commands, MAX_ENTITIES);
+    }
+    
+    sim->entityBatchSize = 0;
+    
+    sim->gravity = Vec3_Create(0.0f, 0.0f, -0.008f);
+    sim->entityGravity = Vec3_Create(0.0f, 0.0f, -0.006f);
+}
+
+void Sim_MovePlayer(Sim_t* sim, Player_t* player, const PlayerInput_t* input)
+{
+    player->pitch = input->pitch;
+    player->yaw = input->yaw;
+    
+    float maxSpeed = 0.1f;
+    
+    if (player->groundBlockType == BLOCK_TRACK)
+    {
+        maxSpeed *= 1.8f;
+    }
+    else if (player->groundBlockType == BLOCK_MUD)
+    {
+        maxSpeed *= 0.5f;
+    }
+    
+    if (fabs(player->velocity.x) < maxSpeed && fabs(player->velocity.y) < maxSpeed)
+    {
+        if (input->forward != 0)
+        {
+            float rads = (player->yaw * M_PI) / 180.0f;
+            Vec3_t forwardVec = Vec3_Create(cosf(rads), sinf(rads), 0.0f);
+            
+            player->velocity = Vec3_Add(player->velocity, Vec3_Scale(forwardVec, input->forward * 0.05f));
+        }
+        
+        if (input->side != 0)
+        {
+            float rads = (player->yaw * M_PI) / 180.0f;
+            Vec3_t sideVec = Vec3_Create(cosf(rads - M_PI / 2), sinf(rads - M_PI / 2), 0.0f);
+            player->velocity = Vec3_Add(player->velocity, Vec3_Scale(sideVec, input->side * 0.05f));
+        }
+    }
+    
+    if (input->jumping != 0 && player->onGround)
+    {
+        player->velocity.z = 0.15f;
+    }
+    
+    
+    //if (!player->onGround)
+    {
+        player->velocity = Vec3_Add(player->velocity, sim->gravity);
+    }
+    
+    int x = floorf(player->position.x);
+    int y = floorf(player->position.y);
+    int z = floorf(player->position.z);
+    
+    Vec3_t dest = Vec3_Add(player->position, player->velocity);
+    
+    
+    int dx = floorf(dest.x);
+    int dy = floorf(dest.y);
+    int dz = floorf(dest.z);
+    
+    Block_t* block;
+    
+    //if (dx != x)
+    {
+        block = World_GetBlockAt(&sim->world, dx, y, z);
+        if (block && block->type != BLOCK_AIR)
+        {
+            if (block->type == BLOCK_BOUNCE_PAD)
+            {
+                player->velocity.x = -player->velocity.x * 0.95f;
+            }
+            else
+            {
+                player->velocity.x = 0.0f;
+                player->position.x = clampf(player->position.x, x + 0.001f , x + 0.999f);
+            }
+        }
+    }
+    
+    x = floorf(player->position.x);
+    
+    //if (dy != y)
+    {
+        block = World_GetBlockAt(&sim->world, x, dy, z);
+        if (block && block->type != BLOCK_AIR)
+        {
+            if (block->type == BLOCK_BOUNCE_PAD)
+            {
+                player->velocity.y = -player->velocity.y * 0.95f;
+            }
+            else
+            {
+                player->velocity.y = 0.0f;
+                player->position.y = clampf(player->position.y, y + 0.001f, y + 0.999f);
+            }
+        }
+    }
+    
+    y = floorf(player->position.y);
+    
+    //if (dz != z)
+    {
+        block = World_GetBlockAt(&sim->world, x, y, dz);
+        if (block && block->type != BLOCK_AIR)
+        {
+            if (block->type == BLOCK_BOUNCE_PAD)
+            {
+                player->velocity.z = -player->velocity.z * 0.95f;
+            }
+            else
+            {
+                player->velocity.z = 0.0f;
+                player->position.z = clampf(player->position.z, z + 0.001f, z + 0.999f);
+                
+                /* block is below us, not above */
+                if (dz < z)
+                {
+                    player->groundBlockType = block->type;
+                    player->onGround = 1;
+                }
+            }
+        }
+        else
+        {
+            player->onGround = 0;
+        }
+    }
+    
+    
+    if (player->groundBlockType == BLOCK_ICE)
+    {
+        player->velocity.x *= .97;
+        player->velocity.y *= .97;
+    }
+    else
+    {
+        player->velocity.x *= .85;
+        player->velocity.y *= .85;
+    }
+    
+    player->position = Vec3_Add(player->position, player->velocity);
+}
+
+
+void Sim_LoadAround(Sim_t* sim, Player_t* player, int loadDist)
+{
+    int cx = floorf(player->position.x) / CHUNK_SIZE;
+    int cy = floorf(player->position.y) / CHUNK_SIZE;
+    int cz = floorf(player->position.z) / CHUNK_SIZE;
+    
+    if (cx != player->cx ||
+        cy != player->cy ||
+        cz != player->cz)
+    {
+        assert(loadDist <= LOAD_DIST_MAX);
+        
+        int coords[(LOAD_DIST_MAX * 2) * (LOAD_DIST_MAX * 2) * 3];
+        int count = 0;
+        
+        int x, y;
+        for (x = -loadDist; x < loadDist; x ++)
+        {
+            for (y = -loadDist; y < loadDist; y ++)
+            {
+                if (cx + x >= 0 && cy + y >= 0)
+                {
+                    coords[count * 3 + 0] = cx + x;
+                    coords[count * 3 + 1] = cy + y;
+                    coords[count * 3 + 2] = 0;
+                    ++count;
+                }
+            }
+        }
+        
+        World_PrepareChunks(&sim->world, coords, count);
+        
+        /*
+         int i;
+         for (i = 0; i < sim->world.chunkCount; i ++)
+         {
+         if (abs(sim->world.chunks[i].x - cx) > unloadDist ||
+         abs(sim->world.chunks[i].y - cy) > unloadDist)
+         {
+         sim->world.chunks[i].needsToUnload = 1;
+         }
+         }
+         */
+        
+        player->cx = cx;
+        player->cy = cy;
+        player->cz = cz;
+    }
+}
+
+int Sim_SpawnDrop(Sim_t* sim, int type, int itemType, Vec3_t position)
+{
+    int id = World_SpawnEntity(&sim->world, type);
+    if (id == -1) return -1;
+    
+    EntityStore_t* store = &sim->world.entities;
+    int slot = EntityStore_Slot(store, id);
+    
+    store->pickupType[slot] = itemType;
+    store->qty[slot] = 1;
+    store->size[slot] = 0.5f;
+    store->height[slot] = 0.5f;
+    EntityStore_SetPosition(store, slot, position);
+    
+    return id;
+}
+
+/* entities that fall this far below the world are removed */
+#define ENTITY_KILL_DEPTH -64.0f
+
+/* smaller batches cost more to schedule than they save */
+#define ENTITY_BATCH_MIN 256
+
+/* runs on job workers - reads the world but only writes entity slots [begin, end) and its own part */
+static void _Sim_StepEntities(void* data, int begin, int end)
+{
+    Sim_t* sim = data;
+    EntityStore_t* store = &sim->world.entities;
+    EntityPart_t* result = sim->entityParts + begin / sim->entityBatchSize;
+    
+    float maxSize = 0.0f;
+    
+    /* block lookups can't be vectorized, so resolve them first */
+    int i;
+    for (i = begin; i < end; i ++)
+    {
+        int ex = floorf(store->x[i]);
+        int ey = floorf(store->y[i]);
+        int ez = floorf(store->z[i]);
+        
+        Block_t* eblock = World_GetBlockAt(&sim->world, ex, ey, ez - 1);
+        
+        if (!eblock || eblock->type == BLOCK_AIR || store->z[i] - (float)ez > 0.25f)
+        {
+            store->airborne[i] = 1.0f;
+        }
+        else
+        {
+            store->airborne[i] = 0.0f;
+        }
+        
+        maxSize = fmaxf(maxSize, store->size[i]);
+    }
+    
+    EntityStore_Integrate(store, begin, end, sim->entityGravity);
+    
+    for (i = begin; i < end; i ++)
+    {
+        if (store->z[i] < ENTITY_KILL_DEPTH)
+        {
+            EntityCommandBuffer_Push(&result->commands, ENTITY_CMD_REMOVE, store->id[i]);
+        }
+    }
+    
+    result->maxSize = maxSize;
+}
+
+void Sim_UpdateEntities(Sim_t* sim, Player_t* const* players, int playerCount)
+{
+    EntityStore_t* store = &sim->world.entities;
+    
+    /* enough batches to keep every worker busy */
+    int batchSize = (store->count + ENTITY_MAX_PARTS - 1) / ENTITY_MAX_PARTS;
+    if (batchSize < ENTITY_BATCH_MIN) batchSize = ENTITY_BATCH_MIN;
+    
+    int partCount = (store->count + batchSize - 1) / batchSize;
+    sim->entityBatchSize = batchSize;
+    
+    int i;
+    for (i = 0; i < partCount; i ++)
+    {
+        sim->entityParts[i].commands.count = 0;
+        sim->entityParts[i].maxSize = 0.0f;
+    }
+    
+    Job_ParallelFor(_Sim_StepEntities, sim, store->count, batchSize);
+    
+    /* parts are fixed slot ranges in ascending order, so applying them in order
+     gives the same result for any number of workers */
+    float maxSize = 0.0f;
+    
+    for (i = 0; i < partCount; i ++)
+    {
+        EntityPart_t* part = sim->entityParts + i;
+        
+        int j;
+        for (j = 0; j < part->commands.count; j ++)
+        {
+            const EntityCommand_t* command = part->commands.commands + j;
+            
+            switch (command->type)
+            {
+                case ENTITY_CMD_REMOVE:
+                    EntityStore_Remove(store, command->id);
+                    break;
+            }
+        }
+        
+        maxSize = fmaxf(maxSize, part->maxSize);
+    }
+    
+    SpatialGrid_Build(&sim->entityGrid, store);
+    
+    int p;
+    for (p = 0; p < playerCount; p ++)
+    {
+        Player_t* player = players[p];
+        
+        /* only entities near the player can be picked up */
+        int nearby[256];
+        int nearbyCount = SpatialGrid_QueryRadius(&sim->entityGrid,
+                                                  store,
+                                                  player->position,
+                                                  sqrtf(maxSize * maxSize + 0.25f),
+                                                  nearby,
+                                                  256);
+        
+        /* slots move as entities are removed, so hold on to ids */
+        int pickedUp[256];
+        int pickedUpCount = 0;
+        
+        for (i = 0; i < nearbyCount; i ++)
+        {
+            int s = nearby[i];
+            
+            if (Vec3_DistSq(player->position, EntityStore_Position(store, s)) < (store->size[s] * store->size[s] + 0.25f))
+            {
+                pickedUp[pickedUpCount++] = store->id[s];
+            }
+        }
+        
+        for (i = 0; i < pickedUpCount; i ++)
+        {
+            int s = EntityStore_Slot(store, pickedUp[i]);
+            Player_Pickup(player, store->pickupType[s], store->qty[s]);
+            EntityStore_Remove(store, pickedUp[i]);
+        }
+        
+        /* removing shuffles slots, the grid has to catch up before the next player's query */
+        if (pickedUpCount > 0) SpatialGrid_Build(&sim->entityGrid, store);
+    }
+}
+
+Block_t* Sim_UseTool(Sim_t* sim, Player_t* player, const PlayerInput_t* input)
+{
+    Quat_t quat = Quat_FromEuler(player->pitch, player->yaw, 0.0f);
+    Vec3_t targetDir = Quat_RotateVec3(quat, Vec3_Create(1.0f, 0.0f, 0.0f));
+    Vec3_t eye = Vec3_Add(player->position, Vec3_Create(0.0f, 0.0f, PLAYER_EYE_HEIGHT));
+    
+    RayHit_t hit;
+    Block_t* block = NULL;
+    
+    int tx = 0, ty = 0, tz = 0;
+    
+    if (World_Raycast(&sim->world, eye, targetDir, PLAYER_REACH, &hit))
+    {
+        block = hit.block;
+        tx = hit.x;
+        ty = hit.y;
+        tz = hit.z;
+    }
+    
+    /* block is reused below for the one being placed */
+    Block_t* target = block;
+    
+    Inventory_t* inv = &player->belt;
+    
+    if (input->beltIndex >= 0 && input->beltIndex < inv->width * inv->height)
+    {
+        inv->selectedItem = input->beltIndex;
+    }
+    
+    int invIndex = inv->selectedItem;
+    
+    /* nothing selected works like an empty hand */
+    int tool = (invIndex != -1) ? inv->items[invIndex].type : ITEM_NONE;
+    
+    if (tool == ITEM_SHOVEL)
+    {
+        if (input->digging)
+        {
+            if (block && block->type == BLOCK_GRASS)
+            {
+                block->type = BLOCK_DIRT;
+                
+                Sim_SpawnDrop(sim, ENTITY_TURF, ITEM_TURF, Vec3_Create(tx + 0.5f, ty + 0.5f, tz + 1.5f));
+                
+                World_UpdateBlockAt(&sim->world, tx, ty, tz);
+            }
+        }
+    }
+    else if (tool == ITEM_TURF)
+    {
+        if (input->placing)
+        {
+            if (block && block->type == BLOCK_DIRT)
+            {
+                block->type = BLOCK_GRASS;
+                Inventory_RemoveItem(inv, invIndex, 1);
+                World_UpdateBlockAt(&sim->world, tx, ty, tz);
+            }
+        }
+    }
+    else
+    {
+        /* digging */
+        if (input->digging)
+        {
+            if (block && block->type != BLOCK_SOLID)
+            {
+                if (block->type == BLOCK_STONE || block->type == BLOCK_DIRT || block->type == BLOCK_GRASS || block->type == BLOCK_GIFT)
+                {
+                    int type;
+                    int itemType;
+                    
+                    switch (block->type)
+                    {
+                        case BLOCK_STONE:
+                            type = ENTITY_STONE;
+                            itemType = ITEM_STONE;
+                            break;
+                        case BLOCK_DIRT:
+                            type = ENTITY_DIRT;
+                            itemType = ITEM_DIRT;
+                            break;
+                        case BLOCK_GRASS:
+                            type = ENTITY_DIRT;
+                            itemType = ITEM_DIRT;
+                            break;
+                        case BLOCK_GIFT:
+                            type = ENTITY_GIFT;
+                            itemType = ITEM_NONE + rand() % ITEM_COUNT;
+                    }
+                    
+                    Sim_SpawnDrop(sim, type, itemType, Vec3_Create(tx + 0.5f, ty + 0.5f, tz + 0.5f));
+                }
+                
+                block->type = BLOCK_AIR;
+                
+                World_UpdateBlockAt(&sim->world, tx, ty, tz);
+            }
+        }
+        else if (input->placing && block)
+        {
+            /* place against the face that was hit */
+            tx += hit.nx;
+            ty += hit.ny;
+            tz += hit.nz;
+            
+            block = World_GetBlockAt(&sim->world, tx, ty, tz);
+            
+            if (block && block->type == BLOCK_AIR)
+            {
+                if (invIndex != -1 && inv->items[invIndex].type != ITEM_NONE)
+                {
+                    switch (inv->items[invIndex].type)
+                    {
+                        case ITEM_DIRT:
+                            block->type = BLOCK_DIRT;
+                            break;
+                        case ITEM_STONE:
+                            block->type = BLOCK_STONE;
+                            break;
+                        case ITEM_GIFT:
+                            block->type = BLOCK_GIFT;
+                        
+                        default:
+                            break;
+                    }
+                    
+                    Inventory_RemoveItem(inv, invIndex, 1);
+                }
+                
+                World_UpdateBlockAt(&sim->world, tx, ty, tz);
+            }
+        }
+    }
+    
+    return target;
+}
@@ -0,0 +1,102 @@
+
+#ifndef ccraft_sim_h
+#define ccraft_sim_h
+
+#include "vec_math.h"
+#include "world.h"
+#include "grid.h"
+#include "inventory.h"
+#include "job.h"
+
+/* the world simulation, without anything that draws or reads devices.
+ the game runs it for one local player and the server runs it for everyone connected */
+
+typedef struct
+{
+    Vec3_t position;
+    float pitch;
+    float yaw;
+    Vec3_t velocity;
+    int onGround;
+    
+    float radius;
+    float height;
+    
+    int groundBlockType;
+    
+    Inventory_t belt;
+    Inventory_t pack;
+    
+    /* chunk the player was in when the chunks around them were last loaded, -1 before that */
+    int cx;
+    int cy;
+    int cz;
+} Player_t;
+
+extern void Player_Init(Player_t* player);
+extern void Player_Shutdown(Player_t* player);
+extern void Player_Pickup(Player_t* player, int itemType, int qty);
+
+/* everything a player controls for one tick */
+typedef struct
+{
+    signed char forward;
+    signed char side;
+    char jumping;
+    char digging;
+    char placing;
+    
+    /* belt slot in hand, -1 leaves it as it is */
+    signed char beltIndex;
+    
+    float pitch;
+    float yaw;
+} PlayerInput_t;
+
+/* eye above the player's feet, tools reach out from here */
+#define PLAYER_EYE_HEIGHT 1.6f
+#define PLAYER_REACH 5.0f
+
+#define LOAD_DIST_MAX 8
+
+/* the entity step runs in at most this many batches */
+#define ENTITY_MAX_PARTS (JOB_MAX_WORKERS * 4)
+
+/* per batch results of the parallel entity step */
+typedef struct
+{
+    EntityCommandBuffer_t commands;
+    float maxSize;
+} EntityPart_t;
+
+typedef struct
+{
+    World_t world;
+    SpatialGrid_t entityGrid;
+    EntityPart_t entityParts[ENTITY_MAX_PARTS];
+    int entityBatchSize;
+    
+    Vec3_t gravity;
+    Vec3_t entityGravity;
+    
+} Sim_t;
+
+/* the job system should already be running */
+extern void Sim_Init(Sim_t* sim);
+
+/* turns and moves a player and collides them with the world */
+extern void Sim_MovePlayer(Sim_t* sim, Player_t* player, const PlayerInput_t* input);
+
+/* loads the chunks within loadDist of a player when they enter a new chunk */
+extern void Sim_LoadAround(Sim_t* sim, Player_t* player, int loadDist);
+
+/* steps every entity once, then gives the entities each player is touching to them */
+extern void Sim_UpdateEntities(Sim_t* sim, Player_t* const* players, int playerCount);
+
+/* spawns an item that a player can pick up, returns its id or -1 if there is no room */
+extern int Sim_SpawnDrop(Sim_t* sim, int type, int itemType, Vec3_t position);
+
+/* digs or places with the selected belt item and returns the block the player is looking at, or NULL */
+extern Block_t* Sim_UseTool(Sim_t* sim, Player_t* player, const PlayerInput_t* input);
+
+#endif
@@ -0,0 +1,327 @@
+
+#include "snapshot.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+/* bits of an update's flags byte */
+enum
+{
+    SNAP_UPDATE_X = 1 << 0,
+    SNAP_UPDATE_Y = 1 << 1,
+    SNAP_UPDATE_Z = 1 << 2,
+    SNAP_UPDATE_VELOCITY = 1 << 3,
+    
+    /* moved too far for a small delta, the whole position follows */
+    SNAP_UPDATE_TELEPORT = 1 << 4,
+};
+
+static inline int16_t _Snapshot_ClampI16(float value)
+{
+    if (value > 32767.0f) return 32767;
+    if (value < -32768.0f) return -32768;
+    return (int16_t)lrintf(value);
+}
+
+void Snapshot_Quantize(SnapEntity_t* entity, const EntityStore_t* store, int slot)
+{
+    int id = store->id[slot];
+    
+    entity->id = (uint16_t)id;
+    entity->generation = store->generation[id];
+    entity->type = (uint8_t)store->type[slot];
+    
+    entity->position[0] = (int32_t)lrintf(store->x[slot] * SNAPSHOT_POSITION_SCALE);
+    entity->position[1] = (int32_t)lrintf(store->y[slot] * SNAPSHOT_POSITION_SCALE);
+    entity->position[2] = (int32_t)lrintf(store->z[slot] * SNAPSHOT_POSITION_SCALE);
+    
+    entity->velocity[0] = _Snapshot_ClampI16(store->vx[slot] * SNAPSHOT_VELOCITY_SCALE);
+    entity->velocity[1] = _Snapshot_ClampI16(store->vy[slot] * SNAPSHOT_VELOCITY_SCALE);
+    entity->velocity[2] = _Snapshot_ClampI16(store->vz[slot] * SNAPSHOT_VELOCITY_SCALE);
+}
+
+static int _Snapshot_CompareIds(const void* a, const void* b)
+{
+    const SnapEntity_t* entityA = a;
+    const SnapEntity_t* entityB = b;
+    return (int)entityA->id - (int)entityB->id;
+}
+
+void Snapshot_Sort(Snapshot_t* snapshot)
+{
+    qsort(snapshot->entities, snapshot->count, sizeof(SnapEntity_t), _Snapshot_CompareIds);
+}
+
+void SnapshotHistory_Init(SnapshotHistory_t* history)
+{
+    int i;
+    for (i = 0; i < SNAPSHOT_HISTORY; ++i)
+    {
+        history->snapshots[i].seq = 0;
+        history->snapshots[i].count = 0;
+    }
+}
+
+static void _Snapshot_WriteEnter(NetWriter_t* writer, const SnapEntity_t* entity)
+{
+    NetWriter_U16(writer, entity->id);
+    NetWriter_U8(writer, entity->generation);
+    NetWriter_U8(writer, entity->type);
+    
+    int i;
+    for (i = 0; i < 3; ++i) NetWriter_U32(writer, (uint32_t)entity->position[i]);
+    for (i = 0; i < 3; ++i) NetWriter_U16(writer, (uint16_t)entity->velocity[i]);
+}
+
+static void _Snapshot_WriteUpdate(NetWriter_t* writer, const SnapEntity_t* entity, const SnapEntity_t* base)
+{
+    int32_t delta[3];
+    int flags = 0;
+    int far = 0;
+    
+    int i;
+    for (i = 0; i < 3; ++i)
+    {
+        delta[i] = entity->position[i] - base->position[i];
+        
+        if (delta[i] != 0) flags |= SNAP_UPDATE_X << i;
+        if (delta[i] < -32768 || delta[i] > 32767) far = 1;
+    }
+    
+    if (far) flags = SNAP_UPDATE_TELEPORT;
+    
+    if (memcmp(entity->velocity, base->velocity, sizeof(entity->velocity)) != 0) flags |= SNAP_UPDATE_VELOCITY;
+    
+    NetWriter_U16(writer, entity->id);
+    NetWriter_U8(writer, (uint8_t)flags);
+    
+    if (flags & SNAP_UPDATE_TELEPORT)
+    {
+        for (i = 0; i < 3; ++i) NetWriter_U32(writer, (uint32_t)entity->position[i]);
+    }
+    else
+    {
+        for (i = 0; i < 3; ++i)
+        {
+            if (flags & (SNAP_UPDATE_X << i)) NetWriter_U16(writer, (uint16_t)(int16_t)delta[i]);
+        }
+    }
+    
+    if (flags & SNAP_UPDATE_VELOCITY)
+    {
+        for (i = 0; i < 3; ++i) NetWriter_U16(writer, (uint16_t)entity->velocity[i]);
+    }
+}
+
+void Snapshot_Write(NetWriter_t* writer, const Snapshot_t* snapshot, const Snapshot_t* baseline, SnapshotEvents_t* events)
+{
+    /* indices of what left into the baseline, and of what entered or changed into the snapshot */
+    int left[SNAPSHOT_MAX_ENTITIES];
+    int entered[SNAPSHOT_MAX_ENTITIES];
+    int updated[SNAPSHOT_MAX_ENTITIES];
+    int leftCount = 0;
+    int enteredCount = 0;
+    int updatedCount = 0;
+    
+    int baseCount = baseline ? baseline->count : 0;
+    
+    /* both are sorted by id so one pass pairs them up */
+    int i = 0;
+    int j = 0;
+    
+    while (i < snapshot->count || j < baseCount)
+    {
+        const SnapEntity_t* entity = i < snapshot->count ? snapshot->entities + i : NULL;
+        const SnapEntity_t* base = j < baseCount ? baseline->entities + j : NULL;
+        
+        if (!entity || (base && base->id < entity->id))
+        {
+            left[leftCount++] = j++;
+        }
+        else if (!base || entity->id < base->id)
+        {
+            entered[enteredCount++] = i++;
+        }
+        else
+        {
+            /* the id was handed to a new entity */
+            if (entity->generation != base->generation || entity->type != base->type)
+            {
+                left[leftCount++] = j;
+                entered[enteredCount++] = i;
+            }
+            else if (memcmp(entity->position, base->position, sizeof(entity->position)) != 0 ||
+                     memcmp(entity->velocity, base->velocity, sizeof(entity->velocity)) != 0)
+            {
+                updated[updatedCount++] = i;
+            }
+            
+            ++i;
+            ++j;
+        }
+    }
+    
+    NetWriter_U8(writer, NET_MSG_ENTITIES);
+    NetWriter_U32(writer, snapshot->seq);
+    NetWriter_U32(writer, baseline ? baseline->seq : 0);
+    NetWriter_U8(writer, (uint8_t)leftCount);
+    NetWriter_U8(writer, (uint8_t)enteredCount);
+    NetWriter_U8(writer, (uint8_t)updatedCount);
+    
+    for (i = 0; i < leftCount; ++i) NetWriter_U16(writer, baseline->entities[left[i]].id);
+    for (i = 0; i < enteredCount; ++i) _Snapshot_WriteEnter(writer, snapshot->entities + entered[i]);
+    
+    /* updates are paired with their baseline entity again, both are in id order */
+    j = 0;
+    for (i = 0; i < updatedCount; ++i)
+    {
+        const SnapEntity_t* entity = snapshot->entities + updated[i];
+        
+        while (baseline->entities[j].id != entity->id) ++j;
+        _Snapshot_WriteUpdate(writer, entity, baseline->entities + j);
+    }
+    
+    if (events)
+    {
+        events->entered = enteredCount;
+        events->left = leftCount;
+        events->updated = updatedCount;
+    }
+}
+
+static void _Snapshot_ReadEnter(NetReader_t* reader, SnapEntity_t* entity)
+{
+    entity->id = NetReader_U16(reader);
+    entity->generation = NetReader_U8(reader);
+    entity->type = NetReader_U8(reader);
+    
+    int i;
+    for (i = 0; i < 3; ++i) entity->position[i] = (int32_t)NetReader_U32(reader);
+    for (i = 0; i < 3; ++i) entity->velocity[i] = (int16_t)NetReader_U16(reader);
+}
+
+static void _Snapshot_ReadUpdate(NetReader_t* reader, SnapEntity_t* entity)
+{
+    int flags = NetReader_U8(reader);
+    
+    int i;
+    if (flags & SNAP_UPDATE_TELEPORT)
+    {
+        for (i = 0; i < 3; ++i) entity->position[i] = (int32_t)NetReader_U32(reader);
+    }
+    else
+    {
+        for (i = 0; i < 3; ++i)
+        {
+            if (flags & (SNAP_UPDATE_X << i)) entity->position[i] += (int16_t)NetReader_U16(reader);
+        }
+    }
+    
+    if (flags & SNAP_UPDATE_VELOCITY)
+    {
+        for (i = 0; i < 3; ++i) entity->velocity[i] = (int16_t)NetReader_U16(reader);
+    }
+}
+
+const Snapshot_t* Snapshot_Read(NetReader_t* reader, SnapshotHistory_t* history, SnapshotEvents_t* events)
+{
+    uint32_t seq = NetReader_U32(reader);
+    uint32_t baseSeq = NetReader_U32(reader);
+    int leftCount = NetReader_U8(reader);
+    int enteredCount = NetReader_U8(reader);
+    int updatedCount = NetReader_U8(reader);
+    
+    if (reader->overflow || seq == 0) return NULL;
+    
+    /* arrived after something newer took its slot */
+    if (SnapshotHistory_Slot(history, seq)->seq >= seq) return NULL;
+    
+    const Snapshot_t* baseline = NULL;
+    
+    if (baseSeq != 0)
+    {
+        if (seq - baseSeq >= SNAPSHOT_HISTORY) return NULL;
+        
+        baseline = SnapshotHistory_Find(history, baseSeq);
+        if (!baseline) return NULL;
+    }
+    
+    int baseCount = baseline ? baseline->count : 0;
+    
+    if (leftCount > baseCount || enteredCount > SNAPSHOT_MAX_ENTITIES || updatedCount > baseCount) return NULL;
+    
+    /* the baseline without what left */
+    SnapEntity_t kept[SNAPSHOT_MAX_ENTITIES];
+    int keptCount = 0;
+    
+    int i;
+    int j = 0;
+    for (i = 0; i < leftCount; ++i)
+    {
+        int id = NetReader_U16(reader);
+        
+        while (j < baseCount && baseline->entities[j].id < id) kept[keptCount++] = baseline->entities[j++];
+        
+        if (j == baseCount || baseline->entities[j].id != id) return NULL;
+        ++j;
+    }
+    
+    while (j < baseCount) kept[keptCount++] = baseline->entities[j++];
+    
+    SnapEntity_t entered[SNAPSHOT_MAX_ENTITIES];
+    for (i = 0; i < enteredCount; ++i)
+    {
+        _Snapshot_ReadEnter(reader, entered + i);
+        if (i > 0 && entered[i].id <= entered[i - 1].id) return NULL;
+    }
+    
+    j = 0;
+    for (i = 0; i < updatedCount; ++i)
+    {
+        int id = NetReader_U16(reader);
+        
+        while (j < keptCount && kept[j].id < id) ++j;
+        if (j == keptCount || kept[j].id != id) return NULL;
+        
+        _Snapshot_ReadUpdate(reader, kept + j);
+    }
+    
+    if (reader->overflow || keptCount + enteredCount > SNAPSHOT_MAX_ENTITIES) return NULL;
+    
+    Snapshot_t* snapshot = SnapshotHistory_Slot(history, seq);
+    
+    /* merge what stayed with what entered, keeping id order */
+    int count = 0;
+    i = 0;
+    j = 0;
+    while (i < keptCount || j < enteredCount)
+    {
+        if (j == enteredCount || (i < keptCount && kept[i].id < entered[j].id))
+        {
+            snapshot->entities[count++] = kept[i++];
+        }
+        else if (i == keptCount || entered[j].id < kept[i].id)
+        {
+            snapshot->entities[count++] = entered[j++];
+        }
+        else
+        {
+            /* an id can't be in both */
+            snapshot->seq = 0;
+            snapshot->count = 0;
+            return NULL;
+        }
+    }
+    
+    snapshot->count = count;
+    snapshot->seq = seq;
+    
+    if (events)
+    {
+        events->entered = enteredCount;
+        events->left = leftCount;
+        events->updated = updatedCount;
+    }
+    
+    return snapshot;
+}
@@ -0,0 +1,89 @@
+
+#ifndef ccraft_snapshot_h
+#define ccraft_snapshot_h
+
+#include "entity.h"
+#include "net.h"
+
+/* the entities one client can see at one tick, quantized for sending.
+ a snapshot is sent as the difference from an older one the client acknowledged:
+ entities that left, entities that entered, and fields that changed for the rest.
+ a client that has acknowledged nothing still held by the server gets everything as entering */
+
+/* positions in 1/32 of a block, velocities in 1/1024 of a block per tick */
+#define SNAPSHOT_POSITION_SCALE 32.0f
+#define SNAPSHOT_VELOCITY_SCALE 1024.0f
+
+/* NET_MSG_ENTITIES is u32 seq, u32 baseline seq or 0, u8 counts of entities that left, entered and
+ changed, then u16 ids of those that left, the entering entities in full, and the changed fields */
+#define SNAPSHOT_HEADER_SIZE (1 + 4 + 4 + 3)
+#define SNAPSHOT_LEAVE_SIZE 2
+#define SNAPSHOT_ENTER_SIZE (2 + 1 + 1 + 12 + 6)
+
+/* few enough that all of them leaving and as many entering still fits one datagram */
+#define SNAPSHOT_MAX_ENTITIES 40
+
+/* snapshots kept on both ends to delta against */
+#define SNAPSHOT_HISTORY 32
+
+typedef struct
+{
+    uint16_t id;
+    uint8_t generation;
+    uint8_t type;
+    
+    int32_t position[3];
+    int16_t velocity[3];
+} SnapEntity_t;
+
+typedef struct
+{
+    /* 0 for a slot that doesn't hold a snapshot */
+    uint32_t seq;
+    
+    /* sorted by id */
+    SnapEntity_t entities[SNAPSHOT_MAX_ENTITIES];
+    int count;
+} Snapshot_t;
+
+typedef struct
+{
+    Snapshot_t snapshots[SNAPSHOT_HISTORY];
+} SnapshotHistory_t;
+
+/* what changed between two snapshots */
+typedef struct
+{
+    int entered;
+    int left;
+    int updated;
+} SnapshotEvents_t;
+
+extern void Snapshot_Quantize(SnapEntity_t* entity, const EntityStore_t* store, int slot);
+
+/* sorts a snapshot's entities by id once they're gathered */
+extern void Snapshot_Sort(Snapshot_t* snapshot);
+
+/* writes a NET_MSG_ENTITIES with snapshot as a delta from baseline, or in full if baseline is NULL */
+extern void Snapshot_Write(NetWriter_t* writer, const Snapshot_t* snapshot, const Snapshot_t* baseline, SnapshotEvents_t* events);
+
+/* reads the rest of a NET_MSG_ENTITIES after the type into the history.
+ returns the snapshot, or NULL if it's corrupt, old, or its baseline isn't held anymore */
+extern const Snapshot_t* Snapshot_Read(NetReader_t* reader, SnapshotHistory_t* history, SnapshotEvents_t* events);
+
+extern void SnapshotHistory_Init(SnapshotHistory_t* history);
+
+/* the slot for a sequence number, whatever it holds */
+static inline Snapshot_t* SnapshotHistory_Slot(SnapshotHistory_t* history, uint32_t seq)
+{
+    return history->snapshots + seq % SNAPSHOT_HISTORY;
+}
+
+/* the snapshot with a sequence number or NULL if it has been replaced */
+static inline const Snapshot_t* SnapshotHistory_Find(SnapshotHistory_t* history, uint32_t seq)
+{
+    const Snapshot_t* snapshot = SnapshotHistory_Slot(history, seq);
+    return (seq != 0 && snapshot->seq == seq) ? snapshot : NULL;
+}
+
+#endif
@@ -0,0 +1,185 @@
+
+/* compares two digests written by ccraft -replay ... -digest, and prints the first chunk,
+ entity and player that differ between them along with how many of each do */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+enum
+{
+    LEAF_CHUNK = 0,
+    LEAF_ENTITY,
+    LEAF_PLAYER,
+    LEAF_KINDS,
+};
+
+static const char* _kindNames[LEAF_KINDS] = { "chunk", "entity", "player" };
+
+typedef struct
+{
+    int kind;
+    
+    /* chunk coordinates, entity id, or player index */
+    int key[3];
+    
+    unsigned long long hash;
+    char line[256];
+} Leaf_t;
+
+typedef struct
+{
+    unsigned long long root;
+    Leaf_t* leaves;
+    int count;
+} Digest_t;
+
+static int _Load(Digest_t* digest, const char* path)
+{
+    FILE* file = fopen(path, "r");
+    if (!file) return 0;
+    
+    digest->root = 0;
+    digest->leaves = NULL;
+    digest->count = 0;
+    
+    int capacity = 0;
+    char line[256];
+    
+    while (fgets(line, sizeof(line), file))
+    {
+        line[strcspn(line, "\n")] = '\0';
+        
+        if (sscanf(line, "root %llx", &digest->root) == 1) continue;
+        
+        if (digest->count == capacity)
+        {
+            capacity = capacity ? capacity * 2 : 1024;
+            digest->leaves = realloc(digest->leaves, sizeof(Leaf_t) * capacity);
+        }
+        
+        Leaf_t* leaf = digest->leaves + digest->count;
+        memset(leaf->key, 0, sizeof(leaf->key));
+        strcpy(leaf->line, line);
+        
+        /* the hash is always last */
+        const char* hash = strrchr(line, ' ');
+        if (!hash || sscanf(hash, " %llx", &leaf->hash) != 1) continue;
+        
+        if (sscanf(line, "chunk %i %i %i", leaf->key, leaf->key + 1, leaf->key + 2) == 3)
+        {
+            leaf->kind = LEAF_CHUNK;
+        }
+        else if (sscanf(line, "entity %i", leaf->key) == 1)
+        {
+            leaf->kind = LEAF_ENTITY;
+        }
+        else if (sscanf(line, "player %i", leaf->key) == 1)
+        {
+            leaf->kind = LEAF_PLAYER;
+        }
+        else
+        {
+            continue;
+        }
+        
+        digest->count++;
+    }
+    
+    fclose(file);
+    return 1;
+}
+
+/* leaves are written by kind, then in key order */
+static int _Compare(const Leaf_t* a, const Leaf_t* b)
+{
+    if (a->kind != b->kind) return a->kind < b->kind ? -1 : 1;
+    
+    int i;
+    for (i = 0; i < 3; ++i)
+    {
+        if (a->key[i] != b->key[i]) return a->key[i] < b->key[i] ? -1 : 1;
+    }
+    
+    return 0;
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc != 3)
+    {
+        fprintf(stderr, "usage: %s a.digest b.digest\n", argv[0]);
+        return 1;
+    }
+    
+    Digest_t a;
+    Digest_t b;
+    
+    if (!_Load(&a, argv[1]))
+    {
+        fprintf(stderr, "can't read %s\n", argv[1]);
+        return 1;
+    }
+    
+    if (!_Load(&b, argv[2]))
+    {
+        fprintf(stderr, "can't read %s\n", argv[2]);
+        return 1;
+    }
+    
+    if (a.root == b.root)
+    {
+        printf("same, root %016llx\n", a.root);
+        return 0;
+    }
+    
+    int differing[LEAF_KINDS] = { 0 };
+    int i = 0;
+    int j = 0;
+    
+    while (i < a.count || j < b.count)
+    {
+        const Leaf_t* leafA = i < a.count ? a.leaves + i : NULL;
+        const Leaf_t* leafB = j < b.count ? b.leaves + j : NULL;
+        
+        int order = !leafA ? 1 : (!leafB ? -1 : _Compare(leafA, leafB));
+        
+        int kind;
+        if (order < 0)
+        {
+            kind = leafA->kind;
+            if (differing[kind] == 0) printf("first %s only in %s:\n  %s\n", _kindNames[kind], argv[1], leafA->line);
+            ++i;
+        }
+        else if (order > 0)
+        {
+            kind = leafB->kind;
+            if (differing[kind] == 0) printf("first %s only in %s:\n  %s\n", _kindNames[kind], argv[2], leafB->line);
+            ++j;
+        }
+        else
+        {
+            kind = leafA->kind;
+            ++i;
+            ++j;
+            
+            if (leafA->hash == leafB->hash) continue;
+            
+            if (differing[kind] == 0) printf("first %s that differs:\n  %s\n  %s\n", _kindNames[kind], leafA->line, leafB->line);
+        }
+        
+        differing[kind]++;
+    }
+    
+    printf("roots %016llx and %016llx, %i chunks, %i entities and %i players differ\n",
+           a.root,
+           b.root,
+           differing[LEAF_CHUNK],
+           differing[LEAF_ENTITY],
+           differing[LEAF_PLAYER]);
+    
+    free(a.leaves);
+    free(b.leaves);
+    
+    return 2;
+}
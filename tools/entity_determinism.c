@@ -0,0 +1,144 @@
+/* runs the parallel entity step on the same world with 1 worker and with more,
+ checks that positions, velocities and ids come out byte identical and prints the time per tick.
+ usage: entity_determinism [entities] [ticks] [workers...] */
+
+#include "../sim.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define RUN_LOAD_DIST 4
+
+typedef struct
+{
+    int count;
+    
+    /* x y z vx vy vz of every slot, then ids */
+    float* state;
+    int* ids;
+    
+    int workers;
+    double msPerTick;
+} Run_t;
+
+static double _Now(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1000.0 + t.tv_nsec / 1000000.0;
+}
+
+static float _Random(unsigned int* seed, float range)
+{
+    *seed = *seed * 1103515245u + 12345u;
+    return ((*seed >> 8) & 0xffff) / 65536.0f * range;
+}
+
+static void _Run(Run_t* run, int workers, int entities, int ticks)
+{
+    Job_Init(workers);
+    
+    /* sims are never torn down in the game, so each run gets a fresh one and leaks it */
+    Sim_t* sim = calloc(1, sizeof(Sim_t));
+    Sim_Init(sim);
+    
+    /* the game caps entities well below what's worth threading, so grow everything the step touches */
+    EntityStore_Shutdown(&sim->world.entities);
+    EntityStore_Init(&sim->world.entities, entities);
+    SpatialGrid_Shutdown(&sim->entityGrid);
+    SpatialGrid_Init(&sim->entityGrid, entities, 1.0f);
+    
+    int i;
+    for (i = 0; i < ENTITY_MAX_PARTS; ++i)
+    {
+        EntityCommandBuffer_Shutdown(&sim->entityParts[i].commands);
+        EntityCommandBuffer_Init(&sim->entityParts[i].commands, entities);
+    }
+    
+    Player_t player;
+    Player_Init(&player);
+    player.position = Vec3_Create(RUN_LOAD_DIST * CHUNK_SIZE, RUN_LOAD_DIST * CHUNK_SIZE, CHUNK_SIZE);
+    Sim_LoadAround(sim, &player, RUN_LOAD_DIST);
+    
+    /* drops over the loaded area and past its edges, so some land and some fall out of the world */
+    float side = RUN_LOAD_DIST * 2 * CHUNK_SIZE;
+    unsigned int seed = 1;
+    
+    for (i = 0; i < entities; ++i)
+    {
+        Vec3_t position = Vec3_Create(_Random(&seed, side * 1.25f) - side * 0.125f,
+                                      _Random(&seed, side * 1.25f) - side * 0.125f,
+                                      _Random(&seed, CHUNK_SIZE * 2.0f));
+        
+        if (Sim_SpawnDrop(sim, ENTITY_STONE, ITEM_STONE, position) == -1) break;
+    }
+    
+    Player_t* players[1] = { &player };
+    
+    double start = _Now();
+    for (i = 0; i < ticks; ++i)
+    {
+        Sim_UpdateEntities(sim, players, 1);
+    }
+    run->msPerTick = (_Now() - start) / ticks;
+    
+    const EntityStore_t* store = &sim->world.entities;
+    
+    run->count = store->count;
+    run->state = malloc(sizeof(float) * 6 * store->count);
+    run->ids = malloc(sizeof(int) * store->count);
+    
+    memcpy(run->state + store->count * 0, store->x, sizeof(float) * store->count);
+    memcpy(run->state + store->count * 1, store->y, sizeof(float) * store->count);
+    memcpy(run->state + store->count * 2, store->z, sizeof(float) * store->count);
+    memcpy(run->state + store->count * 3, store->vx, sizeof(float) * store->count);
+    memcpy(run->state + store->count * 4, store->vy, sizeof(float) * store->count);
+    memcpy(run->state + store->count * 5, store->vz, sizeof(float) * store->count);
+    memcpy(run->ids, store->id, sizeof(int) * store->count);
+    
+    run->workers = Job_WorkerCount();
+    Job_Shutdown();
+}
+
+int main(int argc, const char* argv[])
+{
+    int entities = argc > 1 ? atoi(argv[1]) : 100000;
+    int ticks = argc > 2 ? atoi(argv[2]) : 300;
+    
+    Run_t serial;
+    _Run(&serial, 1, entities, ticks);
+    printf(" 1 worker:  %.2f ms per tick, %d of %d entities left\n", serial.msPerTick, serial.count, entities);
+    
+    /* with no counts given, compare against one worker per core */
+    int first = 3;
+    int last = argc > 3 ? argc : 4;
+    
+    int failures = 0;
+    
+    int a;
+    for (a = first; a < last; ++a)
+    {
+        int workers = a < argc ? atoi(argv[a]) : 0;
+        
+        Run_t run;
+        _Run(&run, workers, entities, ticks);
+        
+        int same = run.count == serial.count &&
+                   memcmp(run.state, serial.state, sizeof(float) * 6 * run.count) == 0 &&
+                   memcmp(run.ids, serial.ids, sizeof(int) * run.count) == 0;
+        
+        printf("%2d workers: %.2f ms per tick, %.2fx, %s\n",
+               run.workers,
+               run.msPerTick,
+               serial.msPerTick / run.msPerTick,
+               same ? "identical" : "DIFFERENT");
+        
+        failures += !same;
+        
+        free(run.state);
+        free(run.ids);
+    }
+    
+    return failures ? 1 : 0;
+}
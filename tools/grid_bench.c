@@ -0,0 +1,144 @@
+/* times SpatialGrid_t rebuilds and radius queries for 10k to 100k random entities
+ at about one per cubic block, and checks the results against a brute force scan.
+ usage: grid_bench [radius] */
+
+#include "../grid.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+/* above this the full brute force pair count takes too long, only sampled queries are checked */
+#define BENCH_FULL_CHECK 20000
+#define BENCH_SAMPLES 1000
+#define BENCH_MAX_OUT 4096
+
+static unsigned int _seed = 1;
+
+static float _Random(float range)
+{
+    _seed = _seed * 1103515245u + 12345u;
+    return ((_seed >> 8) & 0xffff) / 65536.0f * range;
+}
+
+static double _Now(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1000.0 + t.tv_nsec / 1000000.0;
+}
+
+static int _BruteRadius(const EntityStore_t* store, Vec3_t center, float radiusSq)
+{
+    int found = 0;
+    
+    int i;
+    for (i = 0; i < store->count; ++i)
+    {
+        float dx = store->x[i] - center.x;
+        float dy = store->y[i] - center.y;
+        float dz = store->z[i] - center.z;
+        
+        found += dx * dx + dy * dy + dz * dz <= radiusSq;
+    }
+    
+    return found;
+}
+
+static int _BruteAABB(const EntityStore_t* store, AABB_t bounds)
+{
+    int found = 0;
+    
+    int i;
+    for (i = 0; i < store->count; ++i)
+    {
+        found += AABB_IntersectsPoint(bounds, EntityStore_Position(store, i));
+    }
+    
+    return found;
+}
+
+static int _Bench(int count, float radius)
+{
+    EntityStore_t store;
+    EntityStore_Init(&store, count);
+    
+    SpatialGrid_t grid;
+    SpatialGrid_Init(&grid, count, 1.0f);
+    
+    /* a cube holding roughly one entity per block */
+    float side = cbrtf((float)count);
+    
+    int i;
+    for (i = 0; i < count; ++i)
+    {
+        int slot = EntityStore_Slot(&store, EntityStore_Spawn(&store, ENTITY_STONE));
+        EntityStore_SetPosition(&store, slot, Vec3_Create(_Random(side), _Random(side), _Random(side)));
+    }
+    
+    static int out[BENCH_MAX_OUT];
+    
+    double start = _Now();
+    SpatialGrid_Build(&grid, &store);
+    double built = _Now();
+    
+    long long pairs = 0;
+    for (i = 0; i < count; ++i)
+    {
+        pairs += SpatialGrid_QueryRadius(&grid, &store, EntityStore_Position(&store, i), radius, out, BENCH_MAX_OUT);
+    }
+    double queried = _Now();
+    
+    printf("%6d entities: build %.2f ms, %d radius %.1f queries %.1f ms, %lld pairs",
+           count, built - start, count, radius, queried - built, pairs);
+    
+    int mismatches = 0;
+    
+    if (count <= BENCH_FULL_CHECK)
+    {
+        long long brute = 0;
+        for (i = 0; i < count; ++i)
+        {
+            brute += _BruteRadius(&store, EntityStore_Position(&store, i), radius * radius);
+        }
+        
+        printf(", brute force %.1f ms", _Now() - queried);
+        mismatches += brute != pairs;
+    }
+    
+    /* sampled radius and box queries at random points, not just at entities */
+    for (i = 0; i < BENCH_SAMPLES; ++i)
+    {
+        Vec3_t center = Vec3_Create(_Random(side), _Random(side), _Random(side));
+        Vec3_t extent = Vec3_Create(_Random(4.0f), _Random(4.0f), _Random(4.0f));
+        AABB_t bounds = AABB_Create(Vec3_Sub(center, extent), Vec3_Add(center, extent));
+        
+        mismatches += SpatialGrid_QueryRadius(&grid, &store, center, radius, out, BENCH_MAX_OUT) !=
+                      _BruteRadius(&store, center, radius * radius);
+        mismatches += SpatialGrid_QueryAABB(&grid, &store, bounds, out, BENCH_MAX_OUT) !=
+                      _BruteAABB(&store, bounds);
+    }
+    
+    printf(mismatches ? ", %d MISMATCHES\n" : ", matches brute force\n", mismatches);
+    
+    SpatialGrid_Shutdown(&grid);
+    EntityStore_Shutdown(&store);
+    
+    return mismatches;
+}
+
+int main(int argc, const char* argv[])
+{
+    float radius = argc > 1 ? (float)atof(argv[1]) : 1.5f;
+    
+    static const int counts[] = { 10000, 20000, 50000, 100000 };
+    
+    int mismatches = 0;
+    
+    int i;
+    for (i = 0; i < (int)(sizeof(counts) / sizeof(counts[0])); ++i)
+    {
+        mismatches += _Bench(counts[i], radius);
+    }
+    
+    return mismatches ? 1 : 0;
+}
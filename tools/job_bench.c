@@ -0,0 +1,96 @@
+/* times Job_ParallelFor over a million items in batches of 4096 for each worker count
+ and prints the speedup over a single worker.
+ usage: job_bench [repeats] [workers...], 0 workers is one per core */
+
+#include "../job.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define BENCH_ITEMS 1000000
+#define BENCH_BATCH 4096
+
+static float _in[BENCH_ITEMS];
+static float _out[BENCH_ITEMS];
+
+static double _Now(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1000.0 + t.tv_nsec / 1000000.0;
+}
+
+/* a few dozen flops an item, enough that the batches aren't all overhead */
+static void _Work(void* data, int begin, int end)
+{
+    (void)data;
+    
+    int i;
+    for (i = begin; i < end; ++i)
+    {
+        float x = _in[i];
+        
+        int j;
+        for (j = 0; j < 8; ++j)
+        {
+            x = sqrtf(x * x + 1.0f) * 0.5f;
+        }
+        
+        _out[i] = x;
+    }
+}
+
+/* best of several runs, the first warms up the workers. 0 workers is one per core */
+static double _Time(int* workers, int repeats)
+{
+    Job_Init(*workers);
+    *workers = Job_WorkerCount();
+    Job_ParallelFor(_Work, NULL, BENCH_ITEMS, BENCH_BATCH);
+    
+    double best = 0.0;
+    
+    int i;
+    for (i = 0; i < repeats; ++i)
+    {
+        double start = _Now();
+        Job_ParallelFor(_Work, NULL, BENCH_ITEMS, BENCH_BATCH);
+        double elapsed = _Now() - start;
+        
+        if (i == 0 || elapsed < best) best = elapsed;
+    }
+    
+    Job_Shutdown();
+    
+    return best;
+}
+
+int main(int argc, const char* argv[])
+{
+    int repeats = argc > 1 ? atoi(argv[1]) : 20;
+    
+    int i;
+    for (i = 0; i < BENCH_ITEMS; ++i)
+    {
+        _in[i] = (float)(i % 1000);
+    }
+    
+    static const int defaultCounts[] = { 1, 2, 4, 8, JOB_MAX_WORKERS, 0 };
+    
+    int runs = argc > 2 ? argc - 2 : (int)(sizeof(defaultCounts) / sizeof(defaultCounts[0]));
+    
+    int one = 1;
+    double serial = _Time(&one, repeats);
+    
+    printf("%d items, batches of %d, best of %d\n", BENCH_ITEMS, BENCH_BATCH, repeats);
+    
+    for (i = 0; i < runs; ++i)
+    {
+        int workers = argc > 2 ? atoi(argv[i + 2]) : defaultCounts[i];
+        double ms = workers == 1 ? serial : _Time(&workers, repeats);
+        
+        printf("%2d workers: %7.2f ms, %.2fx\n", workers, ms, serial / ms);
+    }
+    
+    return 0;
+}
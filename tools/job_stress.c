@@ -0,0 +1,168 @@
+/* hammers the job system with random parallel for sums, fan outs under a parent job
+ and nested waits, for every worker count, and checks every result against a serial run.
+ usage: job_stress [rounds] */
+
+#include "../job.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#define STRESS_MAX_ITEMS 100000
+#define STRESS_MAX_FANOUT 512
+
+typedef struct
+{
+    const int* values;
+    atomic_llong sum;
+} Sum_t;
+
+static int _values[STRESS_MAX_ITEMS];
+
+static unsigned int _seed = 1;
+
+static int _Random(int range)
+{
+    _seed = _seed * 1103515245u + 12345u;
+    return (int)((_seed >> 8) % (unsigned int)range);
+}
+
+static void _Sum(void* data, int begin, int end)
+{
+    Sum_t* sum = data;
+    
+    long long local = 0;
+    
+    int i;
+    for (i = begin; i < end; ++i) local += sum->values[i];
+    
+    atomic_fetch_add_explicit(&sum->sum, local, memory_order_relaxed);
+}
+
+static void _Nothing(void* data, int begin, int end)
+{
+    (void)data;
+    (void)begin;
+    (void)end;
+}
+
+static long long _Serial(int begin, int end)
+{
+    long long sum = 0;
+    
+    int i;
+    for (i = begin; i < end; ++i) sum += _values[i];
+    
+    return sum;
+}
+
+static int _ParallelSum(void)
+{
+    int count = 1 + _Random(STRESS_MAX_ITEMS);
+    int batchSize = 1 + _Random(2048);
+    
+    Sum_t sum = { _values, 0 };
+    Job_ParallelFor(_Sum, &sum, count, batchSize);
+    
+    return atomic_load(&sum.sum) == _Serial(0, count);
+}
+
+static int _FanOut(void)
+{
+    int fanOut = 1 + _Random(STRESS_MAX_FANOUT);
+    int width = 1 + _Random(STRESS_MAX_ITEMS / STRESS_MAX_FANOUT);
+    
+    Sum_t sum = { _values, 0 };
+    
+    /* the root has no items of its own, it only finishes once every child has */
+    Job_t* root = Job_Create(_Nothing, NULL, 0, 0, NULL);
+    
+    int i;
+    for (i = 0; i < fanOut; ++i)
+    {
+        Job_Run(Job_Create(_Sum, &sum, i * width, (i + 1) * width, root));
+    }
+    Job_Run(root);
+    Job_Wait(root);
+    
+    return atomic_load(&sum.sum) == _Serial(0, fanOut * width);
+}
+
+typedef struct
+{
+    int width;
+    atomic_int failures;
+} Nested_t;
+
+/* every item runs its own parallel for and waits on it from inside a job */
+static void _Nested(void* data, int begin, int end)
+{
+    Nested_t* nested = data;
+    
+    int i;
+    for (i = begin; i < end; ++i)
+    {
+        int first = i * nested->width;
+        
+        Sum_t sum = { _values + first, 0 };
+        Job_ParallelFor(_Sum, &sum, nested->width, 1 + (i % 16) * 8);
+        
+        if (atomic_load(&sum.sum) != _Serial(first, first + nested->width))
+        {
+            atomic_fetch_add(&nested->failures, 1);
+        }
+    }
+}
+
+static int _NestedWaits(void)
+{
+    int count = 1 + _Random(64);
+    
+    Nested_t nested;
+    nested.width = 1 + _Random(STRESS_MAX_ITEMS / 64);
+    atomic_init(&nested.failures, 0);
+    
+    Job_ParallelFor(_Nested, &nested, count, 1 + _Random(4));
+    
+    return atomic_load(&nested.failures) == 0;
+}
+
+int main(int argc, const char* argv[])
+{
+    int rounds = argc > 1 ? atoi(argv[1]) : 2000;
+    
+    int i;
+    for (i = 0; i < STRESS_MAX_ITEMS; ++i)
+    {
+        _values[i] = _Random(2000001) - 1000000;
+    }
+    
+    static const int workerCounts[] = { 1, 2, 3, 4, 8, JOB_MAX_WORKERS };
+    
+    int failures = 0;
+    
+    int w;
+    for (w = 0; w < (int)(sizeof(workerCounts) / sizeof(workerCounts[0])); ++w)
+    {
+        Job_Init(workerCounts[w]);
+        
+        int sums = 0, fanOuts = 0, nesteds = 0;
+        
+        int round;
+        for (round = 0; round < rounds; ++round)
+        {
+            sums += !_ParallelSum();
+            fanOuts += !_FanOut();
+            nesteds += !_NestedWaits();
+        }
+        
+        Job_Shutdown();
+        
+        printf("%2d workers: %d rounds, %d sum, %d fan out, %d nested failures\n",
+               workerCounts[w], rounds, sums, fanOuts, nesteds);
+        
+        failures += sums + fanOuts + nesteds;
+    }
+    
+    printf(failures ? "FAILED\n" : "ok\n");
+    
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,159 @@
+/* puts a 5 by 3 wall of solid chunks in front of the camera with one more chunk hidden behind it,
+ runs the depth cull face on and from a few angles and checks the wall stays drawn and the chunk behind doesn't.
+ usage: occlusion_check */
+
+#include "../occlusion.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#define CHECK_WALL_WIDTH 5
+#define CHECK_WALL_HEIGHT 3
+#define CHECK_WALL_COUNT (CHECK_WALL_WIDTH * CHECK_WALL_HEIGHT)
+
+/* a little off the middle of a chunk, so no pixel center lands exactly on an occluder edge */
+#define CHECK_EYE Vec3_Create(CHUNK_SIZE / 2 + 0.3f, 0.0f, CHUNK_SIZE / 2 - 0.2f)
+
+typedef struct
+{
+    const char* name;
+    Vec3_t direction;
+} View_t;
+
+static World_t _world;
+static int _visible[CHECK_WALL_COUNT + 1];
+static OcclusionBuffer_t _empty;
+
+static void _SolidChunk(Chunk_t* chunk, int x, int y, int z)
+{
+    chunk->x = x;
+    chunk->y = y;
+    chunk->z = z;
+    
+    Block_t* blocks = &chunk->blocks[0][0][0];
+    
+    int i;
+    for (i = 0; i < CHUNK_VOLUME; ++i)
+    {
+        blocks[i].type = BLOCK_STONE;
+    }
+    
+    chunk->worldPosition = Vec3_Create(x * CHUNK_SIZE, y * CHUNK_SIZE, z * CHUNK_SIZE);
+    Vec3_t center = Vec3_Add(chunk->worldPosition, Vec3_Create(CHUNK_SIZE / 2, CHUNK_SIZE / 2, CHUNK_SIZE / 2));
+    chunk->boundingSphere = Sphere_Create(center, CHUNK_SIZE);
+    
+    Chunk_BlocksChanged(chunk);
+    Occlusion_FindSolidLayers(chunk);
+}
+
+static AABB_t _ChunkBounds(const Chunk_t* chunk)
+{
+    return AABB_Create(chunk->worldPosition, Vec3_Add(chunk->worldPosition, Vec3_Create(CHUNK_SIZE, CHUNK_SIZE, CHUNK_SIZE)));
+}
+
+/* depth culls every chunk that lands on screen, an empty buffer only culls the ones off it.
+ returns how many wall chunks with their front face on screen were culled and counts them in *inView */
+static int _Cull(const View_t* view, int* inView, int* hiddenCulled)
+{
+    Cam_t cam;
+    Cam_Init(&cam);
+    cam.position = CHECK_EYE;
+    cam.target = Vec3_Add(CHECK_EYE, view->direction);
+    Cam_UpdateTransform(&cam, 800, 600);
+    
+    Mat4_t mvp;
+    Mat4_Mult(Cam_ProjectionMat(&cam), Cam_ViewMat(&cam), &mvp);
+    Occlusion_Clear(&_empty, &mvp, cam.near);
+    
+    _world.visibleChunks = _visible;
+    _world.visibleCount = 0;
+    
+    /* a wall chunk whose front face is on screen can be seen, the rest of it may rightly be hidden by its neighbours */
+    int faceOnScreen[CHECK_WALL_COUNT];
+    *inView = 0;
+    
+    int i;
+    for (i = 0; i < _world.chunkCount; ++i)
+    {
+        const Chunk_t* chunk = _world.chunks + i;
+        AABB_t bounds = _ChunkBounds(chunk);
+        
+        if (Occlusion_BoxVisible(&_empty, bounds, -1)) _visible[_world.visibleCount++] = i;
+        
+        if (i < CHECK_WALL_COUNT)
+        {
+            bounds.max.y = bounds.min.y;
+            faceOnScreen[i] = Occlusion_BoxVisible(&_empty, bounds, -1);
+            *inView += faceOnScreen[i];
+        }
+    }
+    
+    _world.cullStats.drawn = _world.visibleCount;
+    _world.cullStats.depthCulled = 0;
+    
+    Occlusion_CullChunks(&_world, &cam);
+    
+    *hiddenCulled = 1;
+    
+    int wallDrawn = 0;
+    for (i = 0; i < _world.visibleCount; ++i)
+    {
+        int index = _world.visibleChunks[i];
+        
+        if (index == CHECK_WALL_COUNT)
+        {
+            *hiddenCulled = 0;
+        }
+        else
+        {
+            wallDrawn += faceOnScreen[index];
+        }
+    }
+    
+    return *inView - wallDrawn;
+}
+
+int main(int argc, const char* argv[])
+{
+    (void)argc;
+    (void)argv;
+    
+    _world.chunks = calloc(CHECK_WALL_COUNT + 1, sizeof(Chunk_t));
+    
+    /* the wall's front faces are a chunk ahead of the camera, the hidden chunk is two chunks behind them */
+    int x, z;
+    for (x = 0; x < CHECK_WALL_WIDTH; ++x)
+    {
+        for (z = 0; z < CHECK_WALL_HEIGHT; ++z)
+        {
+            _SolidChunk(_world.chunks + _world.chunkCount++, x - CHECK_WALL_WIDTH / 2, 1, z - CHECK_WALL_HEIGHT / 2);
+        }
+    }
+    
+    _SolidChunk(_world.chunks + _world.chunkCount++, 0, 3, 0);
+    
+    const View_t views[] = {
+        { "face on", Vec3_Create(0.0f, 1.0f, 0.0f) },
+        { "turned", Vec3_Create(0.4f, 1.0f, 0.0f) },
+        { "looking down", Vec3_Create(0.0f, 1.0f, -0.3f) },
+        { "turned down", Vec3_Create(-0.3f, 1.0f, -0.2f) },
+    };
+    
+    int failures = 0;
+    
+    int i;
+    for (i = 0; i < (int)(sizeof(views) / sizeof(views[0])); ++i)
+    {
+        int inView, hiddenCulled;
+        int wallCulled = _Cull(views + i, &inView, &hiddenCulled);
+        
+        printf("%-12s %2d of %2d wall chunks facing the camera culled, chunk behind %s\n",
+               views[i].name, wallCulled, inView, hiddenCulled ? "culled" : "drawn");
+        
+        failures += wallCulled > 0;
+        failures += !hiddenCulled;
+    }
+    
+    printf(failures ? "FAILED\n" : "ok\n");
+    
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,201 @@
+/* times initial lighting for a block of generated chunks and the relight after single block edits:
+ digging a shaft, capping it, placing and removing an emitter and editing on a chunk corner.
+ edits that are undone must leave the light exactly as it was.
+ usage: relight_bench [chunks per side] */
+
+#include "../light.h"
+#include "../job.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define BENCH_SHAFT_DEPTH 8
+
+typedef struct
+{
+    const char* name;
+    int edits;
+    double total;
+    double worst;
+} Case_t;
+
+static World_t _world;
+
+static double _Now(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1000000.0 + t.tv_nsec / 1000.0;
+}
+
+/* highest opaque block in the column, or -1 */
+static int _Surface(int x, int y)
+{
+    int z;
+    for (z = CHUNK_SIZE - 1; z >= 0; --z)
+    {
+        Block_t* block = World_GetBlockAt(&_world, x, y, z);
+        if (block && Block_Opaque(block->type)) return z;
+    }
+    
+    return -1;
+}
+
+static void _Edit(Case_t* c, int x, int y, int z, int type)
+{
+    Block_t* block = World_GetBlockAt(&_world, x, y, z);
+    if (!block) return;
+    
+    block->type = type;
+    
+    double start = _Now();
+    Light_UpdateBlock(&_world, x, y, z);
+    double elapsed = _Now() - start;
+    
+    ++c->edits;
+    c->total += elapsed;
+    if (elapsed > c->worst) c->worst = elapsed;
+}
+
+static unsigned char* _SaveLight(void)
+{
+    size_t size = sizeof(_world.chunks[0].light);
+    unsigned char* saved = malloc(size * _world.chunkCount);
+    
+    int i;
+    for (i = 0; i < _world.chunkCount; ++i)
+    {
+        memcpy(saved + size * i, _world.chunks[i].light, size);
+    }
+    
+    return saved;
+}
+
+static int _SameLight(unsigned char* saved)
+{
+    size_t size = sizeof(_world.chunks[0].light);
+    int same = 1;
+    
+    int i;
+    for (i = 0; i < _world.chunkCount; ++i)
+    {
+        same &= memcmp(saved + size * i, _world.chunks[i].light, size) == 0;
+    }
+    
+    free(saved);
+    return same;
+}
+
+static void _Print(const Case_t* c)
+{
+    printf("%-10s %4d edits, average %6.1f us, worst %6.1f us\n",
+           c->name, c->edits, c->edits ? c->total / c->edits : 0.0, c->worst);
+}
+
+int main(int argc, const char* argv[])
+{
+    int side = argc > 1 ? atoi(argv[1]) : 8;
+    
+    Job_Init(1);
+    World_Init(&_world);
+    
+    int* coords = malloc(sizeof(int) * 3 * side * side);
+    int count = 0;
+    
+    int x, y;
+    for (x = 0; x < side; ++x)
+    {
+        for (y = 0; y < side; ++y)
+        {
+            coords[count * 3 + 0] = x;
+            coords[count * 3 + 1] = y;
+            coords[count * 3 + 2] = 0;
+            ++count;
+        }
+    }
+    
+    World_PrepareChunks(&_world, coords, count);
+    free(coords);
+    
+    /* loading lit the chunks as they arrived, time lighting them again from scratch */
+    double start = _Now();
+    
+    int i;
+    for (i = 0; i < _world.chunkCount; ++i)
+    {
+        Light_InitChunk(&_world, _world.chunks + i);
+    }
+    
+    printf("initial lighting for %d chunks: %.2f ms\n", _world.chunkCount, (_Now() - start) / 1000.0);
+    
+    int failures = 0;
+    
+    Case_t dig = { "dig", 0, 0.0, 0.0 };
+    Case_t cap = { "cap", 0, 0.0, 0.0 };
+    Case_t emitter = { "emitter", 0, 0.0, 0.0 };
+    Case_t corner = { "corner", 0, 0.0, 0.0 };
+    
+    /* shafts and emitters in the middle of chunks, away from their borders */
+    int cx, cy;
+    for (cx = 1; cx < side - 1; ++cx)
+    {
+        for (cy = 1; cy < side - 1; ++cy)
+        {
+            x = cx * CHUNK_SIZE + CHUNK_SIZE / 2;
+            y = cy * CHUNK_SIZE + CHUNK_SIZE / 2;
+            
+            int top = _Surface(x, y);
+            if (top < BENCH_SHAFT_DEPTH) continue;
+            
+            /* a shaft opens a column to the sky, capping it puts it back in the dark */
+            int z;
+            for (z = top; z > top - BENCH_SHAFT_DEPTH; --z)
+            {
+                _Edit(&dig, x, y, z, BLOCK_AIR);
+            }
+            
+            _Edit(&cap, x, y, top, BLOCK_STONE);
+            
+            /* an emitter down the covered shaft and one out in the open, each taken away again */
+            unsigned char* saved = _SaveLight();
+            _Edit(&emitter, x, y, top - BENCH_SHAFT_DEPTH + 1, BLOCK_GIFT);
+            _Edit(&emitter, x, y, top - BENCH_SHAFT_DEPTH + 1, BLOCK_AIR);
+            failures += !_SameLight(saved);
+            
+            int open = _Surface(x + 3, y + 3) + 1;
+            if (open > 0 && open < CHUNK_SIZE)
+            {
+                saved = _SaveLight();
+                _Edit(&emitter, x + 3, y + 3, open, BLOCK_GIFT);
+                _Edit(&emitter, x + 3, y + 3, open, BLOCK_AIR);
+                failures += !_SameLight(saved);
+            }
+            
+            /* the corner block touches four chunks */
+            x = cx * CHUNK_SIZE;
+            y = cy * CHUNK_SIZE;
+            top = _Surface(x, y);
+            if (top < 0) continue;
+            
+            Block_t* block = World_GetBlockAt(&_world, x, y, top);
+            int type = block->type;
+            
+            saved = _SaveLight();
+            _Edit(&corner, x, y, top, BLOCK_AIR);
+            _Edit(&corner, x, y, top, type);
+            failures += !_SameLight(saved);
+        }
+    }
+    
+    _Print(&dig);
+    _Print(&cap);
+    _Print(&emitter);
+    _Print(&corner);
+    
+    if (failures) printf("%d undone edits left the light changed\n", failures);
+    
+    Job_Shutdown();
+    
+    return failures ? 1 : 0;
+}
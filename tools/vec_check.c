@@ -0,0 +1,290 @@
+/* checks that the simd paths in vec_math give bit identical results to the scalar ones
+ for Mat4_Mult (also with dest being one of its inputs), Mat4_MultVec4, Quat_Mult and Quat_RotateVec3,
+ and prints the time per call of each. the scalar versions come from tools/vec_check_scalar.c.
+ usage: vec_check [cases] */
+
+#include "../vec_math.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define CHECK_TIMING_CALLS 4000000
+
+/* defined in vec_check_scalar.c */
+extern void Scalar_Mat4_Mult(const Mat4_t* a, const Mat4_t* b, Mat4_t* dest);
+extern Vec4_t Scalar_Mat4_MultVec4(const Mat4_t* mat, Vec4_t a);
+extern Quat_t Scalar_Quat_Mult(Quat_t a, Quat_t b);
+extern Vec3_t Scalar_Quat_RotateVec3(Quat_t a, Vec3_t v);
+
+typedef struct
+{
+    const char* name;
+    int cases;
+    int mismatches;
+} Check_t;
+
+static unsigned int _seed = 1;
+
+/* spread over a few orders of magnitude and both signs, so rounding actually happens */
+static float _Random(void)
+{
+    _seed = _seed * 1103515245u + 12345u;
+    float unit = ((_seed >> 8) & 0xffff) / 65536.0f - 0.5f;
+    
+    _seed = _seed * 1103515245u + 12345u;
+    return unit * (float)(1 << ((_seed >> 8) % 12));
+}
+
+static Mat4_t _RandomMat4(void)
+{
+    Mat4_t m;
+    
+    int i;
+    for (i = 0; i < 16; ++i) m.m[i] = _Random();
+    
+    return m;
+}
+
+static Quat_t _RandomQuat(void)
+{
+    Quat_t q;
+    q.x = _Random();
+    q.y = _Random();
+    q.z = _Random();
+    q.w = _Random();
+    return q;
+}
+
+static double _Now(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1000000000.0 + t.tv_nsec;
+}
+
+static void _Compare(Check_t* check, const void* simd, const void* scalar, size_t size)
+{
+    ++check->cases;
+    
+    if (memcmp(simd, scalar, size) == 0) return;
+    
+    if (check->mismatches++ == 0)
+    {
+        const float* a = simd;
+        const float* b = scalar;
+        
+        int i;
+        for (i = 0; i < (int)(size / sizeof(float)); ++i)
+        {
+            if (memcmp(a + i, b + i, sizeof(float)) != 0)
+            {
+                printf("%s: first mismatch in float %d, simd %.9g scalar %.9g\n", check->name, i, a[i], b[i]);
+                break;
+            }
+        }
+    }
+}
+
+/* times of 0 aren't printed */
+static void _Print(const Check_t* check, double simdNs, double scalarNs)
+{
+    printf("%-20s %7d cases, %s", check->name, check->cases, check->mismatches ? "MISMATCHED" : "identical");
+    
+    if (simdNs > 0.0)
+    {
+        printf(", simd %6.2f ns, scalar %6.2f ns per call", simdNs, scalarNs);
+    }
+    
+    printf("\n");
+}
+
+/* the simd inline functions kept out of line, so both sides are timed through the same kind of call */
+static __attribute__((noinline)) Vec4_t _Simd_Mat4_MultVec4(const Mat4_t* mat, Vec4_t a)
+{
+    return Mat4_MultVec4(mat, a);
+}
+
+static __attribute__((noinline)) Quat_t _Simd_Quat_Mult(Quat_t a, Quat_t b)
+{
+    return Quat_Mult(a, b);
+}
+
+static __attribute__((noinline)) Vec3_t _Simd_Quat_RotateVec3(Quat_t a, Vec3_t v)
+{
+    return Quat_RotateVec3(a, v);
+}
+
+/* timing runs over a small set of inputs that stays in cache */
+#define CHECK_INPUTS 256
+
+static Mat4_t _mats[CHECK_INPUTS];
+static Vec4_t _vecs[CHECK_INPUTS];
+static Quat_t _quats[CHECK_INPUTS];
+static Vec3_t _points[CHECK_INPUTS];
+
+/* the results are summed into here so the timed calls can't be optimized away */
+static volatile float _sink;
+
+static double _TimeMat4Mult(void (*mult)(const Mat4_t*, const Mat4_t*, Mat4_t*))
+{
+    Mat4_t result = _mats[0];
+    
+    double start = _Now();
+    
+    int i;
+    for (i = 0; i < CHECK_TIMING_CALLS; ++i)
+    {
+        /* dest is an input, like most callers use it. restarting the chain keeps it from overflowing */
+        if ((i & 15) == 0) result = _mats[(i >> 4) % CHECK_INPUTS];
+        mult(&result, _mats + i % CHECK_INPUTS, &result);
+    }
+    
+    double elapsed = _Now() - start;
+    _sink += result.m[0];
+    
+    return elapsed / CHECK_TIMING_CALLS;
+}
+
+static double _TimeMultVec4(Vec4_t (*multVec4)(const Mat4_t*, Vec4_t))
+{
+    Vec4_t sum = Vec4_Create(0.0f, 0.0f, 0.0f, 0.0f);
+    
+    double start = _Now();
+    
+    int i;
+    for (i = 0; i < CHECK_TIMING_CALLS; ++i)
+    {
+        sum = Vec4_Add(sum, multVec4(_mats + i % CHECK_INPUTS, _vecs[(i * 7) % CHECK_INPUTS]));
+    }
+    
+    double elapsed = _Now() - start;
+    _sink += sum.x;
+    
+    return elapsed / CHECK_TIMING_CALLS;
+}
+
+static double _TimeQuatMult(Quat_t (*quatMult)(Quat_t, Quat_t))
+{
+    Quat_t product = _quats[0];
+    
+    double start = _Now();
+    
+    int i;
+    for (i = 0; i < CHECK_TIMING_CALLS; ++i)
+    {
+        product = quatMult(product, _quats[i % CHECK_INPUTS]);
+    }
+    
+    double elapsed = _Now() - start;
+    _sink += product.w;
+    
+    return elapsed / CHECK_TIMING_CALLS;
+}
+
+static double _TimeRotate(Vec3_t (*rotate)(Quat_t, Vec3_t))
+{
+    Vec3_t sum = Vec3_Zero();
+    
+    double start = _Now();
+    
+    int i;
+    for (i = 0; i < CHECK_TIMING_CALLS; ++i)
+    {
+        sum = Vec3_Add(sum, rotate(_quats[i % CHECK_INPUTS], _points[(i * 7) % CHECK_INPUTS]));
+    }
+    
+    double elapsed = _Now() - start;
+    _sink += sum.x;
+    
+    return elapsed / CHECK_TIMING_CALLS;
+}
+
+int main(int argc, const char* argv[])
+{
+    int cases = argc > 1 ? atoi(argv[1]) : 100000;
+
+#if defined(VEC_MATH_SSE)
+    printf("simd backend: sse\n");
+#elif defined(VEC_MATH_NEON)
+    printf("simd backend: neon\n");
+#else
+    printf("no simd backend, both sides are scalar\n");
+#endif
+    
+    Check_t mult = { "Mat4_Mult", 0, 0 };
+    Check_t multA = { "Mat4_Mult dest == a", 0, 0 };
+    Check_t multB = { "Mat4_Mult dest == b", 0, 0 };
+    Check_t multVec4 = { "Mat4_MultVec4", 0, 0 };
+    Check_t quatMult = { "Quat_Mult", 0, 0 };
+    Check_t rotate = { "Quat_RotateVec3", 0, 0 };
+    
+    int i;
+    for (i = 0; i < cases; ++i)
+    {
+        Mat4_t a = _RandomMat4();
+        Mat4_t b = _RandomMat4();
+        
+        Mat4_t simd, scalar;
+        Mat4_Mult(&a, &b, &simd);
+        Scalar_Mat4_Mult(&a, &b, &scalar);
+        _Compare(&mult, &simd, &scalar, sizeof(Mat4_t));
+        
+        /* aliased results are checked against the plain scalar product */
+        Mat4_t aliased = a;
+        Mat4_Mult(&aliased, &b, &aliased);
+        _Compare(&multA, &aliased, &scalar, sizeof(Mat4_t));
+        
+        aliased = b;
+        Mat4_Mult(&a, &aliased, &aliased);
+        _Compare(&multB, &aliased, &scalar, sizeof(Mat4_t));
+        
+        aliased = a;
+        Scalar_Mat4_Mult(&aliased, &b, &aliased);
+        _Compare(&multA, &aliased, &scalar, sizeof(Mat4_t));
+        
+        aliased = b;
+        Scalar_Mat4_Mult(&a, &aliased, &aliased);
+        _Compare(&multB, &aliased, &scalar, sizeof(Mat4_t));
+        
+        Vec4_t v = Vec4_Create(_Random(), _Random(), _Random(), _Random());
+        Vec4_t simdVec4 = Mat4_MultVec4(&a, v);
+        Vec4_t scalarVec4 = Scalar_Mat4_MultVec4(&a, v);
+        _Compare(&multVec4, &simdVec4, &scalarVec4, sizeof(Vec4_t));
+        
+        Quat_t p = _RandomQuat();
+        Quat_t q = _RandomQuat();
+        Quat_t simdQuat = Quat_Mult(p, q);
+        Quat_t scalarQuat = Scalar_Quat_Mult(p, q);
+        _Compare(&quatMult, &simdQuat, &scalarQuat, sizeof(Quat_t));
+        
+        Vec3_t point = Vec3_Create(_Random(), _Random(), _Random());
+        Vec3_t simdPoint = Quat_RotateVec3(p, point);
+        Vec3_t scalarPoint = Scalar_Quat_RotateVec3(p, point);
+        _Compare(&rotate, &simdPoint, &scalarPoint, sizeof(Vec3_t));
+    }
+    
+    for (i = 0; i < CHECK_INPUTS; ++i)
+    {
+        _mats[i] = _RandomMat4();
+        _vecs[i] = Vec4_Create(_Random(), _Random(), _Random(), _Random());
+        
+        /* unit quaternions so the chained products stay bounded */
+        _quats[i] = Quat_Normalize(_RandomQuat());
+        _points[i] = Vec3_Create(_Random(), _Random(), _Random());
+    }
+    
+    _Print(&mult, _TimeMat4Mult(Mat4_Mult), _TimeMat4Mult(Scalar_Mat4_Mult));
+    _Print(&multA, 0.0, 0.0);
+    _Print(&multB, 0.0, 0.0);
+    _Print(&multVec4, _TimeMultVec4(_Simd_Mat4_MultVec4), _TimeMultVec4(Scalar_Mat4_MultVec4));
+    _Print(&quatMult, _TimeQuatMult(_Simd_Quat_Mult), _TimeQuatMult(Scalar_Quat_Mult));
+    _Print(&rotate, _TimeRotate(_Simd_Quat_RotateVec3), _TimeRotate(Scalar_Quat_RotateVec3));
+    
+    int failures = mult.mismatches + multA.mismatches + multB.mismatches +
+                   multVec4.mismatches + quatMult.mismatches + rotate.mismatches;
+    
+    printf(failures ? "FAILED\n" : "ok\n");
+    
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,40 @@
+/* the scalar half of vec_check, vec_math.c built a second time with VEC_MATH_SCALAR forced.
+ everything it defines is renamed with a Scalar_ prefix so it links next to the simd build */
+
+#ifndef VEC_MATH_SCALAR
+#define VEC_MATH_SCALAR
+#endif
+
+#define Mat4_Mult Scalar_Mat4_Mult
+#define Mat4_TransformVec4s Scalar_Mat4_TransformVec4s
+#define Mat4_TransformVec3s Scalar_Mat4_TransformVec3s
+#define Mat4_TransformPoints Scalar_Mat4_TransformPoints
+#define Mat4_Transpose Scalar_Mat4_Transpose
+#define Mat4_CreateLook Scalar_Mat4_CreateLook
+#define Mat4_CreateFrustum Scalar_Mat4_CreateFrustum
+#define Mat4_Det Scalar_Mat4_Det
+#define Mat4_Inverse Scalar_Mat4_Inverse
+#define Quat_ToMatrix Scalar_Quat_ToMatrix
+#define Quat_FromEuler Scalar_Quat_FromEuler
+#define Quat_FromAngle Scalar_Quat_FromAngle
+#define Quat_Slerp Scalar_Quat_Slerp
+#define Quat_RotateVec3s Scalar_Quat_RotateVec3s
+#define Quat_RotatePoints Scalar_Quat_RotatePoints
+
+#include "../vec_math.c"
+
+/* the inline functions in vec_math.h, built scalar here */
+Vec4_t Scalar_Mat4_MultVec4(const Mat4_t* mat, Vec4_t a)
+{
+    return Mat4_MultVec4(mat, a);
+}
+
+Quat_t Scalar_Quat_Mult(Quat_t a, Quat_t b)
+{
+    return Quat_Mult(a, b);
+}
+
+Vec3_t Scalar_Quat_RotateVec3(Quat_t a, Vec3_t v)
+{
+    return Quat_RotateVec3(a, v);
+}
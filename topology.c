@@ -1,15 +1,20 @@
 
 #include "topology.h"
+#include "job.h"
+#include "visibility.h"
+#include "occlusion.h"
+#include "mesh_cache.h"
+#include "atlas.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <assert.h>
 
-#define BLOCK_ATLAS_SIZE 0.0625f
-#define BLOCK_ATLAS_ROWS 16
+#define BLOCK_ATLAS_SIZE ATLAS_TILE_SPAN(BLOCK_ATLAS_ROWS)
 
 static Vec2_t Atlas_UVForTex(int texID)
 {
-    Vec2_t uv;
-    uv.x = (texID % BLOCK_ATLAS_ROWS) * BLOCK_ATLAS_SIZE;
-    uv.y = (texID / BLOCK_ATLAS_ROWS) * BLOCK_ATLAS_SIZE;
-    return uv;
+    return Atlas_TileUV(texID, BLOCK_ATLAS_ROWS);
 }
 
 static int Atlas_TexForBlock(int blockType, int faceID)
@@ -66,101 +71,1028 @@ static int Atlas_TexForBlock(int blockType, int faceID)
 }
 
 
-void Topologize_World(Cam_t* cam, World_t* world)
+/* brightness for each light level, with a little ambient so caves aren't black */
+static const unsigned char LightShadeTable[LIGHT_MAX + 1] =
+{
+    38, 40, 42, 45, 49, 54, 60, 68, 77, 89, 104, 122, 145, 174, 210, 255
+};
+
+/* light level of a block that may be in a neighboring chunk */
+static int _Topologize_Light(const Chunk_t* chunk, const Chunk_t* const neighbors[6], int x, int y, int z)
+{
+    const Chunk_t* source = chunk;
+    
+    if (x < 0) { source = neighbors[0]; x += CHUNK_SIZE; }
+    else if (x >= CHUNK_SIZE) { source = neighbors[1]; x -= CHUNK_SIZE; }
+    else if (y < 0) { source = neighbors[2]; y += CHUNK_SIZE; }
+    else if (y >= CHUNK_SIZE) { source = neighbors[3]; y -= CHUNK_SIZE; }
+    else if (z < 0) { source = neighbors[4]; z += CHUNK_SIZE; }
+    else if (z >= CHUNK_SIZE) { source = neighbors[5]; z -= CHUNK_SIZE; }
+    
+    /* nothing loaded there - treat it as open sky */
+    if (!source) return LIGHT_MAX;
+    
+    int sky = Chunk_GetLight(source, LIGHT_SKY, x, y, z);
+    int block = Chunk_GetLight(source, LIGHT_BLOCK, x, y, z);
+    
+    return sky > block ? sky : block;
+}
+
+/* shade of a face comes from the block in front of it */
+static unsigned char _Topologize_Shade(const Chunk_t* chunk, const Chunk_t* const neighbors[6], int x, int y, int z)
+{
+    return LightShadeTable[_Topologize_Light(chunk, neighbors, x, y, z)];
+}
+
+/* block types of a chunk plus a one block border taken from its neighbors, and whether each is opaque.
+ used for face culling and ambient occlusion so neither has to special case chunk edges */
+#define PAD_SIZE (CHUNK_SIZE + 2)
+#define PAD_INDEX(x, y, z) (((x) * PAD_SIZE + (y)) * PAD_SIZE + (z))
+
+#define PAD_STRIDE_X (PAD_SIZE * PAD_SIZE)
+#define PAD_STRIDE_Y PAD_SIZE
+#define PAD_STRIDE_Z 1
+
+/* missing chunks count as air so faces at the edge of the loaded world are kept */
+static inline char _Topologize_Type(const Chunk_t* chunk, int x, int y, int z)
+{
+    return chunk ? chunk->blocks[x][y][z].type : BLOCK_AIR;
+}
+
+static void _Topologize_Solidity(const Chunk_t* chunk, const Chunk_t* around[3][3][3], char* types, unsigned char* solid)
+{
+    int x, y, z;
+    
+    /* which neighbor and which block within it each padded coordinate refers to */
+    int region[PAD_SIZE];
+    int local[PAD_SIZE];
+    
+    for (x = 0; x < PAD_SIZE; ++x)
+    {
+        region[x] = (x == 0) ? 0 : ((x == PAD_SIZE - 1) ? 2 : 1);
+        local[x] = (x + CHUNK_SIZE - 1) % CHUNK_SIZE;
+    }
+    
+    for (x = 0; x < PAD_SIZE; ++x)
+    {
+        for (y = 0; y < PAD_SIZE; ++y)
+        {
+            char* column = types + PAD_INDEX(x, y, 0);
+            
+            if (region[x] == 1 && region[y] == 1)
+            {
+                /* interior column, only the two ends come from neighbors */
+                const Block_t* blocks = chunk->blocks[x - 1][y - 1];
+                
+                for (z = 0; z < CHUNK_SIZE; ++z)
+                {
+                    column[z + 1] = blocks[z].type;
+                }
+                
+                column[0] = _Topologize_Type(around[1][1][0], local[x], local[y], CHUNK_SIZE - 1);
+                column[PAD_SIZE - 1] = _Topologize_Type(around[1][1][2], local[x], local[y], 0);
+            }
+            else
+            {
+                for (z = 0; z < PAD_SIZE; ++z)
+                {
+                    column[z] = _Topologize_Type(around[region[x]][region[y]][region[z]], local[x], local[y], local[z]);
+                }
+            }
+        }
+    }
+    
+    int i;
+    for (i = 0; i < PAD_SIZE * PAD_SIZE * PAD_SIZE; ++i)
+    {
+        solid[i] = Block_Opaque(types[i]);
+    }
+}
+
+/* a face is hidden by an opaque block in front of it, or by another block of the same see through type
+ so the inside of a body of ice isn't drawn */
+static inline int _Topologize_FaceHidden(int type, int front)
+{
+    return Block_Opaque(front) || front == type;
+}
+
+/* opacity of faces in the translucent layer */
+#define TRANSLUCENT_ALPHA 160
+
+static void _Topologize_SetAlpha(Face_t* faces, int count, unsigned char alpha)
+{
+    int i, j;
+    for (i = 0; i < count; ++i)
+    {
+        for (j = 0; j < 4; ++j)
+        {
+            faces[i].verts[j].color[3] = alpha;
+        }
+    }
+}
+
+/* brightness scale out of 256 for each ambient occlusion level, 0 being a corner enclosed on all sides */
+static const int OcclusionScaleTable[4] = { 128, 171, 213, 256 };
+
+/* 3 is open, each solid neighbor darkens by one.
+ two solid sides hide the corner completely so the diagonal counts as solid too */
+static inline int _Topologize_VertexAO(int side1, int side2, int corner)
 {
+    return 3 - side1 - side2 - (corner | (side1 & side2));
+}
+
+/* occlusion for the four corners of a face from the blocks around the cell it looks into.
+ du and dv step along the face, corners are ordered (-u -v) (+u -v) (+u +v) (-u +v) */
+static inline void _Topologize_Corners(const unsigned char* solid, int front, int du, int dv, unsigned char shade, int ao[4], unsigned char shades[4])
+{
+    int uMinus = solid[front - du];
+    int uPlus = solid[front + du];
+    int vMinus = solid[front - dv];
+    int vPlus = solid[front + dv];
+    
+    ao[0] = _Topologize_VertexAO(uMinus, vMinus, solid[front - du - dv]);
+    ao[1] = _Topologize_VertexAO(uPlus, vMinus, solid[front + du - dv]);
+    ao[2] = _Topologize_VertexAO(uPlus, vPlus, solid[front + du + dv]);
+    ao[3] = _Topologize_VertexAO(uMinus, vPlus, solid[front - du + dv]);
+    
     int i;
-    for (i = 0; i < world->chunkCount; ++i)
+    for (i = 0; i < 4; ++i)
+    {
+        shades[i] = (shade * OcclusionScaleTable[ao[i]]) >> 8;
+    }
+}
+
+/* quads are drawn as two triangles split along verts 0-2.
+ when the other diagonal is darker rotate the verts so the split follows it
+ and the occlusion gradient doesn't depend on which way the quad was wound */
+static inline void _Topologize_Triangulate(Face_t* face, int flip)
+{
+    if (!flip) return;
+    
+    Vert_t first = face->verts[0];
+    face->verts[0] = face->verts[1];
+    face->verts[1] = face->verts[2];
+    face->verts[2] = face->verts[3];
+    face->verts[3] = first;
+}
+
+/* corners of a coarse face as x, y, z, u, v - in the same order and winding as the full mesh.
+ faces are indexed like CHUNK_FACE_NEG_X to CHUNK_FACE_POS_Z */
+static const unsigned char LodCorners[CHUNK_FACE_COUNT][4][5] =
+{
+    {{0, 0, 1, 0, 0}, {0, 1, 1, 1, 0}, {0, 1, 0, 1, 1}, {0, 0, 0, 0, 1}},
+    {{1, 0, 0, 0, 1}, {1, 1, 0, 1, 1}, {1, 1, 1, 1, 0}, {1, 0, 1, 0, 0}},
+    {{0, 0, 0, 0, 1}, {1, 0, 0, 1, 1}, {1, 0, 1, 1, 0}, {0, 0, 1, 0, 0}},
+    {{0, 1, 1, 0, 0}, {1, 1, 1, 1, 0}, {1, 1, 0, 1, 1}, {0, 1, 0, 0, 1}},
+    {{0, 1, 0, 0, 1}, {1, 1, 0, 1, 1}, {1, 0, 0, 1, 0}, {0, 0, 0, 0, 0}},
+    {{0, 0, 1, 0, 0}, {1, 0, 1, 1, 0}, {1, 1, 1, 1, 1}, {0, 1, 1, 0, 1}},
+};
+
+/* face ids Atlas_TexForBlock expects for each chunk face */
+static const int LodTexFaces[CHUNK_FACE_COUNT] = { 2, 3, 4, 5, 0, 1 };
+
+#define LOD_PAD_SIZE (CHUNK_SIZE / 2 + 2)
+
+/* a cell at some lod covers 2^lod blocks on each side.
+ it is solid if at least half its blocks are and takes the type of its highest solid block so grass stays on top */
+static int _Topologize_CellType(const Chunk_t* chunk, int lod, int cx, int cy, int cz)
+{
+    int scale = 1 << lod;
+    int solidCount = 0;
+    int top = -1;
+    int type = BLOCK_AIR;
+    
+    int x, y, z;
+    for (x = cx * scale; x < (cx + 1) * scale; ++x)
     {
-        Chunk_t* chunk = &world->chunks[i];
+        for (y = cy * scale; y < (cy + 1) * scale; ++y)
+        {
+            const Block_t* column = chunk->blocks[x][y];
+            
+            for (z = cz * scale; z < (cz + 1) * scale; ++z)
+            {
+                if (column[z].type == BLOCK_AIR) continue;
+                
+                ++solidCount;
+                
+                if (z > top)
+                {
+                    top = z;
+                    type = column[z].type;
+                }
+            }
+        }
+    }
+    
+    return (solidCount * 2 >= scale * scale * scale) ? type : BLOCK_AIR;
+}
+
+/* meshes a chunk from downsampled blocks, without ambient occlusion.
+ border cells are only culled against neighbors at the same lod.
+ anything else keeps its faces so there are no holes where the levels meet */
+static void _Topologize_ChunkLod(const Chunk_t* chunk, const Chunk_t* const neighbors[6], MeshBuild_t* build)
+{
+    int lod = chunk->lod;
+    int scale = 1 << lod;
+    int size = CHUNK_SIZE >> lod;
+    
+    const int strides[3] = {LOD_PAD_SIZE * LOD_PAD_SIZE, LOD_PAD_SIZE, 1};
+    
+    char cells[LOD_PAD_SIZE * LOD_PAD_SIZE * LOD_PAD_SIZE];
+    memset(cells, BLOCK_AIR, sizeof(cells));
+    
+    int cx, cy, cz;
+    for (cx = 0; cx < size; ++cx)
+    {
+        for (cy = 0; cy < size; ++cy)
+        {
+            for (cz = 0; cz < size; ++cz)
+            {
+                cells[(cx + 1) * strides[0] + (cy + 1) * strides[1] + (cz + 1)] = _Topologize_CellType(chunk, lod, cx, cy, cz);
+            }
+        }
+    }
+    
+    /* the layer of cells just past each face, taken from the neighbor */
+    int f;
+    for (f = 0; f < CHUNK_FACE_COUNT; ++f)
+    {
+        const Chunk_t* neighbor = neighbors[f];
+        if (!neighbor || neighbor->lod != lod) continue;
+        
+        int axis = f / 2;
+        int u = (axis + 1) % 3;
+        int v = (axis + 2) % 3;
         
-        if (!Cam_SphereVisible(cam, chunk->boundingSphere)) continue;
+        int padLayer = (f & 1) ? size + 1 : 0;
+        int sourceLayer = (f & 1) ? 0 : size - 1;
         
-        if (chunk->dirtyCache)
+        int a, b;
+        for (a = 0; a < size; ++a)
         {
-            chunk->cacheSize = 0;
-            
-            Vec2_t uv;
-            int x,y,z;
-            
-            for (x = 0; x < CHUNK_SIZE; ++x)
+            for (b = 0; b < size; ++b)
             {
-                for (y = 0; y < CHUNK_SIZE; ++y)
+                int cell[3];
+                cell[axis] = sourceLayer;
+                cell[u] = a;
+                cell[v] = b;
+                
+                int index = padLayer * strides[axis] + (a + 1) * strides[u] + (b + 1) * strides[v];
+                cells[index] = _Topologize_CellType(neighbor, lod, cell[0], cell[1], cell[2]);
+            }
+        }
+    }
+    
+    for (cx = 0; cx < size; ++cx)
+    {
+        for (cy = 0; cy < size; ++cy)
+        {
+            for (cz = 0; cz < size; ++cz)
+            {
+                int index = (cx + 1) * strides[0] + (cy + 1) * strides[1] + (cz + 1);
+                
+                int type = cells[index];
+                if (type == BLOCK_AIR) continue;
+                
+                int cell[3] = {cx, cy, cz};
+                
+                int layer = Block_Layer(type);
+                Face_t* faces = build->faces[layer];
+                int first = build->faceCounts[layer];
+                int faceCount = first;
+                
+                for (f = 0; f < CHUNK_FACE_COUNT; ++f)
                 {
-                    for (z = 0; z < CHUNK_SIZE; ++z)
+                    int axis = f / 2;
+                    int step = (f & 1) ? 1 : -1;
+                    
+                    if (_Topologize_FaceHidden(type, cells[index + step * strides[axis]])) continue;
+                    
+                    /* brightest block in the slab in front of the face */
+                    int u = (axis + 1) % 3;
+                    int v = (axis + 2) % 3;
+                    
+                    int block[3];
+                    block[axis] = (f & 1) ? (cell[axis] + 1) * scale : cell[axis] * scale - 1;
+                    
+                    int light = 0;
+                    int a, b;
+                    for (a = 0; a < scale && light < LIGHT_MAX; ++a)
                     {
-                        int type = chunk->blocks[x][y][z].type;
-                        if (type == BLOCK_AIR) continue;
-                        
-                        if (z == 0 || (chunk->blocks[x][y][z - 1].type == BLOCK_AIR))
-                        {
-                            uv = Atlas_UVForTex(Atlas_TexForBlock(type, 0));
-                            
-                            chunk->cache[chunk->cacheSize].verts[3] = Vert_Create(x, y, z, uv.x, uv.y);
-                            chunk->cache[chunk->cacheSize].verts[2] = Vert_Create(x + 1, y, z, uv.x + BLOCK_ATLAS_SIZE, uv.y);
-                            chunk->cache[chunk->cacheSize].verts[1] = Vert_Create(x + 1, y + 1, z, uv.x + BLOCK_ATLAS_SIZE, uv.y + BLOCK_ATLAS_SIZE);
-                            chunk->cache[chunk->cacheSize].verts[0] = Vert_Create(x, y + 1, z, uv.x, uv.y + BLOCK_ATLAS_SIZE);
-                            ++chunk->cacheSize;
-                        }
-                        
-                        if (z == CHUNK_SIZE - 1 || (chunk->blocks[x][y][z + 1].type == BLOCK_AIR))
+                        for (b = 0; b < scale && light < LIGHT_MAX; ++b)
                         {
-                            uv = Atlas_UVForTex(Atlas_TexForBlock(type, 1));
+                            block[u] = cell[u] * scale + a;
+                            block[v] = cell[v] * scale + b;
                             
-                            chunk->cache[chunk->cacheSize].verts[0] = Vert_Create(x, y, z + 1, uv.x, uv.y);
-                            chunk->cache[chunk->cacheSize].verts[1] = Vert_Create(x + 1, y, z + 1, uv.x + BLOCK_ATLAS_SIZE, uv.y);
-                            chunk->cache[chunk->cacheSize].verts[2] = Vert_Create(x + 1, y + 1, z + 1, uv.x + BLOCK_ATLAS_SIZE, uv.y + BLOCK_ATLAS_SIZE);
-                            chunk->cache[chunk->cacheSize].verts[3] = Vert_Create(x, y + 1, z + 1, uv.x, uv.y + BLOCK_ATLAS_SIZE);
-                            ++chunk->cacheSize;
-                        }
-                        
-                        
-                        if (y == 0 || (chunk->blocks[x][y - 1][z].type == BLOCK_AIR))
-                        {
-                            uv = Atlas_UVForTex(Atlas_TexForBlock(type, 4));
-                            
-                            chunk->cache[chunk->cacheSize].verts[0] = Vert_Create(x, y, z, uv.x, uv.y + BLOCK_ATLAS_SIZE);
-                            chunk->cache[chunk->cacheSize].verts[1] = Vert_Create(x + 1, y, z, uv.x + BLOCK_ATLAS_SIZE, uv.y + BLOCK_ATLAS_SIZE);
-                            chunk->cache[chunk->cacheSize].verts[2] = Vert_Create(x + 1, y, z + 1, uv.x + BLOCK_ATLAS_SIZE, uv.y);
-                            chunk->cache[chunk->cacheSize].verts[3] = Vert_Create(x, y, z + 1, uv.x, uv.y);
-                            ++chunk->cacheSize;
-                        }
-                        
-                        if (y == CHUNK_SIZE - 1 || (chunk->blocks[x][y + 1][z].type == BLOCK_AIR))
-                        {
-                            uv = Atlas_UVForTex(Atlas_TexForBlock(type, 5));
-                            
-                            chunk->cache[chunk->cacheSize].verts[3] = Vert_Create(x, y + 1, z, uv.x, uv.y + BLOCK_ATLAS_SIZE);
-                            chunk->cache[chunk->cacheSize].verts[2] = Vert_Create(x + 1, y + 1, z, uv.x + BLOCK_ATLAS_SIZE, uv.y + BLOCK_ATLAS_SIZE);
-                            chunk->cache[chunk->cacheSize].verts[1] = Vert_Create(x + 1, y + 1, z + 1, uv.x + BLOCK_ATLAS_SIZE, uv.y);
-                            chunk->cache[chunk->cacheSize].verts[0] = Vert_Create(x, y + 1, z + 1, uv.x, uv.y);
-                            ++chunk->cacheSize;
-                        }
-                        
-                        if (x == 0 || (chunk->blocks[x - 1][y][z].type == BLOCK_AIR))
-                        {
-                            uv = Atlas_UVForTex(Atlas_TexForBlock(type, 2));
-                            
-                            chunk->cache[chunk->cacheSize].verts[3] = Vert_Create(x, y, z, uv.x, uv.y + BLOCK_ATLAS_SIZE);
-                            chunk->cache[chunk->cacheSize].verts[2] = Vert_Create(x, y + 1, z, uv.x + BLOCK_ATLAS_SIZE, uv.y + BLOCK_ATLAS_SIZE);
-                            chunk->cache[chunk->cacheSize].verts[1] = Vert_Create(x, y + 1, z + 1, uv.x + BLOCK_ATLAS_SIZE, uv.y);
-                            chunk->cache[chunk->cacheSize].verts[0] = Vert_Create(x, y, z + 1, uv.x, uv.y);
-                            ++chunk->cacheSize;
-                        }
-                        
-                        if (x == CHUNK_SIZE - 1 || (chunk->blocks[x + 1][y][z].type == BLOCK_AIR))
-                        {
-                            uv = Atlas_UVForTex(Atlas_TexForBlock(type, 3));
-                            
-                            chunk->cache[chunk->cacheSize].verts[0] = Vert_Create(x + 1, y, z, uv.x, uv.y + BLOCK_ATLAS_SIZE);
-                            chunk->cache[chunk->cacheSize].verts[1] = Vert_Create(x + 1, y + 1, z, uv.x + BLOCK_ATLAS_SIZE, uv.y + BLOCK_ATLAS_SIZE);
-                            chunk->cache[chunk->cacheSize].verts[2] = Vert_Create(x + 1, y + 1, z + 1, uv.x + BLOCK_ATLAS_SIZE, uv.y);
-                            chunk->cache[chunk->cacheSize].verts[3] = Vert_Create(x + 1, y, z + 1, uv.x, uv.y);
-                            ++chunk->cacheSize;
+                            int level = _Topologize_Light(chunk, neighbors, block[0], block[1], block[2]);
+                            if (level > light) light = level;
                         }
                     }
+                    
+                    unsigned char shade = LightShadeTable[light];
+                    Vec2_t uv = Atlas_UVForTex(Atlas_TexForBlock(type, LodTexFaces[f]));
+                    
+                    Face_t* face = faces + faceCount++;
+                    
+                    int i;
+                    for (i = 0; i < 4; ++i)
+                    {
+                        const unsigned char* corner = LodCorners[f][i];
+                        face->verts[i] = Vert_Create((cx + corner[0]) * scale,
+                                                     (cy + corner[1]) * scale,
+                                                     (cz + corner[2]) * scale,
+                                                     uv.x + corner[3] * BLOCK_ATLAS_SIZE,
+                                                     uv.y + corner[4] * BLOCK_ATLAS_SIZE,
+                                                     shade);
+                    }
+                }
+                
+                if (layer == BLOCK_LAYER_TRANSLUCENT) _Topologize_SetAlpha(faces + first, faceCount - first, TRANSLUCENT_ALPHA);
+                build->faceCounts[layer] = faceCount;
+            }
+        }
+    }
+}
+
+/* full resolution faces with ambient occlusion for one section of a chunk, added to the layer of each block */
+static void _Topologize_Section(const Chunk_t* chunk,
+                                const char* types,
+                                const unsigned char* solid,
+                                const Chunk_t* const neighbors[6],
+                                int sx, int sy, int sz,
+                                MeshBuild_t* build)
+{
+    Vec2_t uv;
+    unsigned char shade;
+    unsigned char shades[4];
+    int ao[4];
+    int x,y,z;
+    
+    for (x = sx * CHUNK_SECTION_SIZE; x < (sx + 1) * CHUNK_SECTION_SIZE; ++x)
+    {
+        for (y = sy * CHUNK_SECTION_SIZE; y < (sy + 1) * CHUNK_SECTION_SIZE; ++y)
+        {
+            for (z = sz * CHUNK_SECTION_SIZE; z < (sz + 1) * CHUNK_SECTION_SIZE; ++z)
+            {
+                int type = chunk->blocks[x][y][z].type;
+                if (type == BLOCK_AIR) continue;
+                
+                int layer = Block_Layer(type);
+                Face_t* faces = build->faces[layer];
+                int first = build->faceCounts[layer];
+                int faceCount = first;
+                
+                if (!_Topologize_FaceHidden(type, types[PAD_INDEX(x + 1, y + 1, z)]))
+                {
+                    uv = Atlas_UVForTex(Atlas_TexForBlock(type, 0));
+                    shade = _Topologize_Shade(chunk, neighbors, x, y, z - 1);
+                    _Topologize_Corners(solid, PAD_INDEX(x + 1, y + 1, z), PAD_STRIDE_X, PAD_STRIDE_Y, shade, ao, shades);
+                    
+                    faces[faceCount].verts[3] = Vert_Create(x, y, z, uv.x, uv.y, shades[0]);
+                    faces[faceCount].verts[2] = Vert_Create(x + 1, y, z, uv.x + BLOCK_ATLAS_SIZE, uv.y, shades[1]);
+                    faces[faceCount].verts[1] = Vert_Create(x + 1, y + 1, z, uv.x + BLOCK_ATLAS_SIZE, uv.y + BLOCK_ATLAS_SIZE, shades[2]);
+                    faces[faceCount].verts[0] = Vert_Create(x, y + 1, z, uv.x, uv.y + BLOCK_ATLAS_SIZE, shades[3]);
+                    _Topologize_Triangulate(&faces[faceCount], ao[3] + ao[1] > ao[2] + ao[0]);
+                    ++faceCount;
+                }
+                
+                if (!_Topologize_FaceHidden(type, types[PAD_INDEX(x + 1, y + 1, z + 2)]))
+                {
+                    uv = Atlas_UVForTex(Atlas_TexForBlock(type, 1));
+                    shade = _Topologize_Shade(chunk, neighbors, x, y, z + 1);
+                    _Topologize_Corners(solid, PAD_INDEX(x + 1, y + 1, z + 2), PAD_STRIDE_X, PAD_STRIDE_Y, shade, ao, shades);
+                    
+                    faces[faceCount].verts[0] = Vert_Create(x, y, z + 1, uv.x, uv.y, shades[0]);
+                    faces[faceCount].verts[1] = Vert_Create(x + 1, y, z + 1, uv.x + BLOCK_ATLAS_SIZE, uv.y, shades[1]);
+                    faces[faceCount].verts[2] = Vert_Create(x + 1, y + 1, z + 1, uv.x + BLOCK_ATLAS_SIZE, uv.y + BLOCK_ATLAS_SIZE, shades[2]);
+                    faces[faceCount].verts[3] = Vert_Create(x, y + 1, z + 1, uv.x, uv.y + BLOCK_ATLAS_SIZE, shades[3]);
+                    _Topologize_Triangulate(&faces[faceCount], ao[0] + ao[2] > ao[1] + ao[3]);
+                    ++faceCount;
+                }
+                
+                
+                if (!_Topologize_FaceHidden(type, types[PAD_INDEX(x + 1, y, z + 1)]))
+                {
+                    uv = Atlas_UVForTex(Atlas_TexForBlock(type, 4));
+                    shade = _Topologize_Shade(chunk, neighbors, x, y - 1, z);
+                    _Topologize_Corners(solid, PAD_INDEX(x + 1, y, z + 1), PAD_STRIDE_Z, PAD_STRIDE_X, shade, ao, shades);
+                    
+                    faces[faceCount].verts[0] = Vert_Create(x, y, z, uv.x, uv.y + BLOCK_ATLAS_SIZE, shades[0]);
+                    faces[faceCount].verts[1] = Vert_Create(x + 1, y, z, uv.x + BLOCK_ATLAS_SIZE, uv.y + BLOCK_ATLAS_SIZE, shades[3]);
+                    faces[faceCount].verts[2] = Vert_Create(x + 1, y, z + 1, uv.x + BLOCK_ATLAS_SIZE, uv.y, shades[2]);
+                    faces[faceCount].verts[3] = Vert_Create(x, y, z + 1, uv.x, uv.y, shades[1]);
+                    _Topologize_Triangulate(&faces[faceCount], ao[0] + ao[2] > ao[3] + ao[1]);
+                    ++faceCount;
+                }
+                
+                if (!_Topologize_FaceHidden(type, types[PAD_INDEX(x + 1, y + 2, z + 1)]))
+                {
+                    uv = Atlas_UVForTex(Atlas_TexForBlock(type, 5));
+                    shade = _Topologize_Shade(chunk, neighbors, x, y + 1, z);
+                    _Topologize_Corners(solid, PAD_INDEX(x + 1, y + 2, z + 1), PAD_STRIDE_Z, PAD_STRIDE_X, shade, ao, shades);
+                    
+                    faces[faceCount].verts[3] = Vert_Create(x, y + 1, z, uv.x, uv.y + BLOCK_ATLAS_SIZE, shades[0]);
+                    faces[faceCount].verts[2] = Vert_Create(x + 1, y + 1, z, uv.x + BLOCK_ATLAS_SIZE, uv.y + BLOCK_ATLAS_SIZE, shades[3]);
+                    faces[faceCount].verts[1] = Vert_Create(x + 1, y + 1, z + 1, uv.x + BLOCK_ATLAS_SIZE, uv.y, shades[2]);
+                    faces[faceCount].verts[0] = Vert_Create(x, y + 1, z + 1, uv.x, uv.y, shades[1]);
+                    _Topologize_Triangulate(&faces[faceCount], ao[1] + ao[3] > ao[2] + ao[0]);
+                    ++faceCount;
+                }
+                
+                if (!_Topologize_FaceHidden(type, types[PAD_INDEX(x, y + 1, z + 1)]))
+                {
+                    uv = Atlas_UVForTex(Atlas_TexForBlock(type, 2));
+                    shade = _Topologize_Shade(chunk, neighbors, x - 1, y, z);
+                    _Topologize_Corners(solid, PAD_INDEX(x, y + 1, z + 1), PAD_STRIDE_Y, PAD_STRIDE_Z, shade, ao, shades);
+                    
+                    faces[faceCount].verts[3] = Vert_Create(x, y, z, uv.x, uv.y + BLOCK_ATLAS_SIZE, shades[0]);
+                    faces[faceCount].verts[2] = Vert_Create(x, y + 1, z, uv.x + BLOCK_ATLAS_SIZE, uv.y + BLOCK_ATLAS_SIZE, shades[1]);
+                    faces[faceCount].verts[1] = Vert_Create(x, y + 1, z + 1, uv.x + BLOCK_ATLAS_SIZE, uv.y, shades[2]);
+                    faces[faceCount].verts[0] = Vert_Create(x, y, z + 1, uv.x, uv.y, shades[3]);
+                    _Topologize_Triangulate(&faces[faceCount], ao[3] + ao[1] > ao[2] + ao[0]);
+                    ++faceCount;
+                }
+                
+                if (!_Topologize_FaceHidden(type, types[PAD_INDEX(x + 2, y + 1, z + 1)]))
+                {
+                    uv = Atlas_UVForTex(Atlas_TexForBlock(type, 3));
+                    shade = _Topologize_Shade(chunk, neighbors, x + 1, y, z);
+                    _Topologize_Corners(solid, PAD_INDEX(x + 2, y + 1, z + 1), PAD_STRIDE_Y, PAD_STRIDE_Z, shade, ao, shades);
+                    
+                    faces[faceCount].verts[0] = Vert_Create(x + 1, y, z, uv.x, uv.y + BLOCK_ATLAS_SIZE, shades[0]);
+                    faces[faceCount].verts[1] = Vert_Create(x + 1, y + 1, z, uv.x + BLOCK_ATLAS_SIZE, uv.y + BLOCK_ATLAS_SIZE, shades[1]);
+                    faces[faceCount].verts[2] = Vert_Create(x + 1, y + 1, z + 1, uv.x + BLOCK_ATLAS_SIZE, uv.y, shades[2]);
+                    faces[faceCount].verts[3] = Vert_Create(x + 1, y, z + 1, uv.x, uv.y, shades[3]);
+                    _Topologize_Triangulate(&faces[faceCount], ao[0] + ao[2] > ao[1] + ao[3]);
+                    ++faceCount;
+                }
+                
+                if (layer == BLOCK_LAYER_TRANSLUCENT) _Topologize_SetAlpha(faces + first, faceCount - first, TRANSLUCENT_ALPHA);
+                build->faceCounts[layer] = faceCount;
+            }
+        }
+    }
+}
+
+/* full resolution mesh, faces of each layer are grouped by section with the build's sectionStarts giving where each begins.
+ sections not in the dirty mask are copied from the previous mesh instead of being rebuilt */
+static void _Topologize_ChunkFull(const Chunk_t* chunk,
+                                  const Chunk_t* around[3][3][3],
+                                  const Chunk_t* const neighbors[6],
+                                  uint64_t dirty,
+                                  const Mesh_t* previous,
+                                  MeshBuild_t* build)
+{
+    char types[PAD_SIZE * PAD_SIZE * PAD_SIZE];
+    unsigned char solid[PAD_SIZE * PAD_SIZE * PAD_SIZE];
+    _Topologize_Solidity(chunk, around, types, solid);
+    
+    int layer;
+    
+    int sx, sy, sz;
+    for (sx = 0; sx < CHUNK_SECTIONS_PER_SIDE; ++sx)
+    {
+        for (sy = 0; sy < CHUNK_SECTIONS_PER_SIDE; ++sy)
+        {
+            for (sz = 0; sz < CHUNK_SECTIONS_PER_SIDE; ++sz)
+            {
+                int section = CHUNK_SECTION_INDEX(sx, sy, sz);
+                
+                for (layer = 0; layer < BLOCK_LAYER_COUNT; ++layer)
+                {
+                    build->sectionStarts[layer][section] = build->faceCounts[layer];
+                }
+                
+                if (dirty & ((uint64_t)1 << section))
+                {
+                    _Topologize_Section(chunk, types, solid, neighbors, sx, sy, sz, build);
+                    continue;
+                }
+                
+                for (layer = 0; layer < BLOCK_LAYER_COUNT; ++layer)
+                {
+                    int start = previous->sectionStarts[layer][section];
+                    int count = previous->sectionStarts[layer][section + 1] - start;
+                    
+                    memcpy(build->faces[layer] + build->faceCounts[layer], previous->faces + start, sizeof(Face_t) * count);
+                    build->faceCounts[layer] += count;
+                }
+            }
+        }
+    }
+    
+    for (layer = 0; layer < BLOCK_LAYER_COUNT; ++layer)
+    {
+        build->sectionStarts[layer][CHUNK_SECTION_COUNT] = build->faceCounts[layer];
+    }
+}
+
+/* range of blocks along one axis of a neighbor at offset 0, 1 or 2 in the 3x3x3 block around a chunk
+ that lies within thickness blocks of the chunk */
+static void _Topologize_BorderRange(int offset, int thickness, int* min, int* max)
+{
+    *min = (offset == 0) ? CHUNK_SIZE - thickness : 0;
+    *max = (offset == 2) ? thickness : CHUNK_SIZE;
+}
+
+/* hashes the blocks or the light in a box of a chunk, or just that the chunk is missing */
+static uint64_t _Topologize_HashBorder(uint64_t key, const Chunk_t* chunk, const int offset[3], int thickness, int light)
+{
+    int present = (chunk != NULL);
+    key = MeshCache_Hash(key, &present, sizeof(present));
+    
+    if (!chunk) return key;
+    
+    int min[3];
+    int max[3];
+    
+    int axis;
+    for (axis = 0; axis < 3; ++axis)
+    {
+        _Topologize_BorderRange(offset[axis], thickness, min + axis, max + axis);
+    }
+    
+    unsigned char buffer[CHUNK_SIZE * CHUNK_SIZE * CHUNK_SIZE / 2];
+    int count = 0;
+    
+    int x, y, z;
+    for (x = min[0]; x < max[0]; ++x)
+    {
+        for (y = min[1]; y < max[1]; ++y)
+        {
+            for (z = min[2]; z < max[2]; ++z)
+            {
+                if (light)
+                {
+                    buffer[count++] = (Chunk_GetLight(chunk, LIGHT_SKY, x, y, z) << 4) | Chunk_GetLight(chunk, LIGHT_BLOCK, x, y, z);
+                }
+                else
+                {
+                    buffer[count++] = chunk->blocks[x][y][z].type;
+                }
+            }
+        }
+    }
+    
+    return MeshCache_Hash(key, buffer, count);
+}
+
+/* everything a mesh is built from, chunks with the same key get the same mesh.
+ around should already have the chunks the mesh ignores removed */
+static uint64_t _Topologize_MeshKey(const Chunk_t* chunk, const Chunk_t* around[3][3][3], const Chunk_t* const neighbors[6])
+{
+    uint64_t key = MeshCache_Hash(MESH_HASH_SEED, &chunk->lod, sizeof(chunk->lod));
+    key = MeshCache_Hash(key, chunk->blocks, sizeof(chunk->blocks));
+    key = MeshCache_Hash(key, chunk->light, sizeof(chunk->light));
+    
+    int f;
+    for (f = 0; f < CHUNK_FACE_COUNT; ++f)
+    {
+        int offset[3] = {1, 1, 1};
+        offset[f / 2] = (f & 1) ? 2 : 0;
+        
+        /* faces are lit by the block just past them */
+        key = _Topologize_HashBorder(key, neighbors[f], offset, 1, 1);
+        
+        /* coarse faces are culled against the cells past them, when the neighbor is at the same level */
+        if (chunk->lod > 0)
+        {
+            const Chunk_t* neighbor = (neighbors[f] && neighbors[f]->lod == chunk->lod) ? neighbors[f] : NULL;
+            key = _Topologize_HashBorder(key, neighbor, offset, 1 << chunk->lod, 0);
+        }
+    }
+    
+    /* full meshes are culled and occluded by the one block border all the way around */
+    if (chunk->lod == 0)
+    {
+        int offset[3];
+        for (offset[0] = 0; offset[0] < 3; ++offset[0])
+        {
+            for (offset[1] = 0; offset[1] < 3; ++offset[1])
+            {
+                for (offset[2] = 0; offset[2] < 3; ++offset[2])
+                {
+                    if (offset[0] == 1 && offset[1] == 1 && offset[2] == 1) continue;
+                    
+                    key = _Topologize_HashBorder(key, around[offset[0]][offset[1]][offset[2]], offset, 1, 0);
+                }
+            }
+        }
+    }
+    
+    return key;
+}
+
+/* shared by every chunk, created on the main thread the first time the world is meshed */
+static MeshCache_t _meshCache;
+static int _meshCacheReady = 0;
+
+static void _Topologize_Chunk(World_t* world, Chunk_t* chunk, MeshBuild_t* scratch)
+{
+    /* the 3x3x3 block of chunks centered on this one.
+     looked up through the chunk tree since scanning every chunk grows with the view distance */
+    const Chunk_t* around[3][3][3];
+    
+    int dx, dy, dz;
+    for (dx = 0; dx < 3; ++dx)
+    {
+        for (dy = 0; dy < 3; ++dy)
+        {
+            for (dz = 0; dz < 3; ++dz)
+            {
+                int index = Octree_Find(&world->chunkTree, chunk->x + dx - 1, chunk->y + dy - 1, chunk->z + dz - 1);
+                around[dx][dy][dz] = (index >= 0) ? world->chunks + index : NULL;
+            }
+        }
+    }
+    
+    const Chunk_t* neighbors[6];
+    neighbors[0] = around[0][1][1];
+    neighbors[1] = around[2][1][1];
+    neighbors[2] = around[1][0][1];
+    neighbors[3] = around[1][2][1];
+    neighbors[4] = around[1][1][0];
+    neighbors[5] = around[1][1][2];
+    
+    if (chunk->lod == 0)
+    {
+        /* coarser neighbors don't match these blocks, so faces against them are kept to close the seam */
+        for (dx = 0; dx < 3; ++dx)
+        {
+            for (dy = 0; dy < 3; ++dy)
+            {
+                for (dz = 0; dz < 3; ++dz)
+                {
+                    if (around[dx][dy][dz] && around[dx][dy][dz]->lod != 0) around[dx][dy][dz] = NULL;
+                }
+            }
+        }
+    }
+    
+    uint64_t key = _Topologize_MeshKey(chunk, around, neighbors);
+    Mesh_t* mesh = MeshCache_Acquire(&_meshCache, key);
+    
+    if (mesh)
+    {
+        memcpy(chunk->faceLinks, mesh->faceLinks, sizeof(chunk->faceLinks));
+        memcpy(chunk->solidLayers, mesh->solidLayers, sizeof(chunk->solidLayers));
+    }
+    else
+    {
+        int layer;
+        for (layer = 0; layer < BLOCK_LAYER_COUNT; ++layer)
+        {
+            scratch->faceCounts[layer] = 0;
+        }
+        
+        if (chunk->lod > 0)
+        {
+            _Topologize_ChunkLod(chunk, neighbors, scratch);
+        }
+        else
+        {
+            /* only sections near changed blocks are rebuilt, the rest of the old mesh still matches */
+            const Mesh_t* previous = chunk->mesh;
+            uint64_t dirty = chunk->dirtySections;
+            
+            if (!previous || previous->lod != 0) dirty = CHUNK_SECTIONS_ALL;
+            
+            _Topologize_ChunkFull(chunk, around, neighbors, dirty, previous, scratch);
+        }
+        
+        Visibility_LinkChunk(chunk);
+        Occlusion_FindSolidLayers(chunk);
+        
+        mesh = MeshCache_Insert(&_meshCache, key, chunk->lod, scratch, chunk->lod == 0, chunk);
+    }
+    
+    /* translucent faces are sorted again for the new mesh */
+    if (mesh != chunk->mesh) chunk->translucentOrder.mesh = NULL;
+    
+    MeshCache_Release(&_meshCache, chunk->mesh);
+    chunk->mesh = mesh;
+    chunk->dirtySections = 0;
+}
+
+typedef struct
+{
+    World_t* world;
+    Chunk_t** chunks;
+} TopologizeJob_t;
+
+/* runs on job workers - each chunk only writes itself and reads its neighbors */
+static void _Topologize_Job(void* data, int begin, int end)
+{
+    TopologizeJob_t* job = data;
+    
+    /* each worker keeps its own buffer to build meshes in before they are copied into the cache */
+    static _Thread_local MeshBuild_t* scratch = NULL;
+    
+    if (!scratch)
+    {
+        scratch = malloc(sizeof(MeshBuild_t));
+        assert(scratch);
+        
+        int layer;
+        for (layer = 0; layer < BLOCK_LAYER_COUNT; ++layer)
+        {
+            scratch->faces[layer] = malloc(sizeof(Face_t) * MESH_MAX_FACES);
+            assert(scratch->faces[layer]);
+        }
+    }
+    
+    int i;
+    for (i = begin; i < end; ++i)
+    {
+        _Topologize_Chunk(job->world, job->chunks[i], scratch);
+    }
+}
+
+static int _Topologize_LodForDistance(float distance)
+{
+    int lod = 0;
+    float limit = TOPOLOGY_LOD_DISTANCE;
+    
+    while (lod < TOPOLOGY_LOD_COUNT - 1 && distance > limit)
+    {
+        ++lod;
+        limit *= 2.0f;
+    }
+    
+    return lod;
+}
+
+/* a chunk only changes level once it is half a chunk past the boundary,
+ so moving back and forth across it doesn't keep remeshing */
+static int _Topologize_ChooseLod(const Chunk_t* chunk, const Cam_t* cam)
+{
+    float distance = Vec3_Dist(chunk->boundingSphere.position, cam->position);
+    
+    int lod = _Topologize_LodForDistance(distance);
+    
+    if (lod > chunk->lod) lod = _Topologize_LodForDistance(distance - CHUNK_SIZE / 2);
+    else if (lod < chunk->lod) lod = _Topologize_LodForDistance(distance + CHUNK_SIZE / 2);
+    
+    return lod;
+}
+
+typedef struct
+{
+    int index;
+    int lod;
+    
+    /* needed meshing anyway, so the change is free */
+    int wasDirty;
+} LodChange_t;
+
+void Topologize_World(World_t* world, const Cam_t* cam)
+{
+    if (!_meshCacheReady)
+    {
+        MeshCache_Init(&_meshCache, TOPOLOGY_MESH_CACHE_BYTES);
+        _meshCacheReady = 1;
+    }
+    
+    if (world->visibleCount == 0) return;
+    
+    Chunk_t** dirty = malloc(sizeof(Chunk_t*) * world->visibleCount);
+    int dirtyCount = 0;
+    
+    /* decided before any neighbors are marked so one change can't ripple through the rest */
+    LodChange_t* changes = malloc(sizeof(LodChange_t) * world->visibleCount);
+    int changeCount = 0;
+    
+    int i;
+    for (i = 0; i < world->visibleCount; ++i)
+    {
+        Chunk_t* chunk = &world->chunks[world->visibleChunks[i]];
+        
+        int lod = _Topologize_ChooseLod(chunk, cam);
+        if (lod == chunk->lod) continue;
+        
+        LodChange_t* change = changes + changeCount++;
+        change->index = world->visibleChunks[i];
+        change->lod = lod;
+        change->wasDirty = (chunk->dirtySections != 0);
+    }
+    
+    int lodRebuilds = 0;
+    
+    for (i = 0; i < changeCount; ++i)
+    {
+        const LodChange_t* change = changes + i;
+        Chunk_t* chunk = &world->chunks[change->index];
+        
+        /* chunks that only changed level wait their turn and keep drawing their old mesh until then */
+        if (!change->wasDirty)
+        {
+            if (lodRebuilds == TOPOLOGY_MAX_LOD_REBUILDS) continue;
+            ++lodRebuilds;
+        }
+        
+        chunk->lod = change->lod;
+        chunk->dirtySections = CHUNK_SECTIONS_ALL;
+        
+        /* neighbors decide which border faces to keep by comparing levels,
+         and full detail ones on the edges and corners take ambient occlusion from it too */
+        int dx, dy, dz;
+        for (dx = -1; dx <= 1; ++dx)
+        {
+            for (dy = -1; dy <= 1; ++dy)
+            {
+                for (dz = -1; dz <= 1; ++dz)
+                {
+                    if (dx == 0 && dy == 0 && dz == 0) continue;
+                    
+                    int index = Octree_Find(&world->chunkTree, chunk->x + dx, chunk->y + dy, chunk->z + dz);
+                    if (index >= 0) world->chunks[index].dirtySections = CHUNK_SECTIONS_ALL;
                 }
             }
-            chunk->dirtyCache = 0;
         }
     }
-}
\ No newline at end of file
+    
+    free(changes);
+    
+    for (i = 0; i < world->visibleCount; ++i)
+    {
+        Chunk_t* chunk = &world->chunks[world->visibleChunks[i]];
+        
+        if (chunk->dirtySections)
+        {
+            dirty[dirtyCount++] = chunk;
+        }
+    }
+    
+    if (dirtyCount == 0)
+    {
+        free(dirty);
+        return;
+    }
+    
+    TopologizeJob_t job = {world, dirty};
+    Job_ParallelFor(_Topologize_Job, &job, dirtyCount, 1);
+    free(dirty);
+}
+
+typedef struct
+{
+    float distance;
+    unsigned short face;
+} FaceDistance_t;
+
+/* farthest first */
+static int _Topologize_CompareFaces(const void* a, const void* b)
+{
+    float da = ((const FaceDistance_t*)a)->distance;
+    float db = ((const FaceDistance_t*)b)->distance;
+    return (da < db) - (da > db);
+}
+
+/* only touched on the main thread */
+static FaceDistance_t _faceDistances[MESH_MAX_FACES];
+
+/* orders a chunk's translucent faces back to front from the center of the camera's block.
+ a new mesh is sorted from scratch, after that the last order is nearly right
+ for a neighboring cell so an insertion sort over it only moves the faces that swapped */
+static void _Topologize_SortChunk(Chunk_t* chunk, const int cell[3])
+{
+    FaceOrder_t* order = &chunk->translucentOrder;
+    const Mesh_t* mesh = chunk->mesh;
+    
+    int first = mesh->layerStarts[BLOCK_LAYER_TRANSLUCENT];
+    int count = mesh->layerStarts[BLOCK_LAYER_TRANSLUCENT + 1] - first;
+    
+    int fresh = (order->mesh != mesh);
+    
+    if (!fresh && order->cell[0] == cell[0] && order->cell[1] == cell[1] && order->cell[2] == cell[2]) return;
+    
+    if (fresh && count > order->capacity)
+    {
+        order->capacity = count;
+        order->order = realloc(order->order, sizeof(unsigned short) * count);
+        order->indices = realloc(order->indices, sizeof(unsigned short) * count * 4);
+        assert(order->order && order->indices);
+    }
+    
+    /* face centers are the sum of four corners, so the eye is scaled by four to match */
+    float eye[3];
+    
+    int axis;
+    for (axis = 0; axis < 3; ++axis)
+    {
+        eye[axis] = (cell[axis] + 0.5f - chunk->worldPosition.data[axis]) * 4.0f;
+    }
+    
+    const Face_t* faces = mesh->faces + first;
+    
+    int i;
+    for (i = 0; i < count; ++i)
+    {
+        int face = fresh ? i : order->order[i];
+        const Vert_t* verts = faces[face].verts;
+        
+        float dx = verts[0].x + verts[1].x + verts[2].x + verts[3].x - eye[0];
+        float dy = verts[0].y + verts[1].y + verts[2].y + verts[3].y - eye[1];
+        float dz = verts[0].z + verts[1].z + verts[2].z + verts[3].z - eye[2];
+        
+        _faceDistances[i].distance = dx * dx + dy * dy + dz * dz;
+        _faceDistances[i].face = face;
+    }
+    
+    if (fresh)
+    {
+        qsort(_faceDistances, count, sizeof(FaceDistance_t), _Topologize_CompareFaces);
+    }
+    else
+    {
+        for (i = 1; i < count; ++i)
+        {
+            FaceDistance_t entry = _faceDistances[i];
+            
+            int j = i;
+            while (j > 0 && _faceDistances[j - 1].distance < entry.distance)
+            {
+                _faceDistances[j] = _faceDistances[j - 1];
+                --j;
+            }
+            _faceDistances[j] = entry;
+        }
+    }
+    
+    for (i = 0; i < count; ++i)
+    {
+        int face = _faceDistances[i].face;
+        order->order[i] = face;
+        
+        int corner;
+        for (corner = 0; corner < 4; ++corner)
+        {
+            order->indices[i * 4 + corner] = face * 4 + corner;
+        }
+    }
+    
+    order->mesh = mesh;
+    order->cell[0] = cell[0];
+    order->cell[1] = cell[1];
+    order->cell[2] = cell[2];
+}
+
+typedef struct
+{
+    float distance;
+    int index;
+} ChunkDistance_t;
+
+static int _Topologize_CompareChunks(const void* a, const void* b)
+{
+    float da = ((const ChunkDistance_t*)a)->distance;
+    float db = ((const ChunkDistance_t*)b)->distance;
+    return (da < db) - (da > db);
+}
+
+static ChunkDistance_t* _chunkDistances;
+static int _chunkDistanceCapacity;
+
+void Topologize_SortTranslucent(World_t* world, const Cam_t* cam)
+{
+    world->translucentCount = 0;
+    
+    if (world->visibleCount > _chunkDistanceCapacity)
+    {
+        _chunkDistanceCapacity = world->visibleCount;
+        _chunkDistances = realloc(_chunkDistances, sizeof(ChunkDistance_t) * _chunkDistanceCapacity);
+        assert(_chunkDistances);
+    }
+    
+    int cell[3] = {
+        (int)floorf(cam->position.x),
+        (int)floorf(cam->position.y),
+        (int)floorf(cam->position.z)
+    };
+    
+    int count = 0;
+    
+    int i;
+    for (i = 0; i < world->visibleCount; ++i)
+    {
+        Chunk_t* chunk = &world->chunks[world->visibleChunks[i]];
+        const Mesh_t* mesh = chunk->mesh;
+        
+        if (!mesh || mesh->layerStarts[BLOCK_LAYER_TRANSLUCENT] == mesh->layerStarts[BLOCK_LAYER_TRANSLUCENT + 1]) continue;
+        
+        _Topologize_SortChunk(chunk, cell);
+        
+        ChunkDistance_t* entry = _chunkDistances + count++;
+        entry->distance = Vec3_Dist(chunk->boundingSphere.position, cam->position);
+        entry->index = world->visibleChunks[i];
+    }
+    
+    /* only chunks with translucent faces, usually a handful, so sorting them every frame is cheap */
+    qsort(_chunkDistances, count, sizeof(ChunkDistance_t), _Topologize_CompareChunks);
+    
+    for (i = 0; i < count; ++i)
+    {
+        world->translucentChunks[i] = _chunkDistances[i].index;
+    }
+    world->translucentCount = count;
+}
@@ -7,6 +7,25 @@
 #include "cam.h"
 #include "world.h"
 
-extern void Topologize_World(Cam_t* cam, World_t* world);
+/* number of detail levels, each one merges 2x2x2 cells of the level before */
+#define TOPOLOGY_LOD_COUNT 4
+
+/* distance from the camera where chunks drop to lod 1, doubling for each level after */
+#define TOPOLOGY_LOD_DISTANCE 96.0f
+
+/* most chunks remeshed in a frame only because their distance from the camera changed level */
+#define TOPOLOGY_MAX_LOD_REBUILDS 16
+
+/* meshes no chunk is using are kept for chunks that go back to the same blocks until they take up this much */
+#define TOPOLOGY_MESH_CACHE_BYTES (32 * 1024 * 1024)
+
+/* picks a level of detail for each chunk in world->visibleChunks by its distance from the camera,
+ then remeshes the ones that are dirty */
+extern void Topologize_World(World_t* world, const Cam_t* cam);
+
+/* fills world->translucentChunks with the visible chunks that have translucent faces, farthest first,
+ and orders the faces within each back to front. faces are only sorted again
+ when a chunk's mesh changes or the camera moves into another block */
+extern void Topologize_SortTranslucent(World_t* world, const Cam_t* cam);
 
 #endif
@@ -3,8 +3,55 @@
 
 void Mat4_Mult(const Mat4_t* a, const Mat4_t* b, Mat4_t* dest)
 {
-    static Mat4_t temp;
+    /* every column of the result is the columns of a weighted by a column of b.
+     results are kept aside until both inputs have been read, dest may be one of them */
     int i;
+#if defined(VEC_MATH_SSE)
+    const __m128 a0 = _mm_loadu_ps(a->m);
+    const __m128 a1 = _mm_loadu_ps(a->m + 4);
+    const __m128 a2 = _mm_loadu_ps(a->m + 8);
+    const __m128 a3 = _mm_loadu_ps(a->m + 12);
+    
+    __m128 columns[4];
+    for (i = 0; i < 4; ++i)
+    {
+        const float* weights = b->m + i * 4;
+        
+        __m128 sum = _mm_mul_ps(a0, _mm_set1_ps(weights[0]));
+        sum = _mm_add_ps(sum, _mm_mul_ps(a1, _mm_set1_ps(weights[1])));
+        sum = _mm_add_ps(sum, _mm_mul_ps(a2, _mm_set1_ps(weights[2])));
+        sum = _mm_add_ps(sum, _mm_mul_ps(a3, _mm_set1_ps(weights[3])));
+        columns[i] = sum;
+    }
+    
+    for (i = 0; i < 4; ++i)
+    {
+        _mm_storeu_ps(dest->m + i * 4, columns[i]);
+    }
+#elif defined(VEC_MATH_NEON)
+    const float32x4_t a0 = vld1q_f32(a->m);
+    const float32x4_t a1 = vld1q_f32(a->m + 4);
+    const float32x4_t a2 = vld1q_f32(a->m + 8);
+    const float32x4_t a3 = vld1q_f32(a->m + 12);
+    
+    float32x4_t columns[4];
+    for (i = 0; i < 4; ++i)
+    {
+        const float* weights = b->m + i * 4;
+        
+        float32x4_t sum = vmulq_n_f32(a0, weights[0]);
+        sum = vaddq_f32(sum, vmulq_n_f32(a1, weights[1]));
+        sum = vaddq_f32(sum, vmulq_n_f32(a2, weights[2]));
+        sum = vaddq_f32(sum, vmulq_n_f32(a3, weights[3]));
+        columns[i] = sum;
+    }
+    
+    for (i = 0; i < 4; ++i)
+    {
+        vst1q_f32(dest->m + i * 4, columns[i]);
+    }
+#else
+    Mat4_t temp;
     int j;
     int k;
     float n;
@@ -12,8 +59,8 @@ void Mat4_Mult(const Mat4_t* a, const Mat4_t* b, Mat4_t* dest)
     {
         for (j = 0; j < 4; ++j)
         {
-            n = 0;
-            for (k = 0; k < 4; ++k)
+            n = Mat4_Get(b, i, 0) * Mat4_Get(a, 0, j);
+            for (k = 1; k < 4; ++k)
             {
                 n += Mat4_Get(b, i, k) * Mat4_Get(a, k, j);
             }
@@ -22,6 +69,95 @@ void Mat4_Mult(const Mat4_t* a, const Mat4_t* b, Mat4_t* dest)
     }
     
     Mat4_Copy(dest, &temp);
+#endif
+}
+
+void Mat4_TransformVec4s(const Mat4_t* mat, const Vec4_t* src, Vec4_t* dest, int count)
+{
+    int i;
+#if defined(VEC_MATH_SSE)
+    const __m128 c0 = _mm_loadu_ps(mat->m);
+    const __m128 c1 = _mm_loadu_ps(mat->m + 4);
+    const __m128 c2 = _mm_loadu_ps(mat->m + 8);
+    const __m128 c3 = _mm_loadu_ps(mat->m + 12);
+    
+    for (i = 0; i < count; ++i)
+    {
+        __m128 v = _mm_loadu_ps(src[i].data);
+        
+        __m128 sum = _mm_mul_ps(c0, _mm_shuffle_ps(v, v, _MM_SHUFFLE(0, 0, 0, 0)));
+        sum = _mm_add_ps(sum, _mm_mul_ps(c1, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 1, 1, 1))));
+        sum = _mm_add_ps(sum, _mm_mul_ps(c2, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 2, 2, 2))));
+        sum = _mm_add_ps(sum, _mm_mul_ps(c3, _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 3, 3, 3))));
+        _mm_storeu_ps(dest[i].data, sum);
+    }
+#elif defined(VEC_MATH_NEON)
+    const float32x4_t c0 = vld1q_f32(mat->m);
+    const float32x4_t c1 = vld1q_f32(mat->m + 4);
+    const float32x4_t c2 = vld1q_f32(mat->m + 8);
+    const float32x4_t c3 = vld1q_f32(mat->m + 12);
+    
+    for (i = 0; i < count; ++i)
+    {
+        float32x4_t sum = vmulq_n_f32(c0, src[i].x);
+        sum = vaddq_f32(sum, vmulq_n_f32(c1, src[i].y));
+        sum = vaddq_f32(sum, vmulq_n_f32(c2, src[i].z));
+        sum = vaddq_f32(sum, vmulq_n_f32(c3, src[i].w));
+        vst1q_f32(dest[i].data, sum);
+    }
+#else
+    for (i = 0; i < count; ++i)
+    {
+        dest[i] = Mat4_MultVec4(mat, src[i]);
+    }
+#endif
+}
+
+void Mat4_TransformVec3s(const Mat4_t* mat, const Vec3_t* src, Vec3_t* dest, int count)
+{
+    int i;
+    for (i = 0; i < count; ++i)
+    {
+        dest[i] = Mat4_MultVec3(mat, src[i]);
+    }
+}
+
+void Mat4_TransformPoints(const Mat4_t* mat,
+                          const float* x,
+                          const float* y,
+                          const float* z,
+                          float* destX,
+                          float* destY,
+                          float* destZ,
+                          int count)
+{
+    /* VEC_LANES points at a time, summed in the order Mat4_MultVec3 does */
+    VecLanes_t m[12];
+    
+    int i;
+    for (i = 0; i < 12; ++i)
+    {
+        m[i] = VecLanes_Set(mat->m[(i / 3) * 4 + i % 3]);
+    }
+    
+    for (i = 0; i + VEC_LANES <= count; i += VEC_LANES)
+    {
+        VecLanes_t px = VecLanes_Load(x + i);
+        VecLanes_t py = VecLanes_Load(y + i);
+        VecLanes_t pz = VecLanes_Load(z + i);
+        
+        VecLanes_Store(destX + i, VecLanes_Add(VecLanes_Add(VecLanes_Add(VecLanes_Mult(px, m[0]), VecLanes_Mult(py, m[3])), VecLanes_Mult(pz, m[6])), m[9]));
+        VecLanes_Store(destY + i, VecLanes_Add(VecLanes_Add(VecLanes_Add(VecLanes_Mult(px, m[1]), VecLanes_Mult(py, m[4])), VecLanes_Mult(pz, m[7])), m[10]));
+        VecLanes_Store(destZ + i, VecLanes_Add(VecLanes_Add(VecLanes_Add(VecLanes_Mult(px, m[2]), VecLanes_Mult(py, m[5])), VecLanes_Mult(pz, m[8])), m[11]));
+    }
+    
+    for (; i < count; ++i)
+    {
+        Vec3_t point = Mat4_MultVec3(mat, Vec3_Create(x[i], y[i], z[i]));
+        destX[i] = point.x;
+        destY[i] = point.y;
+        destZ[i] = point.z;
+    }
 }
 
 void Mat4_Transpose(Mat4_t* a)
@@ -272,3 +408,71 @@ Quat_t Quat_Slerp(Quat_t a, Quat_t b, float t)
     
 	return a;
 }
+
+void Quat_RotateVec3s(Quat_t a, const Vec3_t* src, Vec3_t* dest, int count)
+{
+    int i;
+#if defined(VEC_MATH_SSE) || defined(VEC_MATH_NEON)
+    QuatLanes_t quat = QuatLanes_Load(a.x, a.y, a.z, a.w);
+    QuatLanes_t conjugate = QuatLanes_Conjugate(quat);
+    
+    for (i = 0; i < count; ++i)
+    {
+        Vec3_t v = src[i];
+        dest[i] = QuatLanes_ToVec3(QuatLanes_Mult(quat, QuatLanes_Mult(QuatLanes_Load(v.x, v.y, v.z, 0.0f), conjugate)));
+    }
+#else
+    for (i = 0; i < count; ++i)
+    {
+        dest[i] = Quat_RotateVec3(a, src[i]);
+    }
+#endif
+}
+
+void Quat_RotatePoints(Quat_t a,
+                       const float* x,
+                       const float* y,
+                       const float* z,
+                       float* destX,
+                       float* destY,
+                       float* destZ,
+                       int count)
+{
+    /* the two products of Quat_RotateVec3 written out, one point per lane.
+     the terms are the same as Quat_Mult's, zero w included, so results match it exactly */
+    const VecLanes_t zero = VecLanes_Set(0.0f);
+    const VecLanes_t qx = VecLanes_Set(a.x);
+    const VecLanes_t qy = VecLanes_Set(a.y);
+    const VecLanes_t qz = VecLanes_Set(a.z);
+    const VecLanes_t qw = VecLanes_Set(a.w);
+    const VecLanes_t cx = VecLanes_Set(-a.x);
+    const VecLanes_t cy = VecLanes_Set(-a.y);
+    const VecLanes_t cz = VecLanes_Set(-a.z);
+    
+    int i;
+    for (i = 0; i + VEC_LANES <= count; i += VEC_LANES)
+    {
+        VecLanes_t vx = VecLanes_Load(x + i);
+        VecLanes_t vy = VecLanes_Load(y + i);
+        VecLanes_t vz = VecLanes_Load(z + i);
+        
+        /* v * conjugate(a) */
+        VecLanes_t tx = VecLanes_Sub(VecLanes_Add(VecLanes_Add(VecLanes_Mult(zero, cx), VecLanes_Mult(vx, qw)), VecLanes_Mult(vy, cz)), VecLanes_Mult(vz, cy));
+        VecLanes_t ty = VecLanes_Sub(VecLanes_Add(VecLanes_Add(VecLanes_Mult(zero, cy), VecLanes_Mult(vy, qw)), VecLanes_Mult(vz, cx)), VecLanes_Mult(vx, cz));
+        VecLanes_t tz = VecLanes_Sub(VecLanes_Add(VecLanes_Add(VecLanes_Mult(zero, cz), VecLanes_Mult(vz, qw)), VecLanes_Mult(vx, cy)), VecLanes_Mult(vy, cx));
+        VecLanes_t tw = VecLanes_Sub(VecLanes_Sub(VecLanes_Sub(VecLanes_Mult(zero, qw), VecLanes_Mult(vx, cx)), VecLanes_Mult(vy, cy)), VecLanes_Mult(vz, cz));
+        
+        /* a * that */
+        VecLanes_Store(destX + i, VecLanes_Sub(VecLanes_Add(VecLanes_Add(VecLanes_Mult(qw, tx), VecLanes_Mult(qx, tw)), VecLanes_Mult(qy, tz)), VecLanes_Mult(qz, ty)));
+        VecLanes_Store(destY + i, VecLanes_Sub(VecLanes_Add(VecLanes_Add(VecLanes_Mult(qw, ty), VecLanes_Mult(qy, tw)), VecLanes_Mult(qz, tx)), VecLanes_Mult(qx, tz)));
+        VecLanes_Store(destZ + i, VecLanes_Sub(VecLanes_Add(VecLanes_Add(VecLanes_Mult(qw, tz), VecLanes_Mult(qz, tw)), VecLanes_Mult(qx, ty)), VecLanes_Mult(qy, tx)));
+    }
+    
+    for (; i < count; ++i)
+    {
+        Vec3_t point = Quat_RotateVec3(a, Vec3_Create(x[i], y[i], z[i]));
+        destX[i] = point.x;
+        destY[i] = point.y;
+        destZ[i] = point.z;
+    }
+}
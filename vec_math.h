@@ -8,6 +8,17 @@
 
 /* Common 3D Math */
 
+/* the simd backend is picked at compile time from what the target supports, VEC_MATH_SCALAR forces plain c.
+ the simd paths add and multiply in the same order as the scalar ones so they give the same results,
+ as long as the compiler isn't allowed to fuse multiplies and adds in the scalar code */
+#if !defined(VEC_MATH_SCALAR) && defined(__SSE__)
+#define VEC_MATH_SSE 1
+#include <xmmintrin.h>
+#elif !defined(VEC_MATH_SCALAR) && defined(__ARM_NEON) && defined(__aarch64__)
+#define VEC_MATH_NEON 1
+#include <arm_neon.h>
+#endif
+
 #define DEG_TO_RAD(X) ((X * M_PI) / 180.0f)
 #define RAD_TO_DEG(X) ((X * 180.0f) / M_PI)
 
@@ -392,12 +403,160 @@ static inline Vec4_t Vec4_Sub(Vec4_t a, Vec4_t b)
     return vec;
 }
 
+static inline Vec4_t Vec4_Scale(Vec4_t a, float scale)
+{
+    Vec4_t vec;
+    vec.x = a.x * scale;
+    vec.y = a.y * scale;
+    vec.z = a.z * scale;
+    vec.w = a.w * scale;
+    return vec;
+}
+
+/* as many floats as the backend works on at once, for loops over arrays stored by axis.
+ VEC_LANES is 4 with simd and 1 without, the same loop serves both */
+#if defined(VEC_MATH_SSE)
+#define VEC_LANES 4
+typedef __m128 VecLanes_t;
+
+static inline VecLanes_t VecLanes_Set(float a)
+{
+    return _mm_set1_ps(a);
+}
+
+static inline VecLanes_t VecLanes_Load(const float* src)
+{
+    return _mm_loadu_ps(src);
+}
+
+static inline void VecLanes_Store(float* dest, VecLanes_t a)
+{
+    _mm_storeu_ps(dest, a);
+}
+
+static inline VecLanes_t VecLanes_Add(VecLanes_t a, VecLanes_t b)
+{
+    return _mm_add_ps(a, b);
+}
+
+static inline VecLanes_t VecLanes_Sub(VecLanes_t a, VecLanes_t b)
+{
+    return _mm_sub_ps(a, b);
+}
+
+static inline VecLanes_t VecLanes_Mult(VecLanes_t a, VecLanes_t b)
+{
+    return _mm_mul_ps(a, b);
+}
+
+/* one bit per lane, set where a >= b */
+static inline int VecLanes_GreaterEqual(VecLanes_t a, VecLanes_t b)
+{
+    return _mm_movemask_ps(_mm_cmpge_ps(a, b));
+}
+#elif defined(VEC_MATH_NEON)
+#define VEC_LANES 4
+typedef float32x4_t VecLanes_t;
+
+static inline VecLanes_t VecLanes_Set(float a)
+{
+    return vdupq_n_f32(a);
+}
+
+static inline VecLanes_t VecLanes_Load(const float* src)
+{
+    return vld1q_f32(src);
+}
+
+static inline void VecLanes_Store(float* dest, VecLanes_t a)
+{
+    vst1q_f32(dest, a);
+}
+
+static inline VecLanes_t VecLanes_Add(VecLanes_t a, VecLanes_t b)
+{
+    return vaddq_f32(a, b);
+}
+
+static inline VecLanes_t VecLanes_Sub(VecLanes_t a, VecLanes_t b)
+{
+    return vsubq_f32(a, b);
+}
+
+static inline VecLanes_t VecLanes_Mult(VecLanes_t a, VecLanes_t b)
+{
+    return vmulq_f32(a, b);
+}
+
+static inline int VecLanes_GreaterEqual(VecLanes_t a, VecLanes_t b)
+{
+    const uint32x4_t bits = { 1, 2, 4, 8 };
+    return (int)vaddvq_u32(vandq_u32(vcgeq_f32(a, b), bits));
+}
+#else
+#define VEC_LANES 1
+typedef float VecLanes_t;
+
+static inline VecLanes_t VecLanes_Set(float a)
+{
+    return a;
+}
+
+static inline VecLanes_t VecLanes_Load(const float* src)
+{
+    return *src;
+}
+
+static inline void VecLanes_Store(float* dest, VecLanes_t a)
+{
+    *dest = a;
+}
+
+static inline VecLanes_t VecLanes_Add(VecLanes_t a, VecLanes_t b)
+{
+    return a + b;
+}
+
+static inline VecLanes_t VecLanes_Sub(VecLanes_t a, VecLanes_t b)
+{
+    return a - b;
+}
+
+static inline VecLanes_t VecLanes_Mult(VecLanes_t a, VecLanes_t b)
+{
+    return a * b;
+}
+
+static inline int VecLanes_GreaterEqual(VecLanes_t a, VecLanes_t b)
+{
+    return a >= b;
+}
+#endif
+
 typedef struct
 {
     float m[16];
 } Mat4_t;
 
+/* dest = a * b, dest may be either of them. safe to call from any thread */
 extern void Mat4_Mult(const Mat4_t* a, const Mat4_t* b, Mat4_t* dest);
+
+/* dest[i] = mat * src[i] for count vectors, dest may be src */
+extern void Mat4_TransformVec4s(const Mat4_t* mat, const Vec4_t* src, Vec4_t* dest, int count);
+
+/* Mat4_MultVec3 over count points, dest may be src */
+extern void Mat4_TransformVec3s(const Mat4_t* mat, const Vec3_t* src, Vec3_t* dest, int count);
+
+/* the same for points stored by axis, each dest array may be its src array */
+extern void Mat4_TransformPoints(const Mat4_t* mat,
+                                 const float* x,
+                                 const float* y,
+                                 const float* z,
+                                 float* destX,
+                                 float* destY,
+                                 float* destZ,
+                                 int count);
+
 extern void Mat4_Transpose(Mat4_t* a);
 extern float Mat4_Det(const Mat4_t* matrix);
 extern void Mat4_Inverse(const Mat4_t* matrix, Mat4_t* ret);
@@ -449,10 +608,24 @@ static inline Vec3_t Mat4_MultVec3(const Mat4_t* mat, Vec3_t a)
 static inline Vec4_t Mat4_MultVec4(const Mat4_t* mat, Vec4_t a)
 {
     Vec4_t vec;
+#if defined(VEC_MATH_SSE)
+    __m128 sum = _mm_mul_ps(_mm_loadu_ps(mat->m), _mm_set1_ps(a.x));
+    sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(mat->m + 4), _mm_set1_ps(a.y)));
+    sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(mat->m + 8), _mm_set1_ps(a.z)));
+    sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(mat->m + 12), _mm_set1_ps(a.w)));
+    _mm_storeu_ps(vec.data, sum);
+#elif defined(VEC_MATH_NEON)
+    float32x4_t sum = vmulq_n_f32(vld1q_f32(mat->m), a.x);
+    sum = vaddq_f32(sum, vmulq_n_f32(vld1q_f32(mat->m + 4), a.y));
+    sum = vaddq_f32(sum, vmulq_n_f32(vld1q_f32(mat->m + 8), a.z));
+    sum = vaddq_f32(sum, vmulq_n_f32(vld1q_f32(mat->m + 12), a.w));
+    vst1q_f32(vec.data, sum);
+#else
     vec.x = (a.x * mat->m[0]) + (a.y * mat->m[4]) + (a.z * mat->m[8]) + (a.w * mat->m[12]);
     vec.y = (a.x * mat->m[1]) + (a.y * mat->m[5]) + (a.z * mat->m[9]) + (a.w * mat->m[13]);
     vec.z = (a.x * mat->m[2]) + (a.y * mat->m[6]) + (a.z * mat->m[10]) + (a.w * mat->m[14]);
     vec.w = (a.x * mat->m[3]) + (a.y * mat->m[7]) + (a.z * mat->m[11]) + (a.w * mat->m[15]);
+#endif
     return vec;
 }
 
@@ -520,6 +693,19 @@ extern Quat_t Quat_FromAngle(float angle, float x, float y, float z);
 extern void Quat_ToMatrix(Quat_t a, Mat4_t* dest);
 extern Quat_t Quat_Slerp(Quat_t a, Quat_t b, float t);
 
+/* Quat_RotateVec3 over count points, with the same results. dest may be src */
+extern void Quat_RotateVec3s(Quat_t a, const Vec3_t* src, Vec3_t* dest, int count);
+
+/* the same for points stored by axis, each dest array may be its src array */
+extern void Quat_RotatePoints(Quat_t a,
+                              const float* x,
+                              const float* y,
+                              const float* z,
+                              float* destX,
+                              float* destY,
+                              float* destZ,
+                              int count);
+
 
 static inline Quat_t Quat_Create(float x, float y, float z, float w)
 {
@@ -601,18 +787,117 @@ static inline Quat_t Quat_Negate(Quat_t a)
     return q;
 }
 
+#if defined(VEC_MATH_SSE) || defined(VEC_MATH_NEON)
+/* the product of two quaternions held in registers with x, y, z, w in lanes 0 to 3.
+ each lane sums the same four products as the scalar Quat_Mult, in the same order.
+ the products that are subtracted are negated first, which rounds the same */
+#if defined(VEC_MATH_SSE)
+typedef __m128 QuatLanes_t;
+
+static inline QuatLanes_t QuatLanes_Mult(QuatLanes_t a, QuatLanes_t b)
+{
+    const __m128 negateW = _mm_setr_ps(0.0f, 0.0f, 0.0f, -0.0f);
+    const __m128 negateAll = _mm_set1_ps(-0.0f);
+    
+    __m128 sum = _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 3, 3, 3)), b);
+    sum = _mm_add_ps(sum, _mm_xor_ps(_mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(0, 2, 1, 0)), _mm_shuffle_ps(b, b, _MM_SHUFFLE(0, 3, 3, 3))), negateW));
+    sum = _mm_add_ps(sum, _mm_xor_ps(_mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(1, 0, 2, 1)), _mm_shuffle_ps(b, b, _MM_SHUFFLE(1, 1, 0, 2))), negateW));
+    return _mm_add_ps(sum, _mm_xor_ps(_mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 1, 0, 2)), _mm_shuffle_ps(b, b, _MM_SHUFFLE(2, 0, 2, 1))), negateAll));
+}
+
+static inline QuatLanes_t QuatLanes_Load(float x, float y, float z, float w)
+{
+    return _mm_setr_ps(x, y, z, w);
+}
+
+static inline void QuatLanes_Store(float* dest, QuatLanes_t a)
+{
+    _mm_storeu_ps(dest, a);
+}
+
+static inline Vec3_t QuatLanes_ToVec3(QuatLanes_t a)
+{
+    return Vec3_Create(_mm_cvtss_f32(a), _mm_cvtss_f32(_mm_shuffle_ps(a, a, _MM_SHUFFLE(1, 1, 1, 1))), _mm_cvtss_f32(_mm_movehl_ps(a, a)));
+}
+
+static inline QuatLanes_t QuatLanes_Conjugate(QuatLanes_t a)
+{
+    return _mm_xor_ps(a, _mm_setr_ps(-0.0f, -0.0f, -0.0f, 0.0f));
+}
+#else
+typedef float32x4_t QuatLanes_t;
+
+static inline QuatLanes_t QuatLanes_Mult(QuatLanes_t a, QuatLanes_t b)
+{
+    const uint32x4_t negateW = { 0, 0, 0, 0x80000000u };
+    const uint32x4_t negateAll = vdupq_n_u32(0x80000000u);
+    
+    /* the rotations of x y z are extracts from x y z x with the last lane put right */
+    float32x4_t aW = vdupq_laneq_f32(a, 3);
+    float32x4_t aXYZX = vcopyq_laneq_f32(a, 3, a, 0);
+    float32x4_t aYZXY = vcopyq_laneq_f32(vextq_f32(aXYZX, aXYZX, 1), 3, a, 1);
+    float32x4_t aZXYZ = vcopyq_laneq_f32(vextq_f32(aYZXY, aYZXY, 1), 3, a, 2);
+    
+    float32x4_t bWWWX = vcopyq_laneq_f32(vdupq_laneq_f32(b, 3), 3, b, 0);
+    float32x4_t bXYZX = vcopyq_laneq_f32(b, 3, b, 0);
+    float32x4_t bYZXY = vcopyq_laneq_f32(vextq_f32(bXYZX, bXYZX, 1), 3, b, 1);
+    float32x4_t bZXYY = vextq_f32(bYZXY, bYZXY, 1);
+    float32x4_t bYZXZ = vcopyq_laneq_f32(bYZXY, 3, b, 2);
+    
+    float32x4_t sum = vmulq_f32(aW, b);
+    sum = vaddq_f32(sum, vreinterpretq_f32_u32(veorq_u32(vreinterpretq_u32_f32(vmulq_f32(aXYZX, bWWWX)), negateW)));
+    sum = vaddq_f32(sum, vreinterpretq_f32_u32(veorq_u32(vreinterpretq_u32_f32(vmulq_f32(aYZXY, bZXYY)), negateW)));
+    return vaddq_f32(sum, vreinterpretq_f32_u32(veorq_u32(vreinterpretq_u32_f32(vmulq_f32(aZXYZ, bYZXZ)), negateAll)));
+}
+
+static inline QuatLanes_t QuatLanes_Load(float x, float y, float z, float w)
+{
+    const float values[4] = { x, y, z, w };
+    return vld1q_f32(values);
+}
+
+static inline void QuatLanes_Store(float* dest, QuatLanes_t a)
+{
+    vst1q_f32(dest, a);
+}
+
+static inline Vec3_t QuatLanes_ToVec3(QuatLanes_t a)
+{
+    return Vec3_Create(vgetq_lane_f32(a, 0), vgetq_lane_f32(a, 1), vgetq_lane_f32(a, 2));
+}
+
+static inline QuatLanes_t QuatLanes_Conjugate(QuatLanes_t a)
+{
+    const uint32x4_t negateXYZ = { 0x80000000u, 0x80000000u, 0x80000000u, 0 };
+    return vreinterpretq_f32_u32(veorq_u32(vreinterpretq_u32_f32(a), negateXYZ));
+}
+#endif
+#endif
+
 static inline Quat_t Quat_Mult(Quat_t a, Quat_t b)
 {
     Quat_t vec;
+#if defined(VEC_MATH_SSE) || defined(VEC_MATH_NEON)
+    float lanes[4];
+    QuatLanes_Store(lanes, QuatLanes_Mult(QuatLanes_Load(a.x, a.y, a.z, a.w), QuatLanes_Load(b.x, b.y, b.z, b.w)));
+    vec = Quat_Create(lanes[0], lanes[1], lanes[2], lanes[3]);
+#else
 	vec.x = a.w * b.x + a.x * b.w + a.y * b.z - a.z * b.y;
 	vec.y = a.w * b.y + a.y * b.w + a.z * b.x - a.x * b.z;
 	vec.z = a.w * b.z + a.z * b.w + a.x * b.y - a.y * b.x;
 	vec.w = a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z;
+#endif
 	return vec;
 }
 
 static inline Vec3_t Quat_RotateVec3(Quat_t a, Vec3_t v)
 {
+#if defined(VEC_MATH_SSE) || defined(VEC_MATH_NEON)
+    /* a * v * conjugate(a) without leaving registers in between */
+    QuatLanes_t quat = QuatLanes_Load(a.x, a.y, a.z, a.w);
+    QuatLanes_t result = QuatLanes_Mult(quat, QuatLanes_Mult(QuatLanes_Load(v.x, v.y, v.z, 0.0f), QuatLanes_Conjugate(quat)));
+    return QuatLanes_ToVec3(result);
+#else
 	Quat_t vecQuat, resQuat;
     
 	vecQuat.x = v.x;
@@ -624,6 +909,7 @@ static inline Vec3_t Quat_RotateVec3(Quat_t a, Vec3_t v)
 	resQuat = Quat_Mult(a, resQuat);
 	
 	return Vec3_Create(resQuat.x, resQuat.y, resQuat.z);
+#endif
 }
 
 static inline float Quat_Dot(Quat_t a, Quat_t b)
@@ -0,0 +1,375 @@
+#include "visibility.h"
+#include "occlusion.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+static const int FaceSteps[CHUNK_FACE_COUNT][3] =
+{
+    {-1, 0, 0},
+    {1, 0, 0},
+    {0, -1, 0},
+    {0, 1, 0},
+    {0, 0, -1},
+    {0, 0, 1},
+};
+
+/* faces of the chunk a block touches */
+static int _Visibility_BlockFaces(int x, int y, int z)
+{
+    int faces = 0;
+    
+    if (x == 0) faces |= 1 << CHUNK_FACE_NEG_X;
+    if (x == CHUNK_SIZE - 1) faces |= 1 << CHUNK_FACE_POS_X;
+    if (y == 0) faces |= 1 << CHUNK_FACE_NEG_Y;
+    if (y == CHUNK_SIZE - 1) faces |= 1 << CHUNK_FACE_POS_Y;
+    if (z == 0) faces |= 1 << CHUNK_FACE_NEG_Z;
+    if (z == CHUNK_SIZE - 1) faces |= 1 << CHUNK_FACE_POS_Z;
+    
+    return faces;
+}
+
+void Visibility_LinkChunk(Chunk_t* chunk)
+{
+    int f;
+    
+    /* all air or all opaque don't need a flood */
+    if (chunk->blockCount == 0 || chunk->opaqueCount == CHUNK_VOLUME)
+    {
+        for (f = 0; f < CHUNK_FACE_COUNT; ++f)
+        {
+            chunk->faceLinks[f] = (chunk->blockCount == 0) ? CHUNK_FACES_ALL : 0;
+        }
+        return;
+    }
+    
+    for (f = 0; f < CHUNK_FACE_COUNT; ++f)
+    {
+        chunk->faceLinks[f] = 0;
+    }
+    
+    const Block_t* blocks = &chunk->blocks[0][0][0];
+    
+    unsigned char visited[CHUNK_VOLUME];
+    unsigned short stack[CHUNK_VOLUME];
+    
+    memset(visited, 0, sizeof(visited));
+    
+    int i;
+    for (i = 0; i < CHUNK_VOLUME; ++i)
+    {
+        if (visited[i] || Block_Opaque(blocks[i].type)) continue;
+        
+        /* flood one pocket of air or see through blocks and collect every face it touches */
+        int faces = 0;
+        int top = 0;
+        
+        stack[top++] = i;
+        visited[i] = 1;
+        
+        while (top > 0)
+        {
+            int index = stack[--top];
+            
+            int x = index / (CHUNK_SIZE * CHUNK_SIZE);
+            int y = (index / CHUNK_SIZE) % CHUNK_SIZE;
+            int z = index % CHUNK_SIZE;
+            
+            faces |= _Visibility_BlockFaces(x, y, z);
+            
+            for (f = 0; f < CHUNK_FACE_COUNT; ++f)
+            {
+                int nx = x + FaceSteps[f][0];
+                int ny = y + FaceSteps[f][1];
+                int nz = z + FaceSteps[f][2];
+                
+                if (nx < 0 || ny < 0 || nz < 0 ||
+                    nx >= CHUNK_SIZE || ny >= CHUNK_SIZE || nz >= CHUNK_SIZE) continue;
+                
+                int next = (nx * CHUNK_SIZE + ny) * CHUNK_SIZE + nz;
+                
+                if (visited[next] || Block_Opaque(blocks[next].type)) continue;
+                
+                visited[next] = 1;
+                stack[top++] = next;
+            }
+        }
+        
+        for (f = 0; f < CHUNK_FACE_COUNT; ++f)
+        {
+            if (faces & (1 << f)) chunk->faceLinks[f] |= faces;
+        }
+    }
+}
+
+typedef struct
+{
+    int x;
+    int y;
+    int z;
+    
+    /* chunk in the cell, -1 for open air */
+    int chunk;
+    
+    /* face of the cell the search came in through, -1 for the camera's cell */
+    int entry;
+    
+    /* every direction stepped so far */
+    int directions;
+} VisibilityNode_t;
+
+typedef struct
+{
+    int x;
+    int y;
+    int z;
+    unsigned int frame;
+} VisibilityCell_t;
+
+/* only used on the main thread, so the buffers are reused between frames.
+ entries stamped with an older frame are treated as empty, so nothing is cleared per frame */
+static unsigned int _frame;
+
+/* open addressed set of the cells the search has reached, chunks and empty cells alike */
+static VisibilityCell_t* _visited;
+static int _visitedCapacity;
+static int _visitedCount;
+
+/* frame each chunk was last found in the frustum, indexed like world->chunks */
+static unsigned int* _chunkFrames;
+static int _chunkFrameCapacity;
+
+static VisibilityNode_t* _queue;
+static int _queueCapacity;
+
+static int _Visibility_ChunkCoord(float value)
+{
+    return (int)floorf(value / CHUNK_SIZE);
+}
+
+static inline int _Visibility_Slot(int x, int y, int z)
+{
+    unsigned int h = ((unsigned int)x * 73856093u) ^ ((unsigned int)y * 19349663u) ^ ((unsigned int)z * 83492791u);
+    return h & (_visitedCapacity - 1);
+}
+
+static int _Visibility_Visited(int x, int y, int z)
+{
+    int slot = _Visibility_Slot(x, y, z);
+    
+    while (_visited[slot].frame == _frame)
+    {
+        const VisibilityCell_t* cell = _visited + slot;
+        if (cell->x == x && cell->y == y && cell->z == z) return 1;
+        
+        slot = (slot + 1) & (_visitedCapacity - 1);
+    }
+    
+    return 0;
+}
+
+static void _Visibility_Grow(void)
+{
+    VisibilityCell_t* old = _visited;
+    int oldCapacity = _visitedCapacity;
+    
+    _visitedCapacity = oldCapacity ? oldCapacity * 2 : 1024;
+    _visited = calloc(_visitedCapacity, sizeof(VisibilityCell_t));
+    assert(_visited);
+    
+    int i;
+    for (i = 0; i < oldCapacity; ++i)
+    {
+        if (old[i].frame != _frame) continue;
+        
+        int slot = _Visibility_Slot(old[i].x, old[i].y, old[i].z);
+        while (_visited[slot].frame == _frame) slot = (slot + 1) & (_visitedCapacity - 1);
+        
+        _visited[slot] = old[i];
+    }
+    
+    free(old);
+}
+
+/* returns 0 if the cell was already visited this frame */
+static int _Visibility_Visit(int x, int y, int z)
+{
+    /* kept at most half full so probes stay short */
+    if ((_visitedCount + 1) * 2 > _visitedCapacity) _Visibility_Grow();
+    
+    int slot = _Visibility_Slot(x, y, z);
+    
+    while (_visited[slot].frame == _frame)
+    {
+        const VisibilityCell_t* cell = _visited + slot;
+        if (cell->x == x && cell->y == y && cell->z == z) return 0;
+        
+        slot = (slot + 1) & (_visitedCapacity - 1);
+    }
+    
+    VisibilityCell_t* cell = _visited + slot;
+    cell->x = x;
+    cell->y = y;
+    cell->z = z;
+    cell->frame = _frame;
+    ++_visitedCount;
+    
+    return 1;
+}
+
+static void _Visibility_Push(const VisibilityNode_t* node, int* tail)
+{
+    if (*tail == _queueCapacity)
+    {
+        _queueCapacity = _queueCapacity ? _queueCapacity * 2 : 1024;
+        _queue = realloc(_queue, sizeof(VisibilityNode_t) * _queueCapacity);
+        assert(_queue);
+    }
+    
+    _queue[(*tail)++] = *node;
+}
+
+void Visibility_Update(World_t* world, const Cam_t* cam)
+{
+    CullStats_t* stats = &world->cullStats;
+    stats->drawn = 0;
+    stats->frustumCulled = 0;
+    stats->occlusionCulled = 0;
+    stats->depthCulled = 0;
+    
+    /* a wrapped frame counter would match stale entries */
+    if (++_frame == 0)
+    {
+        if (_visited) memset(_visited, 0, sizeof(VisibilityCell_t) * _visitedCapacity);
+        if (_chunkFrames) memset(_chunkFrames, 0, sizeof(unsigned int) * _chunkFrameCapacity);
+        _frame = 1;
+    }
+    _visitedCount = 0;
+    
+    if (world->chunkCount > _chunkFrameCapacity)
+    {
+        _chunkFrames = realloc(_chunkFrames, sizeof(unsigned int) * world->chunkCount);
+        assert(_chunkFrames);
+        
+        memset(_chunkFrames + _chunkFrameCapacity, 0, sizeof(unsigned int) * (world->chunkCount - _chunkFrameCapacity));
+        _chunkFrameCapacity = world->chunkCount;
+    }
+    
+    /* whole regions of chunks are accepted or rejected at once */
+    int inView = Octree_CullFrustum(&world->chunkTree, cam, world->visibleChunks);
+    
+    stats->frustumCulled = world->chunkCount - inView;
+    
+    int camX = _Visibility_ChunkCoord(cam->position.x);
+    int camY = _Visibility_ChunkCoord(cam->position.y);
+    int camZ = _Visibility_ChunkCoord(cam->position.z);
+    
+    /* the search never turns back, so every path stays inside the box around
+     the camera and the chunks in view. cells in it with no chunk are open air
+     so the search can cross the sky to reach the ground */
+    int min[3] = {camX, camY, camZ};
+    int max[3] = {camX, camY, camZ};
+    
+    int i;
+    for (i = 0; i < inView; ++i)
+    {
+        const Chunk_t* chunk = world->chunks + world->visibleChunks[i];
+        int coords[3] = {chunk->x, chunk->y, chunk->z};
+        
+        _chunkFrames[world->visibleChunks[i]] = _frame;
+        
+        int axis;
+        for (axis = 0; axis < 3; ++axis)
+        {
+            if (coords[axis] < min[axis]) min[axis] = coords[axis];
+            if (coords[axis] > max[axis]) max[axis] = coords[axis];
+        }
+    }
+    
+    int head = 0;
+    int tail = 0;
+    
+    VisibilityNode_t start;
+    start.x = camX;
+    start.y = camY;
+    start.z = camZ;
+    start.chunk = Octree_Find(&world->chunkTree, camX, camY, camZ);
+    start.entry = -1;
+    start.directions = 0;
+    
+    _Visibility_Visit(camX, camY, camZ);
+    _Visibility_Push(&start, &tail);
+    
+    while (head < tail)
+    {
+        VisibilityNode_t node = _queue[head++];
+        
+        const Chunk_t* chunk = (node.chunk >= 0) ? world->chunks + node.chunk : NULL;
+        
+        int f;
+        for (f = 0; f < CHUNK_FACE_COUNT; ++f)
+        {
+            int opposite = f ^ 1;
+            
+            /* going back toward the camera can only see what was already seen */
+            if (node.directions & (1 << opposite)) continue;
+            
+            /* must be able to see from where the search came in to where it goes out */
+            if (chunk && node.entry >= 0 && !(chunk->faceLinks[node.entry] & (1 << f))) continue;
+            
+            int coords[3] = {node.x + FaceSteps[f][0], node.y + FaceSteps[f][1], node.z + FaceSteps[f][2]};
+            
+            int axis = f / 2;
+            if (coords[axis] < min[axis] || coords[axis] > max[axis]) continue;
+            
+            if (_Visibility_Visited(coords[0], coords[1], coords[2])) continue;
+            
+            /* no point searching through cells the camera isn't looking at.
+             loaded chunks were already tested, empty cells are tested as they're reached */
+            int next = Octree_Find(&world->chunkTree, coords[0], coords[1], coords[2]);
+            
+            if (next >= 0)
+            {
+                if (_chunkFrames[next] != _frame) continue;
+            }
+            else
+            {
+                Vec3_t position = Vec3_Create(coords[0] * CHUNK_SIZE, coords[1] * CHUNK_SIZE, coords[2] * CHUNK_SIZE);
+                
+                Vec3_t center = Vec3_Add(position, Vec3_Create(CHUNK_SIZE / 2, CHUNK_SIZE / 2, CHUNK_SIZE / 2));
+                if (!Cam_CubeVisible(cam, center, CHUNK_SIZE / 2)) continue;
+            }
+            
+            _Visibility_Visit(coords[0], coords[1], coords[2]);
+            
+            VisibilityNode_t child;
+            child.x = coords[0];
+            child.y = coords[1];
+            child.z = coords[2];
+            child.chunk = next;
+            child.entry = opposite;
+            child.directions = node.directions | (1 << f);
+            _Visibility_Push(&child, &tail);
+        }
+    }
+    
+    /* keep the chunks in view that the search reached */
+    int count = 0;
+    for (i = 0; i < inView; ++i)
+    {
+        int index = world->visibleChunks[i];
+        const Chunk_t* chunk = world->chunks + index;
+        
+        if (_Visibility_Visited(chunk->x, chunk->y, chunk->z))
+        {
+            world->visibleChunks[count++] = index;
+        }
+    }
+    
+    world->visibleCount = count;
+    stats->drawn = count;
+    stats->occlusionCulled = inView - count;
+    
+    /* the graph only knows about whole chunks of ground, this catches chunks behind hills */
+    Occlusion_CullChunks(world, cam);
+}
@@ -0,0 +1,36 @@
+
+#ifndef ccraft_visibility_h
+#define ccraft_visibility_h
+
+#include "cam.h"
+#include "world.h"
+
+/* chunk level occlusion culling.
+ each chunk records which of its faces can see each other through air and see through blocks.
+ every frame a breadth first search walks out from the camera's chunk,
+ only passing through a chunk between faces that are linked and never turning back
+ toward the camera. chunks it can't reach are hidden behind solid ground */
+
+/* faces of a chunk, opposite faces differ in the lowest bit */
+enum
+{
+    CHUNK_FACE_NEG_X = 0,
+    CHUNK_FACE_POS_X,
+    CHUNK_FACE_NEG_Y,
+    CHUNK_FACE_POS_Y,
+    CHUNK_FACE_NEG_Z,
+    CHUNK_FACE_POS_Z,
+    CHUNK_FACE_COUNT
+};
+
+#define CHUNK_FACES_ALL ((1 << CHUNK_FACE_COUNT) - 1)
+
+/* floods the air in a chunk to fill in faceLinks - safe to call from jobs */
+extern void Visibility_LinkChunk(Chunk_t* chunk);
+
+/* fills in world->visibleChunks and world->cullStats.
+ chunks are frustum culled through world->chunkTree, then searched, then the software depth test
+ in occlusion.h runs on whatever is left */
+extern void Visibility_Update(World_t* world, const Cam_t* cam);
+
+#endif
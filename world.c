@@ -1,7 +1,11 @@
 
 #include "world.h"
 #include <stdlib.h>
+#include <float.h>
 #include "endian.h"
+#include "job.h"
+#include "light.h"
+#include "visibility.h"
 
 void Block_Init(Block_t* block)
 {
@@ -14,9 +18,17 @@ void Chunk_Init(Chunk_t* chunk, short cx, short cy, short cz)
     chunk->y = cy;
     chunk->z = cz;
     
-    chunk->cacheSize = 0;
+    chunk->mesh = NULL;
+    chunk->lod = 0;
+    
+    chunk->translucentOrder.mesh = NULL;
+    chunk->translucentOrder.order = NULL;
+    chunk->translucentOrder.indices = NULL;
+    chunk->translucentOrder.capacity = 0;
     
     chunk->saveDirty = 0;
+    chunk->revision = 1;
+    chunk->digestRevision = 0;
     
     chunk->blockEntityCount = 0;
     chunk->needsToUnload = 0;
@@ -59,46 +71,109 @@ void Chunk_Init(Chunk_t* chunk, short cx, short cy, short cz)
     Chunk_Dirty(chunk);
 }
 
-void Chunk_Dirty(Chunk_t* chunk)
+static int _Chunk_SectionOf(int block)
 {
-    chunk->dirtyCache = 1;
-    chunk->saveDirty = 1;
+    if (block < 0) return 0;
+    if (block >= CHUNK_SIZE) return CHUNK_SECTIONS_PER_SIDE - 1;
+    return block / CHUNK_SECTION_SIZE;
 }
 
-void Entity_Init(Entity_t* entity)
+void Chunk_DirtySections(Chunk_t* chunk, int minX, int minY, int minZ, int maxX, int maxY, int maxZ)
 {
-    entity->entityID = -1;
-    entity->position = Vec3_Zero();
-    entity->velocity = Vec3_Zero();
+    if (maxX < 0 || maxY < 0 || maxZ < 0) return;
+    if (minX >= CHUNK_SIZE || minY >= CHUNK_SIZE || minZ >= CHUNK_SIZE) return;
+    
+    int sx, sy, sz;
+    for (sx = _Chunk_SectionOf(minX); sx <= _Chunk_SectionOf(maxX); ++sx)
+    {
+        for (sy = _Chunk_SectionOf(minY); sy <= _Chunk_SectionOf(maxY); ++sy)
+        {
+            for (sz = _Chunk_SectionOf(minZ); sz <= _Chunk_SectionOf(maxZ); ++sz)
+            {
+                chunk->dirtySections |= (uint64_t)1 << CHUNK_SECTION_INDEX(sx, sy, sz);
+            }
+        }
+    }
 }
 
-void World_Init(World_t* world)
+void Chunk_BlocksChanged(Chunk_t* chunk)
 {
-    world->chunkCount = 0;
-    world->entityCounter = 0;
+    chunk->saveDirty = 1;
     
+    /* can't be sure what's hidden behind the chunk until it's remeshed */
     int i;
-    for (i = 0; i < MAX_ENTITIES; i ++)
+    for (i = 0; i < CHUNK_FACE_COUNT; ++i)
     {
-        Entity_Init(world->entities + i);
+        chunk->faceLinks[i] = CHUNK_FACES_ALL;
     }
     
-    world->chunks = NULL;
-}
-
-static Chunk_t* _World_AddChunk(World_t* world, int x, int y, int z)
-{
-    if (!world->chunks)
+    /* and it can't hide anything else */
+    for (i = 0; i < 3; ++i)
     {
-        world->chunks = malloc(sizeof(Chunk_t));
+        chunk->solidLayers[i][0] = -1;
+        chunk->solidLayers[i][1] = -1;
     }
-    else
+    
+    const Block_t* blocks = &chunk->blocks[0][0][0];
+    
+    int count = 0;
+    int opaque = 0;
+    for (i = 0; i < CHUNK_SIZE * CHUNK_SIZE * CHUNK_SIZE; ++i)
     {
-        world->chunks = realloc(world->chunks, sizeof(Chunk_t) * (world->chunkCount + 1));
+        count += (blocks[i].type != BLOCK_AIR);
+        opaque += Block_Opaque(blocks[i].type);
     }
+    chunk->blockCount = count;
+    chunk->opaqueCount = opaque;
+}
+
+void Chunk_Dirty(Chunk_t* chunk)
+{
+    Chunk_BlocksChanged(chunk);
+    chunk->dirtySections = CHUNK_SECTIONS_ALL;
+}
+
+void World_Init(World_t* world)
+{
+    world->chunkCount = 0;
+    
+    EntityStore_Init(&world->entities, MAX_ENTITIES);
+    
+    world->chunks = NULL;
+    
+    Octree_Init(&world->chunkTree, CHUNK_SIZE);
+    
+    world->visibleChunks = NULL;
+    world->visibleCount = 0;
+    
+    world->translucentChunks = NULL;
+    world->translucentCount = 0;
+    
+    world->changes = NULL;
+    world->changeCount = 0;
+    world->changeCapacity = 0;
+    world->recordChanges = 0;
+}
+
+/* grows the chunk array and everything indexed alongside it */
+static void _World_ReserveChunks(World_t* world, int capacity)
+{
+    world->chunks = realloc(world->chunks, sizeof(Chunk_t) * capacity);
     assert(world->chunks);
     
+    world->visibleChunks = realloc(world->visibleChunks, sizeof(int) * capacity);
+    assert(world->visibleChunks);
+    
+    world->translucentChunks = realloc(world->translucentChunks, sizeof(int) * capacity);
+    assert(world->translucentChunks);
+}
+
+static Chunk_t* _World_AddChunk(World_t* world, int x, int y, int z)
+{
+    _World_ReserveChunks(world, world->chunkCount + 1);
+    
     Chunk_Init(world->chunks + world->chunkCount, x, y, z);
+    Octree_Insert(&world->chunkTree, x, y, z, world->chunkCount);
     world->chunkCount++;
     
     return &world->chunks[world->chunkCount - 1];
@@ -109,66 +184,136 @@ static void _World_GenChunk(World_t* world, Chunk_t* chunk)
     Chunk_Init(chunk, chunk->x, chunk->y, chunk->z);
 }
 
-Block_t* World_GetBlockAt( World_t* world, int x, int y, int z)
+Chunk_t* World_GetChunk(World_t* world, int ix, int iy, int iz)
 {
-    int ix = x / CHUNK_SIZE;
-    int iy = y / CHUNK_SIZE;
-    int iz = z / CHUNK_SIZE;
+    int index = Octree_Find(&world->chunkTree, ix, iy, iz);
+    return (index >= 0) ? world->chunks + index : NULL;
+}
+
+Block_t* World_GetBlockAt(World_t* world, int x, int y, int z)
+{
+    /* chunks only exist at positive coordinates */
+    if (x < 0 || y < 0 || z < 0) return NULL;
     
-    int i;
-    for (i = 0; i < world->chunkCount; i ++)
+    Chunk_t* chunk = World_GetChunk(world, x / CHUNK_SIZE, y / CHUNK_SIZE, z / CHUNK_SIZE);
+    
+    if (!chunk) return NULL;
+    
+    return &chunk->blocks[x % CHUNK_SIZE][y % CHUNK_SIZE][z % CHUNK_SIZE];
+}
+
+/* meshes look one block past their edges for occlusion,
+ so every section overlapping this block range in any chunk needs rebuilding */
+static void _World_RemeshRange(World_t* world, int minX, int minY, int minZ, int maxX, int maxY, int maxZ)
+{
+    if (maxX < 0 || maxY < 0 || maxZ < 0) return;
+    
+    int x, y, z;
+    for (x = (minX < 0 ? 0 : minX / CHUNK_SIZE); x <= maxX / CHUNK_SIZE; ++x)
     {
-        if (world->chunks[i].x == ix &&
-            world->chunks[i].y == iy &&
-            world->chunks[i].z == iz)
+        for (y = (minY < 0 ? 0 : minY / CHUNK_SIZE); y <= maxY / CHUNK_SIZE; ++y)
         {
-            int bx = x % CHUNK_SIZE;
-            int by = y % CHUNK_SIZE;
-            int bz = z % CHUNK_SIZE;
-            
-            return &world->chunks[i].blocks[bx][by][bz];
+            for (z = (minZ < 0 ? 0 : minZ / CHUNK_SIZE); z <= maxZ / CHUNK_SIZE; ++z)
+            {
+                Chunk_t* chunk = World_GetChunk(world, x, y, z);
+                
+                if (chunk)
+                {
+                    int originX = x * CHUNK_SIZE;
+                    int originY = y * CHUNK_SIZE;
+                    int originZ = z * CHUNK_SIZE;
+                    
+                    Chunk_DirtySections(chunk,
+                                        minX - originX, minY - originY, minZ - originZ,
+                                        maxX - originX, maxY - originY, maxZ - originZ);
+                }
+            }
         }
     }
-    
-    return NULL;
 }
 
 void World_UpdateBlockAt(World_t* world, int x, int y, int z)
 {
-    int ix = x / CHUNK_SIZE;
-    int iy = y / CHUNK_SIZE;
-    int iz = z / CHUNK_SIZE;
+    if (x < 0 || y < 0 || z < 0) return;
     
-    int i;
-    for (i = 0; i < world->chunkCount; i ++)
+    Chunk_t* chunk = World_GetChunk(world, x / CHUNK_SIZE, y / CHUNK_SIZE, z / CHUNK_SIZE);
+    
+    if (chunk)
     {
-        if (world->chunks[i].x == ix &&
-            world->chunks[i].y == iy &&
-            world->chunks[i].z == iz)
+        chunk->revision++;
+        
+        if (world->recordChanges)
         {
-            Chunk_Dirty(&world->chunks[i]);
+            if (world->changeCount == world->changeCapacity)
+            {
+                world->changeCapacity = world->changeCapacity ? world->changeCapacity * 2 : 64;
+                world->changes = realloc(world->changes, sizeof(BlockChange_t) * world->changeCapacity);
+                assert(world->changes);
+            }
+            
+            int lx = x % CHUNK_SIZE;
+            int ly = y % CHUNK_SIZE;
+            int lz = z % CHUNK_SIZE;
+            
+            BlockChange_t* change = world->changes + world->changeCount++;
+            change->chunk = (int)(chunk - world->chunks);
+            change->revision = chunk->revision;
+            change->index = (lx * CHUNK_SIZE + ly) * CHUNK_SIZE + lz;
+            change->type = chunk->blocks[lx][ly][lz].type;
         }
+        
+        Chunk_BlocksChanged(chunk);
+        Light_UpdateBlock(world, x, y, z);
+        _World_RemeshRange(world, x - 1, y - 1, z - 1, x + 1, y + 1, z + 1);
     }
 }
 
 
+static void _World_PrepareJob(void* data, int begin, int end);
+
 void World_PrepareChunk(World_t* world, int ix, int iy, int iz)
 {
+    int coords[3] = {ix, iy, iz};
+    World_PrepareChunks(world, coords, 1);
+}
+
+void World_PrepareChunks(World_t* world, const int* coords, int count)
+{
+    if (count <= 0) return;
+    
+    /* grow once so chunks don't move while jobs fill them in */
+    _World_ReserveChunks(world, world->chunkCount + count);
+    
+    int first = world->chunkCount;
     
     int i;
-    for (i = 0; i < world->chunkCount; i ++)
+    for (i = 0; i < count; ++i)
     {
-        if (world->chunks[i].x == ix &&
-            world->chunks[i].y == iy &&
-            world->chunks[i].z == iz)
-        {
-            return;
-        }
+        const int* c = coords + i * 3;
+        
+        /* also catches duplicates added earlier in this loop */
+        if (World_GetChunk(world, c[0], c[1], c[2])) continue;
+        
+        Chunk_t* chunk = world->chunks + world->chunkCount;
+        chunk->x = c[0];
+        chunk->y = c[1];
+        chunk->z = c[2];
+        Octree_Insert(&world->chunkTree, c[0], c[1], c[2], world->chunkCount);
+        world->chunkCount++;
     }
     
-    if (!World_LoadChunk(world, ix, iy, iz))
+    Job_ParallelFor(_World_PrepareJob, world->chunks + first, world->chunkCount - first, 1);
+    
+    /* lighting reaches into neighbors so it runs once all new chunks are in place */
+    for (i = first; i < world->chunkCount; ++i)
     {
-        _World_AddChunk(world, ix, iy, iz);
+        Chunk_t* chunk = world->chunks + i;
+        Light_InitChunk(world, chunk);
+        
+        int x = chunk->x * CHUNK_SIZE;
+        int y = chunk->y * CHUNK_SIZE;
+        int z = chunk->z * CHUNK_SIZE;
+        _World_RemeshRange(world, x - 1, y - 1, z - 1, x + CHUNK_SIZE, y + CHUNK_SIZE, z + CHUNK_SIZE);
     }
 }
 
@@ -193,14 +338,157 @@ void World_UnloadChunk(World_t* world, int ix, int iy, int iz)
 }
 
 
-Entity_t* World_SpawnEntity(World_t* world, int type)
+int World_SpawnEntity(World_t* world, int type)
+{
+    return EntityStore_Spawn(&world->entities, type);
+}
+
+static inline float _Raycast_Boundary(float origin, int cell, int step, float delta)
+{
+    if (step > 0) return ((float)(cell + 1) - origin) * delta;
+    if (step < 0) return (origin - (float)cell) * delta;
+    return FLT_MAX;
+}
+
+/* boundaries the ray crosses on one axis on its way out of the chunk it is in.
+ the axis it leaves through crosses all of them, the others stop short of the chunk's far side */
+static inline void _Raycast_SkipAxis(int* cell, float* max, int step, float delta, int chunkCoord, float exitT, int leaves)
 {
-    Entity_t* entity = world->entities + world->entityCounter;
-    entity->type = type;
-    entity->entityID = world->entityCounter;
+    if (!step) return;
+    
+    int remaining = step > 0 ? (chunkCoord + 1) * CHUNK_SIZE - *cell : *cell - chunkCoord * CHUNK_SIZE + 1;
+    
+    int crossed = remaining;
+    if (!leaves)
+    {
+        crossed = *max < exitT ? (int)((exitT - *max) / delta) + 1 : 0;
+        if (crossed > remaining - 1) crossed = remaining - 1;
+    }
+    
+    *cell += crossed * step;
+    *max += crossed * delta;
+}
+
+static inline float _Raycast_ChunkExit(int cell, float max, int step, float delta, int chunkCoord)
+{
+    if (!step) return FLT_MAX;
+    
+    int remaining = step > 0 ? (chunkCoord + 1) * CHUNK_SIZE - cell : cell - chunkCoord * CHUNK_SIZE + 1;
+    return max + (float)(remaining - 1) * delta;
+}
+
+int World_Raycast(World_t* world, Vec3_t origin, Vec3_t direction, float maxDist, RayHit_t* hit)
+{
+    assert(hit);
+    
+    float length = Vec3_Length(direction);
+    if (length <= 0.0f) return 0;
+    
+    /* normalized so t is a distance */
+    direction = Vec3_Scale(direction, 1.0f / length);
+    
+    int x = floorf(origin.x);
+    int y = floorf(origin.y);
+    int z = floorf(origin.z);
+    
+    int stepX = (direction.x > 0.0f) - (direction.x < 0.0f);
+    int stepY = (direction.y > 0.0f) - (direction.y < 0.0f);
+    int stepZ = (direction.z > 0.0f) - (direction.z < 0.0f);
+    
+    float deltaX = stepX ? fabsf(1.0f / direction.x) : FLT_MAX;
+    float deltaY = stepY ? fabsf(1.0f / direction.y) : FLT_MAX;
+    float deltaZ = stepZ ? fabsf(1.0f / direction.z) : FLT_MAX;
+    
+    float maxX = _Raycast_Boundary(origin.x, x, stepX, deltaX);
+    float maxY = _Raycast_Boundary(origin.y, y, stepY, deltaY);
+    float maxZ = _Raycast_Boundary(origin.z, z, stepZ, deltaZ);
+    
+    int nx = 0, ny = 0, nz = 0;
+    float t = 0.0f;
+    
+    /* the chunk is only looked up again when the ray crosses into a new one */
+    Chunk_t* chunk = NULL;
+    int cx = 0, cy = 0, cz = 0;
+    int haveChunk = 0;
+    
+    while (t <= maxDist)
+    {
+        if (x >= 0 && y >= 0 && z >= 0)
+        {
+            int ix = x / CHUNK_SIZE;
+            int iy = y / CHUNK_SIZE;
+            int iz = z / CHUNK_SIZE;
+            
+            if (!haveChunk || ix != cx || iy != cy || iz != cz)
+            {
+                chunk = World_GetChunk(world, ix, iy, iz);
+                cx = ix;
+                cy = iy;
+                cz = iz;
+                haveChunk = 1;
+            }
+            
+            /* empty and missing chunks are crossed in one step, to the face the ray leaves through */
+            if (!chunk || chunk->blockCount == 0)
+            {
+                float exitX = _Raycast_ChunkExit(x, maxX, stepX, deltaX, cx);
+                float exitY = _Raycast_ChunkExit(y, maxY, stepY, deltaY, cy);
+                float exitZ = _Raycast_ChunkExit(z, maxZ, stepZ, deltaZ, cz);
+                
+                /* ties go the way single steps would take them */
+                int axis = (exitX < exitY && exitX < exitZ) ? 0 : (exitY < exitZ ? 1 : 2);
+                t = axis == 0 ? exitX : (axis == 1 ? exitY : exitZ);
+                
+                _Raycast_SkipAxis(&x, &maxX, stepX, deltaX, cx, t, axis == 0);
+                _Raycast_SkipAxis(&y, &maxY, stepY, deltaY, cy, t, axis == 1);
+                _Raycast_SkipAxis(&z, &maxZ, stepZ, deltaZ, cz, t, axis == 2);
+                
+                nx = axis == 0 ? -stepX : 0;
+                ny = axis == 1 ? -stepY : 0;
+                nz = axis == 2 ? -stepZ : 0;
+                continue;
+            }
+            
+            Block_t* block = &chunk->blocks[x % CHUNK_SIZE][y % CHUNK_SIZE][z % CHUNK_SIZE];
+            
+            if (block->type != BLOCK_AIR)
+            {
+                hit->x = x;
+                hit->y = y;
+                hit->z = z;
+                hit->nx = nx;
+                hit->ny = ny;
+                hit->nz = nz;
+                hit->distance = t;
+                hit->block = block;
+                return 1;
+            }
+        }
+        
+        if (maxX < maxY && maxX < maxZ)
+        {
+            x += stepX;
+            t = maxX;
+            maxX += deltaX;
+            nx = -stepX; ny = 0; nz = 0;
+        }
+        else if (maxY < maxZ)
+        {
+            y += stepY;
+            t = maxY;
+            maxY += deltaY;
+            nx = 0; ny = -stepY; nz = 0;
+        }
+        else
+        {
+            z += stepZ;
+            t = maxZ;
+            maxZ += deltaZ;
+            nx = 0; ny = 0; nz = -stepZ;
+        }
+    }
     
-    ++world->entityCounter;
-    return entity;
+    return 0;
 }
 
 #define WORLD_STREAM_VERSION 1
@@ -249,7 +537,7 @@ void World_SaveChunk(World_t* world, Chunk_t* chunk)
     fclose(file);
 }
 
-int World_LoadChunk(World_t* world, int ix, int iy, int iz)
+static FILE* _World_OpenChunkFile(int ix, int iy, int iz)
 {
     char filename[1024];
     sprintf(filename, "save/%i_%i_%i.chunk\n", ix, iy, iz);
@@ -258,7 +546,7 @@ int World_LoadChunk(World_t* world, int ix, int iy, int iz)
     
     if (!file)
     {
-        return 0;
+        return NULL;
     }
     
     int32_t version;
@@ -266,9 +554,11 @@ int World_LoadChunk(World_t* world, int ix, int iy, int iz)
     fread(&version, sizeof(int32_t), 1, file);
     
     assert(End_I32FromLittle(&version) == WORLD_STREAM_VERSION);
-    
-    Chunk_t* newChunk = _World_AddChunk(world, ix, iy, iz);
-    
+    return file;
+}
+
+static void _World_ReadChunk(FILE* file, Chunk_t* chunk)
+{
     int x,y,z;
     for (x = 0; x < CHUNK_SIZE; ++x)
     {
@@ -276,17 +566,53 @@ int World_LoadChunk(World_t* world, int ix, int iy, int iz)
         {
             for (z = 0; z < CHUNK_SIZE; ++z)
             {
-                Block_t* block = &newChunk->blocks[x][y][z];
+                Block_t* block = &chunk->blocks[x][y][z];
                 fread(&block->type, sizeof(char), block->type, file);
             }
         }
     }
     fclose(file);
     
-    Chunk_Dirty(newChunk);
-    newChunk->saveDirty = 0;
-    
-    return 1;
+    Chunk_Dirty(chunk);
+    chunk->saveDirty = 0;
 }
 
+/* runs on job workers - each chunk is generated then overwritten by its save file if there is one */
+static void _World_PrepareJob(void* data, int begin, int end)
+{
+    Chunk_t* chunks = data;
+    
+    int i;
+    for (i = begin; i < end; ++i)
+    {
+        Chunk_t* chunk = chunks + i;
+        Chunk_Init(chunk, chunk->x, chunk->y, chunk->z);
+        
+        FILE* file = _World_OpenChunkFile(chunk->x, chunk->y, chunk->z);
+        if (file)
+        {
+            _World_ReadChunk(file, chunk);
+        }
+    }
+}
 
+int World_LoadChunk(World_t* world, int ix, int iy, int iz)
+{
+    FILE* file = _World_OpenChunkFile(ix, iy, iz);
+    
+    if (!file)
+    {
+        return 0;
+    }
+    
+    Chunk_t* newChunk = _World_AddChunk(world, ix, iy, iz);
+    _World_ReadChunk(file, newChunk);
+    Light_InitChunk(world, newChunk);
+    
+    int x = ix * CHUNK_SIZE;
+    int y = iy * CHUNK_SIZE;
+    int z = iz * CHUNK_SIZE;
+    _World_RemeshRange(world, x - 1, y - 1, z - 1, x + CHUNK_SIZE, y + CHUNK_SIZE, z + CHUNK_SIZE);
+    
+    return 1;
+}
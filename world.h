@@ -4,6 +4,9 @@
 
 #include "vec_math.h"
 #include "geo.h"
+#include "entity.h"
+#include "octree.h"
+#include <stdint.h>
 
 enum
 {
@@ -28,6 +31,34 @@ typedef struct
 
 extern void Block_Init(Block_t* block);
 
+/* the pass a block is drawn in. cutout blocks have texels that are either clear or solid
+ and are alpha tested, translucent blocks are blended over everything else back to front */
+enum
+{
+    BLOCK_LAYER_OPAQUE = 0,
+    BLOCK_LAYER_CUTOUT,
+    BLOCK_LAYER_TRANSLUCENT,
+    BLOCK_LAYER_COUNT
+};
+
+/* only meaningful for non air blocks */
+static inline int Block_Layer(int type)
+{
+    switch (type)
+    {
+        case BLOCK_ICE:
+            return BLOCK_LAYER_TRANSLUCENT;
+        default:
+            return BLOCK_LAYER_OPAQUE;
+    }
+}
+
+/* opaque blocks hide the faces behind them, stop light and block sight lines through a chunk */
+static inline int Block_Opaque(int type)
+{
+    return type != BLOCK_AIR && Block_Layer(type) == BLOCK_LAYER_OPAQUE;
+}
+
 enum
 {
     BLOCK_ENTITY_CHEST = 0,
@@ -46,35 +77,26 @@ typedef struct
     void* data;
 } BlockEntity_t;
 
-enum
-{
-    ENTITY_CHEST = 0,
-    ENTITY_STONE,
-    ENTITY_DIRT,
-    ENTITY_TURF,
-    ENTITY_GIFT,
-};
+#define CHUNK_SIZE 16
+#define CHUNK_VOLUME (CHUNK_SIZE * CHUNK_SIZE * CHUNK_SIZE)
 
+/* chunks are remeshed in sections of 4x4x4 blocks, one bit each in dirtySections */
+#define CHUNK_SECTION_SIZE 4
+#define CHUNK_SECTIONS_PER_SIDE (CHUNK_SIZE / CHUNK_SECTION_SIZE)
+#define CHUNK_SECTION_COUNT (CHUNK_SECTIONS_PER_SIDE * CHUNK_SECTIONS_PER_SIDE * CHUNK_SECTIONS_PER_SIDE)
+#define CHUNK_SECTIONS_ALL UINT64_MAX
 
-typedef struct
-{
-    Vec3_t position;
-    Vec3_t velocity;
-    float size;
-    float height;
-    
-    int entityID;
-    int type;
-    int pickupType;
-    int qty;
-    void* data;
-    
-} Entity_t;
+#define CHUNK_SECTION_INDEX(sx, sy, sz) (((sx) * CHUNK_SECTIONS_PER_SIDE + (sy)) * CHUNK_SECTIONS_PER_SIDE + (sz))
 
-extern void Entity_Init(Entity_t* entity);
+/* light channels */
+enum
+{
+    LIGHT_SKY = 0,
+    LIGHT_BLOCK,
+    LIGHT_CHANNELS
+};
 
-
-#define CHUNK_SIZE 16
+#define LIGHT_MAX 15
 
 
 typedef struct
@@ -85,9 +107,11 @@ typedef struct
     
     float u;
     float v;
+    
+    unsigned char color[4];
 } Vert_t;
 
-static inline Vert_t Vert_Create(short x, short y, short z, float u, float v)
+static inline Vert_t Vert_Create(short x, short y, short z, float u, float v, unsigned char shade)
 {
     Vert_t vert;
     vert.x = x;
@@ -95,6 +119,10 @@ static inline Vert_t Vert_Create(short x, short y, short z, float u, float v)
     vert.z = z;
     vert.u = u;
     vert.v = v;
+    vert.color[0] = shade;
+    vert.color[1] = shade;
+    vert.color[2] = shade;
+    vert.color[3] = 255;
     return vert;
 }
 
@@ -103,9 +131,29 @@ typedef struct
     Vert_t verts[4];
 } Face_t;
 
+/* a chunk's translucent faces ordered back to front from the camera (see topology.h) */
+typedef struct
+{
+    /* mesh the order belongs to, NULL when it has to be rebuilt */
+    const struct Mesh* mesh;
+    
+    /* block the camera was in when the faces were last sorted */
+    int cell[3];
+    
+    /* faces as indices into the mesh's translucent layer, farthest first,
+     and the four vertex indices of each in the same order for drawing */
+    unsigned short* order;
+    unsigned short* indices;
+    int capacity;
+} FaceOrder_t;
+
 typedef struct
 {
     Block_t blocks[CHUNK_SIZE][CHUNK_SIZE][CHUNK_SIZE];
+    
+    /* 4 bit light levels per channel, two blocks to a byte */
+    unsigned char light[LIGHT_CHANNELS][CHUNK_VOLUME / 2];
+    
     BlockEntity_t* blockEntities;
     int blockEntityCount;
     
@@ -113,12 +161,37 @@ typedef struct
     int y;
     int z;
     
-    int dirtyCache;
+    /* sections that need remeshing, 0 when the mesh is up to date */
+    uint64_t dirtySections;
     int saveDirty;
     int needsToUnload;
     
-    Face_t cache[8192];
-    int cacheSize;
+    /* counts up every time a block changes so copies elsewhere can tell they're stale */
+    uint32_t revision;
+    
+    /* hash of the blocks at digestRevision, 0 before it's first taken (see digest.h) */
+    uint64_t digest;
+    uint32_t digestRevision;
+    
+    /* number of non air blocks, lets queries skip empty chunks */
+    int blockCount;
+    
+    /* number of opaque blocks, a chunk full of them can't be seen through */
+    int opaqueCount;
+    
+    /* for each face, a bit for every other face reachable without crossing an opaque block (see visibility.h) */
+    unsigned char faceLinks[6];
+    
+    /* first and last of the longest run of fully solid layers along each axis, -1 if there are none (see occlusion.h) */
+    signed char solidLayers[3][2];
+    
+    /* shared with other chunks built from the same blocks, NULL until meshed (see mesh_cache.h) */
+    struct Mesh* mesh;
+    
+    /* level of detail of the mesh, 0 is full resolution (see topology.h) */
+    int lod;
+    
+    FaceOrder_t translucentOrder;
     
     Vec3_t worldPosition;
     Sphere_t boundingSphere;
@@ -126,31 +199,129 @@ typedef struct
 } Chunk_t;
 
 extern void Chunk_Gen(Chunk_t* chunk);
+/* the chunk's blocks changed. updates everything that depends on them,
+ callers mark the sections that need remeshing */
+extern void Chunk_BlocksChanged(Chunk_t* chunk);
+
+/* blocks changed and the whole chunk needs remeshing */
 extern void Chunk_Dirty(Chunk_t* chunk);
 
+/* marks the sections overlapping a box of blocks in the chunk, both corners included.
+ the box may reach outside the chunk */
+extern void Chunk_DirtySections(Chunk_t* chunk, int minX, int minY, int minZ, int maxX, int maxY, int maxZ);
+
+/* light is indexed the same way as blocks */
+static inline int Chunk_GetLight(const Chunk_t* chunk, int channel, int x, int y, int z)
+{
+    int i = (x * CHUNK_SIZE + y) * CHUNK_SIZE + z;
+    unsigned char pair = chunk->light[channel][i >> 1];
+    return (i & 1) ? (pair >> 4) : (pair & 0x0F);
+}
+
+static inline void Chunk_SetLight(Chunk_t* chunk, int channel, int x, int y, int z, int level)
+{
+    int i = (x * CHUNK_SIZE + y) * CHUNK_SIZE + z;
+    unsigned char* pair = &chunk->light[channel][i >> 1];
+    
+    if (i & 1)
+    {
+        *pair = (*pair & 0x0F) | (level << 4);
+    }
+    else
+    {
+        *pair = (*pair & 0xF0) | level;
+    }
+}
+
 
 #define MAX_ENTITIES 1024
 
+/* a block changed by World_UpdateBlockAt */
+typedef struct
+{
+    int chunk;
+    
+    /* the chunk's revision after the change */
+    uint32_t revision;
+    
+    /* block within the chunk, indexed like light */
+    unsigned short index;
+    char type;
+} BlockChange_t;
+
+/* chunk culling results from the last visibility update */
+typedef struct
+{
+    int drawn;
+    int frustumCulled;
+    int occlusionCulled;
+    int depthCulled;
+} CullStats_t;
+
 typedef struct
 {
     Chunk_t* chunks;
     
-    Entity_t entities[MAX_ENTITIES];
-    int entityCounter;
+    /* every loaded chunk by its coordinates, values are indices into chunks */
+    Octree_t chunkTree;
+    
+    /* chunks to mesh and draw this frame, filled in by Visibility_Update */
+    int* visibleChunks;
+    int visibleCount;
+    
+    /* visible chunks with translucent faces, farthest first, filled in by Topologize_SortTranslucent */
+    int* translucentChunks;
+    int translucentCount;
+    
+    EntityStore_t entities;
+    
+    /* block changes in the order they happened, only kept while recordChanges is set.
+     whoever reads them clears changeCount */
+    BlockChange_t* changes;
+    int changeCount;
+    int changeCapacity;
+    int recordChanges;
+    
+    CullStats_t cullStats;
     
     int chunkCount;
     int seed;
     
 } World_t;
 
+/* result of a voxel raycast */
+typedef struct
+{
+    int x;
+    int y;
+    int z;
+    
+    /* normal of the face the ray entered through - zero if the ray started inside the block */
+    int nx;
+    int ny;
+    int nz;
+    
+    float distance;
+    Block_t* block;
+} RayHit_t;
+
 extern void World_Init(World_t* world);
+extern Chunk_t* World_GetChunk(World_t* world, int ix, int iy, int iz);
 extern Block_t* World_GetBlockAt(World_t* world, int x, int y, int z);
 extern void World_UpdateBlockAt(World_t* world, int x, int y, int z);
 
 extern void World_PrepareChunk(World_t* world, int x, int y, int z);
+
+/* loads or generates every missing chunk in a list of x, y, z triples on the job system */
+extern void World_PrepareChunks(World_t* world, const int* coords, int count);
 extern void World_UnloadChunk(World_t* world, int x, int y, int z);
 
-extern Entity_t* World_SpawnEntity(World_t* world, int type);
+/* returns the new entity's id or -1 if there is no room */
+extern int World_SpawnEntity(World_t* world, int type);
+
+/* Amanatides-Woo voxel traversal - finds the first non air block within maxDist.
+ does not modify the world so it can be used for any number of rays per tick */
+extern int World_Raycast(World_t* world, Vec3_t origin, Vec3_t direction, float maxDist, RayHit_t* hit);
 
 extern void World_Save(World_t* world);
 